@@ -36,6 +36,7 @@
 #include <string.h>
 #include <gst/audio/audio.h>
 
+#include "libgstbuzztrax/denormal.h"
 #include "libgstbuzztrax/tempo.h"
 
 #include "audiosynth.h"
@@ -400,10 +401,13 @@ gstbt_audio_synth_create (GstBaseSrc * basesrc, guint64 offset,
   src->n_samples = n_samples;
 
   if (gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
+    guint fpu_state = gstbt_denormal_enter ();
+
     if (!klass->process (src, buf, &info)) {
       memset (info.data, 0, info.size);
       GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_GAP);
     }
+    gstbt_denormal_leave (fpu_state);
     gst_buffer_unmap (buf, &info);
   } else {
     GST_WARNING_OBJECT (src, "unable to map buffer for write");
@@ -22,7 +22,11 @@
  * @include: libgstbuzztrax/delay.h
  * @short_description: delay line class
  *
- * A delay line. 
+ * A delay line. The ring-buffer has a power of 2 size, so that the positions
+ * can wrap around by masking. Besides reading whole samples, the
+ * GSTBT_DELAY_READ_LINEAR(), GSTBT_DELAY_READ_ALLPASS() and
+ * GSTBT_DELAY_READ_CUBIC() macros read at fractional positions for modulated
+ * delays.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -48,6 +52,26 @@ enum
 
 G_DEFINE_TYPE (GstBtDelay, gstbt_delay, G_TYPE_OBJECT);
 
+//-- enums
+
+GType
+gstbt_delay_interpolation_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_DELAY_INTERPOLATION_NONE, "None", "none"},
+    {GSTBT_DELAY_INTERPOLATION_LINEAR, "Linear", "linear"},
+    {GSTBT_DELAY_INTERPOLATION_ALLPASS, "Allpass", "allpass"},
+    {GSTBT_DELAY_INTERPOLATION_CUBIC, "Cubic", "cubic"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtDelayInterpolation", enums);
+  }
+  return type;
+}
+
 //-- constructor methods
 
 /**
@@ -66,37 +90,154 @@ gstbt_delay_new (void)
 
 //-- private methods
 
+/* maximum for the delaytime property */
+#define MAX_DELAYTIME 1000
+/* room for the interpolators */
+#define INTERPOLATION_TAPS 4
+/* delay changes are crossfaded over this time (in seconds) */
+#define XFADE_TIME 0.01
+
 //-- public methods
 
 /**
  * gstbt_delay_start:
  * @self: the delay
  * @samplerate: the new sampling rate
+ * @max_delay: the longest delay in samples that will be used
  *
- * Initialize the delay line.
+ * Initialize the delay line. The ring-buffer is sized for @max_delay, longer
+ * delays (also from #GstBtDelay:delaytime) are limited to it. As the
+ * ring-buffer is not resized later on, changing the delay is safe while
+ * processing. Calling this again, e.g. when the format changes, releases the
+ * previous ring-buffer.
  */
 void
-gstbt_delay_start (GstBtDelay * self, gint samplerate)
+gstbt_delay_start (GstBtDelay * self, gint samplerate, guint max_delay)
 {
+  guint size = max_delay + INTERPOLATION_TAPS;
+
+  gstbt_delay_stop (self);
   self->samplerate = samplerate;
-  self->max_delaytime = (2 + (self->delaytime * samplerate) / 100);
-  self->ring_buffer = (gint16 *) g_new0 (gint16, self->max_delaytime);
-  self->rb_ptr = 0;
+  self->xfade_len = self->xfade_pos = MAX ((guint) (samplerate * XFADE_TIME),
+      1);
+  self->max_delaytime = 1 << g_bit_storage (size - 1);
+  self->mask = self->max_delaytime - 1;
+  self->ring_buffer = g_new0 (gfloat, self->max_delaytime);
+  self->rb_ptr = self->fill = 0;
+  gstbt_delay_set_delay (self, (self->delaytime * samplerate) / 100);
+  self->read_delay = self->old_delay = self->delay;
   GST_INFO ("max_delaytime %d at %d Hz sampling rate", self->max_delaytime,
       samplerate);
 }
 
+/**
+ * gstbt_delay_set_delay:
+ * @self: the delay
+ * @delay: the delay in samples
+ *
+ * Set the delay directly in samples, e.g. for delays that are synced to the
+ * tempo. This overrides #GstBtDelay:delaytime. The delay is limited to what
+ * has been allocated in gstbt_delay_start().
+ *
+ * The GSTBT_DELAY_BEFORE() macro uses the new delay right away, while
+ * gstbt_delay_read_block() crossfades to it.
+ */
+void
+gstbt_delay_set_delay (GstBtDelay * self, guint delay)
+{
+  if (self->ring_buffer)
+    delay = MIN (delay, self->max_delaytime - INTERPOLATION_TAPS);
+  self->delay = delay;
+}
+
+/**
+ * gstbt_delay_read_block:
+ * @self: the delay
+ * @n: the number of samples to read
+ * @out: array for the samples
+ *
+ * Read the next @n delayed samples. The caller writes the same number of
+ * samples afterwards, e.g. using gstbt_delay_write_block(). As the whole
+ * block is read before it is written, @n must not be longer than the delay
+ * (including the previous delay while crossfading).
+ *
+ * If the delay has been changed, the block crossfades from the old to the new
+ * read position. This avoids the clicks caused by jumping in the signal.
+ * Further changes during a crossfade are picked up once it has finished.
+ */
+void
+gstbt_delay_read_block (GstBtDelay * self, guint n, gfloat * out)
+{
+  guint i, ct, rb_out;
+  gfloat *ring_buffer = self->ring_buffer;
+
+  if (self->xfade_pos == self->xfade_len) {
+    guint delay = self->delay;
+
+    if (delay != self->read_delay && delay >= n) {
+      self->old_delay = self->read_delay;
+      self->read_delay = delay;
+      self->xfade_pos = 0;
+    }
+  }
+
+  /* copy in at most two contiguous spans */
+  rb_out = (self->rb_ptr - self->read_delay) & self->mask;
+  ct = MIN (n, self->max_delaytime - rb_out);
+  memcpy (out, &ring_buffer[rb_out], ct * sizeof (gfloat));
+  memcpy (&out[ct], ring_buffer, (n - ct) * sizeof (gfloat));
+
+  if (self->xfade_pos < self->xfade_len) {
+    const gfloat step = 1.0 / self->xfade_len;
+    gfloat v;
+
+    rb_out = (self->rb_ptr - self->old_delay) & self->mask;
+    ct = MIN (n, self->xfade_len - self->xfade_pos);
+    for (i = 0; i < ct; i++) {
+      v = ring_buffer[(rb_out + i) & self->mask];
+      out[i] = v + (self->xfade_pos + i + 1) * step * (out[i] - v);
+    }
+    self->xfade_pos += ct;
+    if (self->xfade_pos == self->xfade_len)
+      self->old_delay = self->read_delay;
+  }
+}
+
+/**
+ * gstbt_delay_write_block:
+ * @self: the delay
+ * @n: the number of samples to write
+ * @in: the samples
+ *
+ * Write the next @n samples and advance the write position. This is the
+ * counterpart of gstbt_delay_read_block().
+ */
+void
+gstbt_delay_write_block (GstBtDelay * self, guint n, const gfloat * in)
+{
+  guint rb_in = self->rb_ptr;
+  guint ct = MIN (n, self->max_delaytime - rb_in);
+
+  memcpy (&self->ring_buffer[rb_in], in, ct * sizeof (gfloat));
+  memcpy (self->ring_buffer, &in[ct], (n - ct) * sizeof (gfloat));
+  self->rb_ptr = (rb_in + n) & self->mask;
+  self->fill = MIN (self->fill + n, self->max_delaytime);
+}
+
 /**
  * gstbt_delay_flush:
  * @self: the delay
  *
- * Zero pending data in the delay.
+ * Zero pending data in the delay. Only the part of the ring-buffer that has
+ * been written since the last flush is cleared.
  */
 void
 gstbt_delay_flush (GstBtDelay * self)
 {
-  memset (self->ring_buffer, 0, sizeof (gint16) * self->max_delaytime);
-  self->rb_ptr = 0;
+  memset (self->ring_buffer, 0, sizeof (gfloat) * self->fill);
+  self->rb_ptr = self->fill = 0;
+  self->read_delay = self->old_delay = self->delay;
+  self->xfade_pos = self->xfade_len;
 }
 
 /**
@@ -125,6 +266,7 @@ gstbt_delay_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_DELAYTIME:
       self->delaytime = g_value_get_uint (value);
+      gstbt_delay_set_delay (self, (self->delaytime * self->samplerate) / 100);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -183,5 +325,5 @@ gstbt_delay_class_init (GstBtDelayClass * klass)
   g_object_class_install_property (gobject_class, PROP_DELAYTIME,
       g_param_spec_uint ("delaytime", "Delay time",
           "Time difference between two echos as milliseconds", 1,
-          1000, 100, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+          MAX_DELAYTIME, 100, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
 }
@@ -24,6 +24,29 @@
 
 G_BEGIN_DECLS
 
+#define GSTBT_TYPE_DELAY_INTERPOLATION (gstbt_delay_interpolation_get_type())
+
+/**
+ * GstBtDelayInterpolation:
+ * @GSTBT_DELAY_INTERPOLATION_NONE: round to the next sample
+ * @GSTBT_DELAY_INTERPOLATION_LINEAR: linear interpolation, cheap but damps
+ *   high frequencies for fractional delays
+ * @GSTBT_DELAY_INTERPOLATION_ALLPASS: first order allpass, flat magnitude
+ *   response, but only suitable for slowly changing delays
+ * @GSTBT_DELAY_INTERPOLATION_CUBIC: 4-point cubic hermite interpolation
+ *
+ * Interpolation modes for fractional delays.
+ */
+typedef enum
+{
+  GSTBT_DELAY_INTERPOLATION_NONE,
+  GSTBT_DELAY_INTERPOLATION_LINEAR,
+  GSTBT_DELAY_INTERPOLATION_ALLPASS,
+  GSTBT_DELAY_INTERPOLATION_CUBIC
+} GstBtDelayInterpolation;
+
+GType gstbt_delay_interpolation_get_type(void);
+
 #define GSTBT_TYPE_DELAY            (gstbt_delay_get_type())
 #define GSTBT_DELAY(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_DELAY,GstBtDelay))
 #define GSTBT_IS_DELAY(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_DELAY))
@@ -47,9 +70,16 @@ struct _GstBtDelay {
   guint delaytime;
 
   gint samplerate;
-  gint16 *ring_buffer;
-  guint max_delaytime;
+  guint delay;                  /* the delay in samples */
+  gfloat *ring_buffer;
+  guint max_delaytime;          /* size of the ring-buffer, a power of 2 */
+  guint mask;
   guint rb_ptr;
+  guint fill;                   /* samples written since the last flush */
+
+  /* delay changes for gstbt_delay_read_block() */
+  guint read_delay, old_delay;
+  guint xfade_len, xfade_pos;
 };
 
 struct _GstBtDelayClass {
@@ -60,7 +90,10 @@ GType gstbt_delay_get_type (void);
 
 GstBtDelay *gstbt_delay_new (void);
 
-void gstbt_delay_start (GstBtDelay *self, gint samplerate);
+void gstbt_delay_start (GstBtDelay *self, gint samplerate, guint max_delay);
+void gstbt_delay_set_delay (GstBtDelay *self, guint delay);
+void gstbt_delay_read_block (GstBtDelay *self, guint n, gfloat *out);
+void gstbt_delay_write_block (GstBtDelay *self, guint n, const gfloat *in);
 void gstbt_delay_flush (GstBtDelay *self);
 void gstbt_delay_stop (GstBtDelay *self);
 
@@ -73,11 +106,8 @@ void gstbt_delay_stop (GstBtDelay *self);
  * Initialize read/write pointers.
  */
 #define GSTBT_DELAY_BEFORE(self,rb_in,rb_out) G_STMT_START {    \
-  guint delaytime = (self->delaytime * self->samplerate) / 100; \
   rb_in = self->rb_ptr;                                         \
-  rb_out = (rb_in >= delaytime)                                 \
-      ? rb_in - delaytime                                       \
-      : (rb_in + self->max_delaytime) - delaytime;              \
+  rb_out = (rb_in - self->delay) & self->mask;                  \
 } G_STMT_END
 
 /**
@@ -88,8 +118,10 @@ void gstbt_delay_stop (GstBtDelay *self);
  *
  * Store read/write pointers.
  */
-#define GSTBT_DELAY_AFTER(self,rb_in,rb_out) G_STMT_START { \
-  self->rb_ptr = rb_in;                                     \
+#define GSTBT_DELAY_AFTER(self,rb_in,rb_out) G_STMT_START {         \
+  if (self->fill < self->max_delaytime)                             \
+    self->fill = (rb_in) > self->rb_ptr ? (rb_in) : self->max_delaytime; \
+  self->rb_ptr = rb_in;                                             \
 } G_STMT_END
 
 /**
@@ -101,8 +133,8 @@ void gstbt_delay_stop (GstBtDelay *self);
  * Read from ring-buffer and advance the position.
  */
 #define GSTBT_DELAY_READ(self,rb_out,v) G_STMT_START { \
-  v = self->ring_buffer[rb_out++];                     \
-  if (rb_out == self->max_delaytime) rb_out = 0;       \
+  v = self->ring_buffer[rb_out];                       \
+  rb_out = (rb_out + 1) & self->mask;                  \
 } G_STMT_END
 
 /**
@@ -114,8 +146,74 @@ void gstbt_delay_stop (GstBtDelay *self);
  * Write to @v the ring-buffer and advance the position.
  */
 #define GSTBT_DELAY_WRITE(self,rb_in,v) G_STMT_START { \
-  self->ring_buffer[rb_in++] = (gint16) v;             \
-  if (rb_in == self->max_delaytime) rb_in = 0;         \
+  self->ring_buffer[rb_in] = (gfloat) (v);             \
+  rb_in = (rb_in + 1) & self->mask;                    \
+} G_STMT_END
+
+/**
+ * GSTBT_DELAY_READ_LINEAR:
+ * @self: the delay
+ * @rb_in: the write position of the ring-buffer
+ * @d: the delay in samples, at least 1.0
+ * @v: the value from the ring-buffer
+ *
+ * Read the value @d samples before the write position with linear
+ * interpolation. Call this before writing the current sample.
+ */
+#define GSTBT_DELAY_READ_LINEAR(self,rb_in,d,v) G_STMT_START {    \
+  const guint __di = (guint) (d);                                 \
+  const gfloat __f = (gfloat) ((d) - __di);                       \
+  const guint __p = ((rb_in) - __di) & self->mask;                \
+  const gfloat __x0 = self->ring_buffer[__p];                     \
+  const gfloat __x1 = self->ring_buffer[(__p - 1) & self->mask];  \
+  v = __x0 + __f * (__x1 - __x0);                                 \
+} G_STMT_END
+
+/**
+ * GSTBT_DELAY_READ_ALLPASS:
+ * @self: the delay
+ * @rb_in: the write position of the ring-buffer
+ * @d: the delay in samples, at least 1.0
+ * @state: a #gfloat holding the interpolator output, owned by the reader
+ * @v: the value from the ring-buffer
+ *
+ * Read the value @d samples before the write position with first order
+ * allpass interpolation. The interpolator has state, thus each reader needs
+ * to pass its own @state and call this once per sample.
+ */
+#define GSTBT_DELAY_READ_ALLPASS(self,rb_in,d,state,v) G_STMT_START { \
+  const guint __di = (guint) (d);                                     \
+  const gfloat __f = (gfloat) ((d) - __di);                           \
+  const gfloat __a = (1.0f - __f) / (1.0f + __f);                     \
+  const guint __p = ((rb_in) - __di) & self->mask;                    \
+  const gfloat __x0 = self->ring_buffer[__p];                         \
+  const gfloat __x1 = self->ring_buffer[(__p - 1) & self->mask];      \
+  state = __x1 + __a * (__x0 - (state));                              \
+  v = state;                                                          \
+} G_STMT_END
+
+/**
+ * GSTBT_DELAY_READ_CUBIC:
+ * @self: the delay
+ * @rb_in: the write position of the ring-buffer
+ * @d: the delay in samples, at least 2.0
+ * @v: the value from the ring-buffer
+ *
+ * Read the value @d samples before the write position with 4-point cubic
+ * hermite interpolation.
+ */
+#define GSTBT_DELAY_READ_CUBIC(self,rb_in,d,v) G_STMT_START {     \
+  const guint __di = (guint) (d);                                 \
+  const gfloat __f = (gfloat) ((d) - __di);                       \
+  const guint __p = ((rb_in) - __di) & self->mask;                \
+  const gfloat __xm = self->ring_buffer[(__p + 1) & self->mask];  \
+  const gfloat __x0 = self->ring_buffer[__p];                     \
+  const gfloat __x1 = self->ring_buffer[(__p - 1) & self->mask];  \
+  const gfloat __x2 = self->ring_buffer[(__p - 2) & self->mask];  \
+  const gfloat __c1 = 0.5f * (__x1 - __xm);                       \
+  const gfloat __c2 = __xm - 2.5f * __x0 + 2.0f * __x1 - 0.5f * __x2; \
+  const gfloat __c3 = 0.5f * (__x2 - __xm) + 1.5f * (__x0 - __x1);    \
+  v = ((__c3 * __f + __c2) * __f + __c1) * __f + __x0;            \
 } G_STMT_END
 
 G_END_DECLS
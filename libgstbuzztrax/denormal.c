@@ -0,0 +1,100 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * denormal.c: denormal protection
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:denormal
+ * @title: GstBtDenormal
+ * @include: libgstbuzztrax/denormal.h
+ * @short_description: denormal protection
+ *
+ * Values in the denormal range are processed very slowly by most FPUs. Filter
+ * states and feedback loops end up there when the signal fades out, which
+ * makes the cpu load jump by orders of magnitude on silence.
+ *
+ * Elements wrap their processing in gstbt_denormal_enter() and
+ * gstbt_denormal_leave(). This switches the FPU to flush denormals to zero
+ * and restores the previous mode afterwards, so that the setting does not
+ * leak into the application. On platforms without such a mode, add
+ * #GSTBT_DENORMAL_DC to the input of recursive structures instead.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined (__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "denormal.h"
+
+/* x86 MXCSR: flush-to-zero (bit 15) and denormals-are-zero (bit 6), the latter
+ * is only set where SSE2 is available as the first SSE cpus lack it */
+#define MXCSR_FTZ 0x8000
+#define MXCSR_DAZ 0x0040
+/* arm FPSCR/FPCR: flush-to-zero (bit 24), covers inputs and outputs */
+#define ARM_FZ (1 << 24)
+
+/**
+ * gstbt_denormal_enter:
+ *
+ * Switch the FPU of the calling thread to flush denormals to zero.
+ *
+ * Returns: the previous state to pass to gstbt_denormal_leave()
+ */
+guint
+gstbt_denormal_enter (void)
+{
+  guint state = 0;
+
+#if defined (__SSE2__)
+  state = _mm_getcsr ();
+  _mm_setcsr (state | MXCSR_FTZ | MXCSR_DAZ);
+#elif defined (__SSE__)
+  state = _mm_getcsr ();
+  _mm_setcsr (state | MXCSR_FTZ);
+#elif defined (__aarch64__)
+  guint64 fpcr;
+
+  __asm__ __volatile__ ("mrs %0, fpcr":"=r" (fpcr));
+  state = (guint) fpcr;
+  __asm__ __volatile__ ("msr fpcr, %0"::"r" (fpcr | ARM_FZ));
+#elif defined (__arm__) && defined (__ARM_FP) && !defined (__SOFTFP__)
+  __asm__ __volatile__ ("vmrs %0, fpscr":"=r" (state));
+  __asm__ __volatile__ ("vmsr fpscr, %0"::"r" (state | ARM_FZ));
+#endif
+  return state;
+}
+
+/**
+ * gstbt_denormal_leave:
+ * @state: the value returned from gstbt_denormal_enter()
+ *
+ * Restore the denormal handling of the calling thread.
+ */
+void
+gstbt_denormal_leave (guint state)
+{
+#if defined (__SSE__)
+  _mm_setcsr (state);
+#elif defined (__aarch64__)
+  __asm__ __volatile__ ("msr fpcr, %0"::"r" ((guint64) state));
+#elif defined (__arm__) && defined (__ARM_FP) && !defined (__SOFTFP__)
+  __asm__ __volatile__ ("vmsr fpscr, %0"::"r" (state));
+#endif
+}
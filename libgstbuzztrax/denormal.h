@@ -0,0 +1,54 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * denormal.h: denormal protection
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_DENORMAL_H__
+#define __GSTBT_DENORMAL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GSTBT_DENORMAL_HAVE_FTZ:
+ *
+ * Defined if the floating point math of this platform can be told to flush
+ * denormals to zero.
+ */
+#if defined (__SSE2_MATH__) || defined (__aarch64__) || (defined (__arm__) && defined (__ARM_FP) && !defined (__SOFTFP__))
+#define GSTBT_DENORMAL_HAVE_FTZ 1
+#endif
+
+/**
+ * GSTBT_DENORMAL_DC:
+ *
+ * Tiny offset to add to the input of recursive structures (filters, feedback
+ * loops). This keeps their state from decaying into the denormal range on
+ * platforms without #GSTBT_DENORMAL_HAVE_FTZ. It is 0.0 elsewhere.
+ */
+#ifdef GSTBT_DENORMAL_HAVE_FTZ
+#define GSTBT_DENORMAL_DC 0.0
+#else
+#define GSTBT_DENORMAL_DC 1.0e-20
+#endif
+
+guint gstbt_denormal_enter (void);
+void gstbt_denormal_leave (guint state);
+
+G_END_DECLS
+#endif /* __GSTBT_DENORMAL_H__ */
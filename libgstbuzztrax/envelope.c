@@ -23,6 +23,12 @@
  * @short_description: envelope base class
  *
  * Base class for envelopes. 
+ *
+ * Segments between the control points are linear by default. Setting
+ * #GstBtEnvelope:curve bends all segments: positive values give the
+ * exponential shape of analog envelopes (fast start, slow end), negative
+ * values the inverse. Curved segments are evaluated with a recursive
+ * multiplier and cost the same as linear ones.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -38,10 +44,14 @@
 #define GST_CAT_DEFAULT envelope_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+/* size of the on-stack gain block used by the apply functions */
+#define BLOCK_SIZE 256
+
 enum
 {
   // class properties
   PROP_VALUE = 1,
+  PROP_CURVE
 };
 
 //-- the class
@@ -52,6 +62,78 @@ G_DEFINE_ABSTRACT_TYPE (GstBtEnvelope, gstbt_envelope, G_TYPE_OBJECT);
 
 //-- private methods
 
+/*
+ * gstbt_envelope_fill:
+ * Render @n values starting at @self->offset. We walk the control points
+ * ourself, each linear segment is a plain ramp that the compiler can vectorize.
+ *
+ * A curved segment from v0 to v1 over N samples follows
+ *   v(k) = v0 + (v1 - v0) * (1 - m^k) / (1 - m^N), with m = exp (-curve / N)
+ * which we rewrite as v(k) = a - p(k) with p(k + 1) = p(k) * m.
+ */
+static void
+gstbt_envelope_fill (GstBtEnvelope * self, guint n, gdouble * out)
+{
+  GstTimedValueControlSource *cs = self->cs;
+  GSequenceIter *iter, *next;
+  GstControlPoint *cp1, *cp2;
+  guint64 offset = self->offset;
+  gdouble curve = self->curve;
+  gdouble value, step, len;
+  guint i = 0, j, ct;
+
+  GST_OBJECT_LOCK (cs);
+  if (!cs->values || !cs->nvalues) {
+    GST_OBJECT_UNLOCK (cs);
+    memset (out, 0, n * sizeof (gdouble));
+    return;
+  }
+  iter = gst_timed_value_control_source_find_control_point_iter (cs, offset);
+  if (!iter) {
+    /* before the first control point, hold its value */
+    iter = g_sequence_get_begin_iter (cs->values);
+    cp1 = g_sequence_get (iter);
+    ct = (guint) MIN (n, cp1->timestamp - offset);
+    for (j = 0; j < ct; j++)
+      out[j] = cp1->value;
+    i = ct;
+    offset += ct;
+  }
+  while (i < n) {
+    cp1 = g_sequence_get (iter);
+    next = g_sequence_iter_next (iter);
+    if (g_sequence_iter_is_end (next)) {
+      /* after the last control point, hold its value */
+      for (j = i; j < n; j++)
+        out[j] = cp1->value;
+      break;
+    }
+    cp2 = g_sequence_get (next);
+    ct = (guint) MIN (n - i, cp2->timestamp - offset);
+    len = (gdouble) (cp2->timestamp - cp1->timestamp);
+    if (curve == 0.0 || cp1->value == cp2->value) {
+      step = (cp2->value - cp1->value) / len;
+      value = cp1->value + step * (gdouble) (offset - cp1->timestamp);
+      for (j = 0; j < ct; j++)
+        out[i + j] = value + step * (gdouble) j;
+    } else {
+      gdouble m = exp (-curve / len);
+      gdouble b = (cp2->value - cp1->value) / (1.0 - exp (-curve));
+      gdouble a = cp1->value + b;
+      gdouble p = b * pow (m, (gdouble) (offset - cp1->timestamp));
+
+      for (j = 0; j < ct; j++) {
+        out[i + j] = a - p;
+        p *= m;
+      }
+    }
+    i += ct;
+    offset += ct;
+    iter = next;
+  }
+  GST_OBJECT_UNLOCK (cs);
+}
+
 //-- public methods
 
 /**
@@ -66,12 +148,116 @@ G_DEFINE_ABSTRACT_TYPE (GstBtEnvelope, gstbt_envelope, G_TYPE_OBJECT);
 gdouble
 gstbt_envelope_get (GstBtEnvelope * self, guint offset)
 {
-  gst_control_source_get_value ((GstControlSource *) self->cs, self->offset,
-      &self->value);
+  gstbt_envelope_fill (self, 1, &self->value);
   self->offset += offset;
   return self->value;
 }
 
+/**
+ * gstbt_envelope_get_block:
+ * @self: the envelope
+ * @n: the number of values to render
+ * @out: target array for @n values
+ *
+ * Render the envelope curve for the next @n samples into @out and advance the
+ * position by @n. Unlike gstbt_envelope_get() this yields one value per
+ * sample.
+ */
+void
+gstbt_envelope_get_block (GstBtEnvelope * self, guint n, gdouble * out)
+{
+  if (G_UNLIKELY (!n))
+    return;
+
+  gstbt_envelope_fill (self, n, out);
+  self->offset += n;
+  self->value = out[n - 1];
+}
+
+/**
+ * gstbt_envelope_apply_s16:
+ * @self: the envelope
+ * @n: the number of frames in @data
+ * @channels: the number of interleaved channels in @data
+ * @data: the audio samples
+ *
+ * Multiply the next @n frames of audio by the envelope and advance the
+ * position by @n. All channels of a frame get the same gain.
+ */
+void
+gstbt_envelope_apply_s16 (GstBtEnvelope * self, guint n, gint channels,
+    gint16 * data)
+{
+  gdouble amp[BLOCK_SIZE];
+  guint i, ct;
+  gint c;
+
+  while (n) {
+    ct = MIN (n, BLOCK_SIZE);
+    gstbt_envelope_get_block (self, ct, amp);
+    if (channels == 1) {
+      for (i = 0; i < ct; i++) {
+        data[i] = (gint16) (data[i] * amp[i]);
+      }
+    } else if (channels == 2) {
+      for (i = 0; i < ct; i++) {
+        data[(i << 1)] = (gint16) (data[(i << 1)] * amp[i]);
+        data[(i << 1) + 1] = (gint16) (data[(i << 1) + 1] * amp[i]);
+      }
+    } else {
+      for (i = 0; i < ct; i++) {
+        for (c = 0; c < channels; c++) {
+          data[i * channels + c] = (gint16) (data[i * channels + c] * amp[i]);
+        }
+      }
+    }
+    data += ct * channels;
+    n -= ct;
+  }
+}
+
+/**
+ * gstbt_envelope_apply_f32:
+ * @self: the envelope
+ * @n: the number of frames in @data
+ * @channels: the number of interleaved channels in @data
+ * @data: the audio samples
+ *
+ * Multiply the next @n frames of audio by the envelope and advance the
+ * position by @n. All channels of a frame get the same gain.
+ */
+void
+gstbt_envelope_apply_f32 (GstBtEnvelope * self, guint n, gint channels,
+    gfloat * data)
+{
+  gdouble amp[BLOCK_SIZE];
+  guint i, ct;
+  gint c;
+
+  while (n) {
+    ct = MIN (n, BLOCK_SIZE);
+    gstbt_envelope_get_block (self, ct, amp);
+    if (channels == 1) {
+      for (i = 0; i < ct; i++) {
+        data[i] *= (gfloat) amp[i];
+      }
+    } else if (channels == 2) {
+      for (i = 0; i < ct; i++) {
+        data[(i << 1)] *= (gfloat) amp[i];
+        data[(i << 1) + 1] *= (gfloat) amp[i];
+      }
+    } else {
+      for (i = 0; i < ct; i++) {
+        for (c = 0; c < channels; c++) {
+          data[i * channels + c] *= (gfloat) amp[i];
+        }
+      }
+    }
+    data += ct * channels;
+    n -= ct;
+  }
+}
+
 /**
  * gstbt_envelope_is_running:
  * @self: the envelope
@@ -102,6 +288,9 @@ gstbt_envelope_set_property (GObject * object, guint prop_id,
     case PROP_VALUE:
       self->value = g_value_get_double (value);
       break;
+    case PROP_CURVE:
+      self->curve = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -122,6 +311,9 @@ gstbt_envelope_get_property (GObject * object, guint prop_id,
       // TODO(ensonic): gst_object_sync_values (GST_OBJECT (env), self->running_time);
       g_value_set_double (value, self->value);
       break;
+    case PROP_CURVE:
+      g_value_set_double (value, self->curve);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -147,6 +339,7 @@ static void
 gstbt_envelope_init (GstBtEnvelope * self)
 {
   self->value = 0.0;
+  self->curve = 0.0;
   self->cs =
       (GstTimedValueControlSource *) gst_interpolation_control_source_new ();
   g_object_set (self->cs, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
@@ -172,4 +365,9 @@ gstbt_envelope_class_init (GstBtEnvelopeClass * klass)
           0.0, 1.0, 0.0,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  g_object_class_install_property (gobject_class, PROP_CURVE,
+      g_param_spec_double ("curve", "Curve",
+          "Curvature of the envelope segments (0.0 for linear, > 0.0 for "
+          "exponential, < 0.0 for logarithmic)", -10.0, 10.0, 0.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
@@ -38,6 +38,7 @@ typedef struct _GstBtEnvelopeClass GstBtEnvelopeClass;
 /**
  * GstBtEnvelope:
  * @value: current envelope value
+ * @curve: curvature of the segments (0.0 for linear)
  *
  * Class instance data.
  */
@@ -49,6 +50,7 @@ struct _GstBtEnvelope {
   /* < public > */
   /* parameters */
   gdouble value;
+  gdouble curve;
 
   /* < private > */
   GstTimedValueControlSource *cs;
@@ -62,6 +64,9 @@ struct _GstBtEnvelopeClass {
 GType gstbt_envelope_get_type (void);
 
 gdouble gstbt_envelope_get (GstBtEnvelope *self, guint offset);
+void gstbt_envelope_get_block (GstBtEnvelope *self, guint n, gdouble *out);
+void gstbt_envelope_apply_s16 (GstBtEnvelope *self, guint n, gint channels, gint16 *data);
+void gstbt_envelope_apply_f32 (GstBtEnvelope *self, guint n, gint channels, gfloat *data);
 gboolean gstbt_envelope_is_running (GstBtEnvelope *self);
 
 G_END_DECLS
@@ -23,6 +23,9 @@
  * @short_description: state variable filter
  *
  * An audio filter that can work in 4 modes (#GstBtFilterSVF:type).
+ *
+ * Changes of the cut-off are smoothed, so that it can be modulated without
+ * zipper noise.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -33,11 +36,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "denormal.h"
 #include "filter-svf.h"
 
 #define GST_CAT_DEFAULT envelope_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#define BLOCK_SIZE 256
+/* cut-off changes are spread over this many samples */
+#define CUTOFF_SMOOTHING 256
+
 enum
 {
   // dynamic class properties
@@ -91,19 +99,26 @@ gstbt_filter_svf_new (void)
 static void
 gstbt_filter_svf_lowpass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 {
-  guint i;
+  guint i, n;
   gdouble flt_low = self->flt_low;
   gdouble flt_mid = self->flt_mid;
   gdouble flt_high = self->flt_high;
   gdouble flt_res = self->flt_res;
-  gdouble cutoff = self->cutoff;
-
-  for (i = 0; i < ct; i++) {
-    flt_high = (gdouble) samples[i] - (flt_mid * flt_res) - flt_low;
-    flt_mid += (flt_high * cutoff);
-    flt_low += (flt_mid * cutoff);
-
-    samples[i] = (gint16) CLAMP ((glong) flt_low, G_MININT16, G_MAXINT16);
+  gdouble cutoff[BLOCK_SIZE];
+
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    gstbt_smoother_get_block (&self->cutoff_smoother, n, cutoff);
+    for (i = 0; i < n; i++) {
+      flt_high = ((gdouble) samples[i] + GSTBT_DENORMAL_DC) -
+          (flt_mid * flt_res) - flt_low;
+      flt_mid += (flt_high * cutoff[i]);
+      flt_low += (flt_mid * cutoff[i]);
+
+      samples[i] = (gint16) CLAMP ((glong) flt_low, G_MININT16, G_MAXINT16);
+    }
+    samples += n;
+    ct -= n;
   }
   self->flt_low = flt_low;
   self->flt_mid = flt_mid;
@@ -113,19 +128,26 @@ gstbt_filter_svf_lowpass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 static void
 gstbt_filter_svf_hipass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 {
-  guint i;
+  guint i, n;
   gdouble flt_low = self->flt_low;
   gdouble flt_mid = self->flt_mid;
   gdouble flt_high = self->flt_high;
   gdouble flt_res = self->flt_res;
-  gdouble cutoff = self->cutoff;
-
-  for (i = 0; i < ct; i++) {
-    flt_high = (gdouble) samples[i] - (flt_mid * flt_res) - flt_low;
-    flt_mid += (flt_high * cutoff);
-    flt_low += (flt_mid * cutoff);
-
-    samples[i] = (gint16) CLAMP ((glong) flt_high, G_MININT16, G_MAXINT16);
+  gdouble cutoff[BLOCK_SIZE];
+
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    gstbt_smoother_get_block (&self->cutoff_smoother, n, cutoff);
+    for (i = 0; i < n; i++) {
+      flt_high = ((gdouble) samples[i] + GSTBT_DENORMAL_DC) -
+          (flt_mid * flt_res) - flt_low;
+      flt_mid += (flt_high * cutoff[i]);
+      flt_low += (flt_mid * cutoff[i]);
+
+      samples[i] = (gint16) CLAMP ((glong) flt_high, G_MININT16, G_MAXINT16);
+    }
+    samples += n;
+    ct -= n;
   }
   self->flt_low = flt_low;
   self->flt_mid = flt_mid;
@@ -135,19 +157,26 @@ gstbt_filter_svf_hipass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 static void
 gstbt_filter_svf_bandpass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 {
-  guint i;
+  guint i, n;
   gdouble flt_low = self->flt_low;
   gdouble flt_mid = self->flt_mid;
   gdouble flt_high = self->flt_high;
   gdouble flt_res = self->flt_res;
-  gdouble cutoff = self->cutoff;
-
-  for (i = 0; i < ct; i++) {
-    flt_high = (gdouble) samples[i] - (flt_mid * flt_res) - flt_low;
-    flt_mid += (flt_high * cutoff);
-    flt_low += (flt_mid * cutoff);
-
-    samples[i] = (gint16) CLAMP ((glong) flt_mid, G_MININT16, G_MAXINT16);
+  gdouble cutoff[BLOCK_SIZE];
+
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    gstbt_smoother_get_block (&self->cutoff_smoother, n, cutoff);
+    for (i = 0; i < n; i++) {
+      flt_high = ((gdouble) samples[i] + GSTBT_DENORMAL_DC) -
+          (flt_mid * flt_res) - flt_low;
+      flt_mid += (flt_high * cutoff[i]);
+      flt_low += (flt_mid * cutoff[i]);
+
+      samples[i] = (gint16) CLAMP ((glong) flt_mid, G_MININT16, G_MAXINT16);
+    }
+    samples += n;
+    ct -= n;
   }
   self->flt_low = flt_low;
   self->flt_mid = flt_mid;
@@ -157,20 +186,28 @@ gstbt_filter_svf_bandpass (GstBtFilterSVF * self, guint ct, gint16 * samples)
 static void
 gstbt_filter_svf_bandstop (GstBtFilterSVF * self, guint ct, gint16 * samples)
 {
-  guint i;
+  guint i, n;
   gdouble flt_low = self->flt_low;
   gdouble flt_mid = self->flt_mid;
   gdouble flt_high = self->flt_high;
   gdouble flt_res = self->flt_res;
-  gdouble cutoff = self->cutoff;
-
-  for (i = 0; i < ct; i++) {
-    flt_high = (gdouble) samples[i] - (flt_mid * flt_res) - flt_low;
-    flt_mid += (flt_high * cutoff);
-    flt_low += (flt_mid * cutoff);
-
-    samples[i] =
-        (gint16) CLAMP ((glong) (flt_low + flt_high), G_MININT16, G_MAXINT16);
+  gdouble cutoff[BLOCK_SIZE];
+
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    gstbt_smoother_get_block (&self->cutoff_smoother, n, cutoff);
+    for (i = 0; i < n; i++) {
+      flt_high = ((gdouble) samples[i] + GSTBT_DENORMAL_DC) -
+          (flt_mid * flt_res) - flt_low;
+      flt_mid += (flt_high * cutoff[i]);
+      flt_low += (flt_mid * cutoff[i]);
+
+      samples[i] =
+          (gint16) CLAMP ((glong) (flt_low + flt_high), G_MININT16,
+          G_MAXINT16);
+    }
+    samples += n;
+    ct -= n;
   }
   self->flt_low = flt_low;
   self->flt_mid = flt_mid;
@@ -225,6 +262,7 @@ gstbt_filter_svf_set_property (GObject * object, guint prop_id,
     case PROP_CUTOFF:
       //GST_INFO("change cutoff %lf -> %lf",g_value_get_double (value),self->cutoff);
       self->cutoff = g_value_get_double (value);
+      gstbt_smoother_set_target (&self->cutoff_smoother, self->cutoff);
       break;
     case PROP_RESONANCE:
       //GST_INFO("change resonance %lf -> %lf",g_value_get_double (value),self->resonance);
@@ -264,6 +302,8 @@ gstbt_filter_svf_init (GstBtFilterSVF * self)
 {
   self->type = GSTBT_FILTER_SVF_LOWPASS;
   self->cutoff = 0.8;
+  gstbt_smoother_init (&self->cutoff_smoother, GSTBT_SMOOTHER_LINEAR,
+      CUTOFF_SMOOTHING, self->cutoff);
   self->resonance = 0.8;
   self->flt_res = 1.0 / self->resonance;
   gstbt_filter_svf_change_filter (self);
@@ -21,6 +21,7 @@
 #define __GSTBT_FILTER_SVF_H__
 
 #include <gst/gst.h>
+#include <libgstbuzztrax/smoother.h>
 
 G_BEGIN_DECLS
 
@@ -80,6 +81,7 @@ struct _GstBtFilterSVF {
   /* filter state */
   gdouble flt_low, flt_mid, flt_high;
   gdouble flt_res;
+  GstBtSmoother cutoff_smoother;
 
   /* < private > */
   void (*process) (GstBtFilterSVF *, guint, gint16 *);
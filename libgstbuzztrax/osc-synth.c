@@ -23,6 +23,9 @@
  * @short_description: synthetic waveform oscillator
  *
  * An audio generator producing classic oscillator waveforms.
+ *
+ * Frequency changes glide over a few milliseconds to avoid clicks from
+ * stepped automation.
  */
 /* TODO(ensonic): we should do a linear fade down in the last inner_loop block as an
  * anticlick messure
@@ -46,7 +49,10 @@
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
 #define M_PI_M2 ( M_PI + M_PI )
-#define INNER_LOOP 64
+
+#define BLOCK_SIZE 256
+/* frequency changes are spread over this time (in seconds) */
+#define FREQ_SMOOTHING 0.002
 
 enum
 {
@@ -107,110 +113,120 @@ gstbt_osc_synth_new (void)
 
 //-- private methods
 
-static gdouble
-get_volume (GstBtOscSynth * self, gdouble ampf, guint size)
+static void
+apply_volume (GstBtOscSynth * self, guint ct, gint16 * samples)
 {
   if (self->volenv) {
-    return gstbt_envelope_get (self->volenv, MIN (INNER_LOOP, size)) * ampf;
-  } else {
-    return ampf;
+    gstbt_envelope_apply_s16 (self->volenv, ct, 1, samples);
   }
 }
 
+/* advance the phase for the next ct samples, following the smoothed
+ * frequency */
 static void
-gstbt_osc_synth_create_sine (GstBtOscSynth * self, guint ct, gint16 * samples)
+gstbt_osc_synth_render_phase (GstBtOscSynth * self, guint ct, gdouble * phase)
 {
-  guint i = 0, j;
-  gdouble amp;
+  guint i;
   gdouble accumulator = self->accumulator;
-  gdouble step = M_PI_M2 * self->freq / self->samplerate;
+  gdouble scale = M_PI_M2 / self->samplerate;
 
-  while (i < ct) {
-    amp = get_volume (self, 32767.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      accumulator += step;
-      /* TODO(ensonic): move out of inner loop? */
-      if (G_UNLIKELY (accumulator >= M_PI_M2))
-        accumulator -= M_PI_M2;
+  gstbt_smoother_get_block (&self->freq_smoother, ct, phase);
+  for (i = 0; i < ct; i++) {
+    accumulator += phase[i] * scale;
+    if (G_UNLIKELY (accumulator >= M_PI_M2))
+      accumulator -= M_PI_M2;
+    phase[i] = accumulator;
+  }
+  self->accumulator = accumulator;
+}
 
-      samples[i] = (gint16) (sin (accumulator) * amp);
+static void
+gstbt_osc_synth_create_sine (GstBtOscSynth * self, guint ct, gint16 * samples)
+{
+  gdouble phase[BLOCK_SIZE];
+  gint16 *data = samples;
+  guint i, n, left = ct;
+
+  while (left) {
+    n = MIN (left, BLOCK_SIZE);
+    gstbt_osc_synth_render_phase (self, n, phase);
+    for (i = 0; i < n; i++) {
+      data[i] = (gint16) (sin (phase[i]) * 32767.0);
     }
+    data += n;
+    left -= n;
   }
-  self->accumulator = accumulator;
+  apply_volume (self, ct, samples);
 }
 
 static void
 gstbt_osc_synth_create_square (GstBtOscSynth * self, guint ct, gint16 * samples)
 {
-  guint i = 0, j;
-  gdouble amp;
-  gdouble accumulator = self->accumulator;
-  gdouble step = M_PI_M2 * self->freq / self->samplerate;
-
-  while (i < ct) {
-    amp = get_volume (self, 32767.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      accumulator += step;
-      if (G_UNLIKELY (accumulator >= M_PI_M2))
-        accumulator -= M_PI_M2;
-
-      samples[i] = (gint16) ((accumulator < M_PI) ? amp : -amp);
+  gdouble phase[BLOCK_SIZE];
+  gint16 *data = samples;
+  guint i, n, left = ct;
+
+  while (left) {
+    n = MIN (left, BLOCK_SIZE);
+    gstbt_osc_synth_render_phase (self, n, phase);
+    for (i = 0; i < n; i++) {
+      data[i] = (phase[i] < M_PI) ? 32767 : -32767;
     }
+    data += n;
+    left -= n;
   }
-  self->accumulator = accumulator;
+  apply_volume (self, ct, samples);
 }
 
 static void
 gstbt_osc_synth_create_saw (GstBtOscSynth * self, guint ct, gint16 * samples)
 {
-  guint i = 0, j;
-  gdouble amp, ampf = 32767.0 / M_PI;
-  gdouble accumulator = self->accumulator;
-  gdouble step = M_PI_M2 * self->freq / self->samplerate;
-
-  while (i < ct) {
-    amp = get_volume (self, ampf, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      accumulator += step;
-      if (G_UNLIKELY (accumulator >= M_PI_M2))
-        accumulator -= M_PI_M2;
-
-      if (accumulator < M_PI) {
-        samples[i] = (gint16) (accumulator * amp);
+  gdouble phase[BLOCK_SIZE];
+  gdouble amp = 32767.0 / M_PI;
+  gint16 *data = samples;
+  guint i, n, left = ct;
+
+  while (left) {
+    n = MIN (left, BLOCK_SIZE);
+    gstbt_osc_synth_render_phase (self, n, phase);
+    for (i = 0; i < n; i++) {
+      if (phase[i] < M_PI) {
+        data[i] = (gint16) (phase[i] * amp);
       } else {
-        samples[i] = (gint16) ((M_PI_M2 - accumulator) * -amp);
+        data[i] = (gint16) ((M_PI_M2 - phase[i]) * -amp);
       }
     }
+    data += n;
+    left -= n;
   }
-  self->accumulator = accumulator;
+  apply_volume (self, ct, samples);
 }
 
 static void
 gstbt_osc_synth_create_triangle (GstBtOscSynth * self, guint ct,
     gint16 * samples)
 {
-  guint i = 0, j;
-  gdouble amp, ampf = 32767.0 / M_PI;
-  gdouble accumulator = self->accumulator;
-  gdouble step = M_PI_M2 * self->freq / self->samplerate;
-
-  while (i < ct) {
-    amp = get_volume (self, ampf, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      accumulator += step;
-      if (G_UNLIKELY (accumulator >= M_PI_M2))
-        accumulator -= M_PI_M2;
-
-      if (accumulator < (M_PI * 0.5)) {
-        samples[i] = (gint16) (accumulator * amp);
-      } else if (accumulator < (M_PI * 1.5)) {
-        samples[i] = (gint16) ((accumulator - M_PI) * -amp);
+  gdouble phase[BLOCK_SIZE];
+  gdouble amp = 32767.0 / M_PI;
+  gint16 *data = samples;
+  guint i, n, left = ct;
+
+  while (left) {
+    n = MIN (left, BLOCK_SIZE);
+    gstbt_osc_synth_render_phase (self, n, phase);
+    for (i = 0; i < n; i++) {
+      if (phase[i] < (M_PI * 0.5)) {
+        data[i] = (gint16) (phase[i] * amp);
+      } else if (phase[i] < (M_PI * 1.5)) {
+        data[i] = (gint16) ((phase[i] - M_PI) * -amp);
       } else {
-        samples[i] = (gint16) ((M_PI_M2 - accumulator) * -amp);
+        data[i] = (gint16) ((M_PI_M2 - phase[i]) * -amp);
       }
     }
+    data += n;
+    left -= n;
   }
-  self->accumulator = accumulator;
+  apply_volume (self, ct, samples);
 }
 
 static void
@@ -224,15 +240,12 @@ static void
 gstbt_osc_synth_create_white_noise (GstBtOscSynth * self, guint ct,
     gint16 * samples)
 {
-  guint i = 0, j;
-  gdouble amp;
+  guint i;
 
-  while (i < ct) {
-    amp = get_volume (self, 65535.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      samples[i] = (gint16) (32768 - (amp * rand () / (RAND_MAX + 1.0)));
-    }
+  for (i = 0; i < ct; i++) {
+    samples[i] = (gint16) (32767.0 - (65535.0 * rand () / (RAND_MAX + 1.0)));
   }
+  apply_volume (self, ct, samples);
 }
 
 /* pink noise calculation is based on
@@ -297,17 +310,14 @@ static void
 gstbt_osc_synth_create_pink_noise (GstBtOscSynth * self, guint ct,
     gint16 * samples)
 {
-  guint i = 0, j;
+  guint i;
   GstBtPinkNoise *pink = &self->pink;
-  gdouble amp;
 
-  while (i < ct) {
-    amp = get_volume (self, 32767.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      samples[i] =
-          (gint16) (gstbt_osc_synth_generate_pink_noise_value (pink) * amp);
-    }
+  for (i = 0; i < ct; i++) {
+    samples[i] =
+        (gint16) (gstbt_osc_synth_generate_pink_noise_value (pink) * 32767.0);
   }
+  apply_volume (self, ct, samples);
 }
 
 /* Gaussian white noise using Box-Muller algorithm.  unit variance
@@ -319,19 +329,28 @@ static void
 gstbt_osc_synth_create_gaussian_white_noise (GstBtOscSynth * self, guint ct,
     gint16 * samples)
 {
-  gint i = 0, j;
-  gdouble amp;
+  gfloat noise[BLOCK_SIZE];
+  guint i, n;
 
-  while (i < ct) {
-    amp = get_volume (self, 32767.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j += 2) {
+  // the tails exceed full scale, only clip once the volume has been applied
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    for (i = 0; i < n;) {
       gdouble mag = sqrt (-2 * log (1.0 - rand () / (RAND_MAX + 1.0)));
       gdouble phs = M_PI_M2 * rand () / (RAND_MAX + 1.0);
 
-      samples[i++] = (gint16) (amp * mag * cos (phs));
-      if (i < ct)
-        samples[i++] = (gint16) (amp * mag * sin (phs));
+      noise[i++] = (gfloat) (32767.0 * mag * cos (phs));
+      if (i < n)
+        noise[i++] = (gfloat) (32767.0 * mag * sin (phs));
+    }
+    if (self->volenv) {
+      gstbt_envelope_apply_f32 (self->volenv, n, 1, noise);
+    }
+    for (i = 0; i < n; i++) {
+      samples[i] = (gint16) CLAMP (noise[i], G_MININT16, G_MAXINT16);
     }
+    samples += n;
+    ct -= n;
   }
 }
 
@@ -339,25 +358,22 @@ static void
 gstbt_osc_synth_create_red_noise (GstBtOscSynth * self, guint ct,
     gint16 * samples)
 {
-  gint i = 0, j;
-  gdouble amp;
+  guint i;
   gdouble state = self->red.state;
 
-  while (i < ct) {
-    amp = get_volume (self, 32767.0, ct - i);
-    for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-      while (TRUE) {
-        gdouble r = 1.0 - (2.0 * rand () / (RAND_MAX + 1.0));
-        state += r;
-        if (state < -8.0f || state > 8.0f)
-          state -= r;
-        else
-          break;
-      }
-      samples[i] = (gint16) (amp * state * 0.0625f);    /* /16.0 */
+  for (i = 0; i < ct; i++) {
+    while (TRUE) {
+      gdouble r = 1.0 - (2.0 * rand () / (RAND_MAX + 1.0));
+      state += r;
+      if (state < -8.0f || state > 8.0f)
+        state -= r;
+      else
+        break;
     }
+    samples[i] = (gint16) (32767.0 * state * 0.0625f);  /* /16.0 */
   }
   self->red.state = state;
+  apply_volume (self, ct, samples);
 }
 
 static void
@@ -452,10 +468,13 @@ gstbt_osc_synth_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstBtOscSynth *self = GSTBT_OSC_SYNTH (object);
+  gboolean sounding;
 
   switch (prop_id) {
     case PROP_SAMPLERATE:
       self->samplerate = g_value_get_int (value);
+      gstbt_smoother_set_length (&self->freq_smoother,
+          (guint) (self->samplerate * FREQ_SMOOTHING));
       break;
     case PROP_VOLUME_ENVELOPE:
       self->volenv = GSTBT_ENVELOPE (g_value_get_object (value));
@@ -469,7 +488,15 @@ gstbt_osc_synth_set_property (GObject * object, guint prop_id,
       break;
     case PROP_FREQUENCY:
       //GST_INFO("change frequency %lf -> %lf",g_value_get_double (value),self->freq);
+      sounding = self->volenv ? gstbt_envelope_is_running (self->volenv) :
+          (self->freq > 0.0);
       self->freq = g_value_get_double (value);
+      if (sounding) {
+        gstbt_smoother_set_target (&self->freq_smoother, self->freq);
+      } else {
+        // no note is sounding, don't glide in from the previous one
+        gstbt_smoother_reset (&self->freq_smoother, self->freq);
+      }
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -523,6 +550,8 @@ gstbt_osc_synth_init (GstBtOscSynth * self)
   gstbt_osc_synth_change_wave (self);
   self->flip = 1.0;
   self->samplerate = 44100;
+  gstbt_smoother_init (&self->freq_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * FREQ_SMOOTHING), self->freq);
 }
 
 static void
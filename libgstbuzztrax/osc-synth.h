@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <libgstbuzztrax/envelope.h>
+#include <libgstbuzztrax/smoother.h>
 
 G_BEGIN_DECLS
 
@@ -108,6 +109,7 @@ struct _GstBtOscSynth {
 
   /* oscillator state */
   gdouble accumulator;          /* phase angle */
+  GstBtSmoother freq_smoother;
   gdouble flip;
   GstBtPinkNoise pink;
   GstBtRedNoise red;
@@ -23,6 +23,35 @@
  * @short_description: wavetable oscillator
  *
  * An audio waveform generator that read from the applications wave-table.
+ *
+ * When the wave is played at a different pitch, the samples are interpolated
+ * according to #GstBtOscWave:interpolation.
+ *
+ * When reading faster than the original rate, the wave would alias. With
+ * #GstBtOscWave:mipmaps enabled, band-limited copies at half, quarter, ...
+ * the rate are used instead, picking the one that fits the pitch. The copies
+ * are built once by a background thread the first time they are needed and
+ * shared by all oscillators that play the same wave. Until they are ready
+ * the wave itself is played. #GstBtOscWave:mip-crossfade blends between the
+ * two closest levels, which avoids the dull sound of the lower level at the
+ * cost of interpolating twice.
+ *
+ * If the wave structure returned by the wave-table callbacks has a
+ * "loop-mode" (#GstBtOscWaveLoopMode as int) together with "loop-start" and
+ * "loop-end" (frames as guint64, the end is exclusive), the wave continues in
+ * the loop once it reaches the end of it. The #GstBtOscWave:duration is still
+ * the length of a single pass through the wave.
+ *
+ * If the wave structure has a "cache-key" field, the wave is taken from the
+ * #GstBtWaveCache. On a cache miss the "buffer" is stored in the cache first.
+ * Entries with float samples are converted. The cache is accessed from the
+ * background thread, the oscillator is silent until the wave is loaded.
+ *
+ * With #GstBtOscWave:streaming enabled, such a wave is not mapped but read
+ * through a #GstBtWaveStream. This keeps the memory use bounded for very long
+ * waves. Streamed waves are always played at their original rate and without
+ * loops. The stream is opened by the background thread as well, the host
+ * should check gstbt_osc_wave_take_stream_error() while playing.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -32,12 +61,79 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "osc-wave.h"
+#include "wave-cache.h"
 
 #define GST_CAT_DEFAULT envelope_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+/* windowed sinc interpolator, the taps cover the samples i-3 ... i+4 */
+#define SINC_TAPS 8
+#define SINC_PHASE_BITS 8
+#define SINC_PHASES (1 << SINC_PHASE_BITS)
+static gfloat sinc_table[SINC_PHASES + 1][SINC_TAPS];
+
+/* lowpass for building the mip levels, cut-off at half the nyquist rate */
+#define MIP_TAPS 31
+#define MIP_HALF (MIP_TAPS / 2)
+/* don't build mip levels that are shorter than this */
+#define MIP_MIN_FRAMES 16
+static gfloat mip_filter[MIP_TAPS];
+
+/* states of the shared waves */
+enum
+{
+  WAVE_DATA_LOADING = 0,
+  WAVE_DATA_READY,
+  WAVE_DATA_FAILED
+};
+
+/* a wave and its mip levels, shared by all oscillators that play it, or a
+ * stream that is only used by one oscillator */
+struct _GstBtOscWaveData
+{
+  volatile gint ref_count;
+  gchar *id;                    /* the key in shared_waves, NULL for streams */
+  gchar *key;                   /* the cache key */
+  volatile gint state;
+  GstBuffer *buffer;            /* mapped once the state is ready */
+  GstMapInfo map_info;
+  guint channels;
+  gboolean streaming;
+  GstBtWaveStream *stream;
+
+  volatile gint want_mips;      /* the levels have been requested */
+  volatile gint has_mips;       /* the levels are built */
+  /* band-limited copies of the wave at half, quarter, ... the rate, level 0
+   * is the wave itself */
+  gint16 *mip_data[GSTBT_OSC_WAVE_MAX_MIP_LEVELS];
+  guint64 mip_frames[GSTBT_OSC_WAVE_MAX_MIP_LEVELS];
+  guint num_mips;
+};
+
+/* the shared waves by id, entries are removed when they are no longer used */
+static GMutex shared_waves_lock;
+static GHashTable *shared_waves;
+/* loads the cached waves and builds the mip levels outside of the streaming
+ * threads */
+static GThreadPool *loader;
+
+/* resampled waves are rendered in blocks of this size */
+#define RESAMPLE_BLOCK 256
+/* the read position is 32.32 fixed point */
+#define PHASE_ONE G_GUINT64_CONSTANT (0x100000000)
+#define PHASE_MASK G_GUINT64_CONSTANT (0xFFFFFFFF)
+#define PHASE_SCALE (1.0f / 4294967296.0f)
+/* the rate is kept in a range where the step is not 0 and does not overflow */
+#define MIN_RATE (1.0 / 4294967296.0)
+#define MAX_RATE 65536.0
+/* the loop guards hold the looped wave around each loop point and mip level,
+ * the runs within GUARD_HALF frames of a loop point are read from them */
+#define GUARD_HALF SINC_TAPS
+#define GUARD_FRAMES (4 * GUARD_HALF)
+
 enum
 {
   // static class properties
@@ -46,6 +142,10 @@ enum
   PROP_WAVE,
   PROP_WAVE_LEVEL,
   PROP_FREQUENCY,
+  PROP_INTERPOLATION,
+  PROP_MIPMAPS,
+  PROP_MIP_CROSSFADE,
+  PROP_STREAMING,
   // readable class properties
   PROP_DURATION
 };
@@ -54,6 +154,26 @@ enum
 
 G_DEFINE_TYPE (GstBtOscWave, gstbt_osc_wave, G_TYPE_OBJECT);
 
+//-- enums
+
+GType
+gstbt_osc_wave_interpolation_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_OSC_WAVE_INTERPOLATION_NONE, "None", "none"},
+    {GSTBT_OSC_WAVE_INTERPOLATION_LINEAR, "Linear", "linear"},
+    {GSTBT_OSC_WAVE_INTERPOLATION_CUBIC, "Cubic", "cubic"},
+    {GSTBT_OSC_WAVE_INTERPOLATION_SINC, "Sinc", "sinc"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtOscWaveInterpolation", enums);
+  }
+  return type;
+}
+
 //-- constructor methods
 
 /**
@@ -129,133 +249,915 @@ gstbt_osc_wave_create_stereo (GstBtOscWave * self, guint64 off, guint ct,
   return TRUE;
 }
 
+static void
+gstbt_osc_wave_init_sinc_table (void)
+{
+  gint p, j;
+  gdouble x, w, sum;
+
+  for (p = 0; p <= SINC_PHASES; p++) {
+    sum = 0.0;
+    for (j = 0; j < SINC_TAPS; j++) {
+      /* distance of the tap from the interpolated position */
+      x = (j - (SINC_TAPS / 2 - 1)) - (gdouble) p / SINC_PHASES;
+      w = 0.42 + 0.5 * cos (G_PI * x / (SINC_TAPS / 2)) +
+          0.08 * cos (2.0 * G_PI * x / (SINC_TAPS / 2));
+      sinc_table[p][j] = (x == 0.0) ? 1.0 : w * sin (G_PI * x) / (G_PI * x);
+      sum += sinc_table[p][j];
+    }
+    /* unity gain for DC */
+    for (j = 0; j < SINC_TAPS; j++) {
+      sinc_table[p][j] /= sum;
+    }
+  }
+}
+
+static void
+gstbt_osc_wave_init_mip_filter (void)
+{
+  gint j;
+  gdouble x, w, sum = 0.0;
+
+  for (j = 0; j < MIP_TAPS; j++) {
+    x = j - MIP_HALF;
+    w = 0.42 + 0.5 * cos (G_PI * x / (MIP_HALF + 1)) +
+        0.08 * cos (2.0 * G_PI * x / (MIP_HALF + 1));
+    mip_filter[j] = (x == 0.0) ? 0.5 : w * sin (G_PI * x / 2) / (G_PI * x);
+    sum += mip_filter[j];
+  }
+  /* unity gain for DC */
+  for (j = 0; j < MIP_TAPS; j++) {
+    mip_filter[j] /= sum;
+  }
+}
+
+/* lowpass filter and decimate the previous level, until the level gets too
+ * short or all levels exist */
+static void
+gstbt_osc_wave_build_mips (GstBtOscWaveData * wd)
+{
+  const guint ch = wd->channels;
+  const gint16 *src;
+  gint16 *dst;
+  guint64 j, frames, mip_frames;
+  gint64 k;
+  gfloat v;
+  guint c, l, m;
+
+  for (l = 1; l < GSTBT_OSC_WAVE_MAX_MIP_LEVELS; l++) {
+    src = wd->mip_data[l - 1];
+    frames = wd->mip_frames[l - 1];
+    mip_frames = (frames + 1) / 2;
+    if (mip_frames < MIP_MIN_FRAMES)
+      break;
+
+    dst = g_new (gint16, mip_frames * ch);
+    for (c = 0; c < ch; c++) {
+      for (j = 0; j < mip_frames; j++) {
+        v = 0.0f;
+        for (m = 0; m < MIP_TAPS; m++) {
+          k = (gint64) (2 * j + m) - MIP_HALF;
+          if (k >= 0 && k < frames)
+            v += mip_filter[m] * src[k * ch + c];
+        }
+        dst[j * ch + c] = (gint16) CLAMP (v, G_MININT16, G_MAXINT16);
+      }
+    }
+    wd->mip_data[l] = dst;
+    wd->mip_frames[l] = mip_frames;
+    wd->num_mips = l + 1;
+    GST_DEBUG ("built mip level %u with %" G_GUINT64_FORMAT " frames", l,
+        mip_frames);
+  }
+}
+
+static void
+gstbt_osc_wave_data_free (GstBtOscWaveData * wd)
+{
+  guint l;
+
+  for (l = 1; l < wd->num_mips; l++) {
+    g_free (wd->mip_data[l]);
+  }
+  /* only mapped waves have level 0 */
+  if (wd->num_mips) {
+    gst_buffer_unmap (wd->buffer, &wd->map_info);
+  }
+  if (wd->stream) {
+    gstbt_wave_stream_free (wd->stream);
+  }
+  if (wd->buffer) {
+    gst_buffer_unref (wd->buffer);
+  }
+  g_free (wd->id);
+  g_free (wd->key);
+  g_free (wd);
+}
+
 static gboolean
-gstbt_osc_wave_create_mono_resampled (GstBtOscWave * self, guint64 off,
-    guint ct, gint16 * dst)
+gstbt_osc_wave_data_map (GstBtOscWaveData * wd)
 {
-  if (!self->data) {
-    GST_DEBUG ("no wave buffer");
+  if (!gst_buffer_map (wd->buffer, &wd->map_info, GST_MAP_READ)) {
+    GST_WARNING ("unable to map buffer for read");
     return FALSE;
   }
-  const guint ss = sizeof (gint16);
-  guint size = self->map_info.size;
-  if (off * ss >= size) {
-    GST_DEBUG ("beyond size");
-    return FALSE;
+  wd->mip_data[0] = (gint16 *) wd->map_info.data;
+  wd->mip_frames[0] = wd->map_info.size / (wd->channels * sizeof (gint16));
+  wd->num_mips = 1;
+  return TRUE;
+}
+
+/* convert float samples to a new S16 buffer */
+static GstBuffer *
+gstbt_osc_wave_convert_f32 (GstBuffer * data)
+{
+  GstMapInfo info;
+  const gfloat *src;
+  gint16 *dst;
+  gsize i, n;
+
+  if (!gst_buffer_map (data, &info, GST_MAP_READ)) {
+    GST_WARNING ("unable to map buffer for read");
+    return NULL;
+  }
+  src = (const gfloat *) info.data;
+  n = info.size / sizeof (gfloat);
+  dst = g_new (gint16, n);
+  for (i = 0; i < n; i++) {
+    dst[i] = (gint16) CLAMP (src[i] * 32767.0f, G_MININT16, G_MAXINT16);
   }
+  gst_buffer_unmap (data, &info);
+  return gst_buffer_new_wrapped (dst, n * sizeof (gint16));
+}
 
-  gint16 *src = (gint16 *) self->map_info.data;
-  gdouble rate = self->rate;
-  guint64 s, d;
+/* Open the cache entry for streaming. If there is no entry yet, the wave from
+ * the wave-table is stored first. */
+static GstBtWaveStream *
+gstbt_osc_wave_open_stream (GstBtOscWaveData * wd)
+{
+  GstBtWaveCacheFormat format;
+  GstBuffer *cached;
+  guint64 size;
+  goffset offset;
+  guint channels;
+  gint fd;
 
-  for (d = 0; d < ct; d++) {
-    s = (off + d) * rate;
-    dst[d] = (s * ss < size) ? src[s] : 0;
+  if ((fd = gstbt_wave_cache_open (wd->key, &format, &channels, &size,
+              &offset)) == -1) {
+    if (!wd->buffer)
+      return NULL;
+    if (!(cached = gstbt_wave_cache_store (wd->key,
+                GSTBT_WAVE_CACHE_FORMAT_S16, wd->channels, wd->buffer)))
+      return NULL;
+    gst_buffer_unref (cached);
+    if ((fd = gstbt_wave_cache_open (wd->key, &format, &channels, &size,
+                &offset)) == -1)
+      return NULL;
+  }
+  if (channels != wd->channels) {
+    GST_WARNING ("cached wave %s has %u channels instead of %u", wd->key,
+        channels, wd->channels);
+    close (fd);
+    return NULL;
   }
+  size /= channels * ((format == GSTBT_WAVE_CACHE_FORMAT_F32) ?
+      sizeof (gfloat) : sizeof (gint16));
+  return gstbt_wave_stream_new (fd, offset, format, size, channels);
+}
 
-  return TRUE;
+/* Get the wave from the wave cache. If there is no entry yet, the wave from
+ * the wave-table is stored. An existing entry is never replaced, if it does
+ * not match the wave-table is used. */
+static GstBuffer *
+gstbt_osc_wave_load_cached (GstBtOscWaveData * wd)
+{
+  GstBtWaveCacheFormat format;
+  GstBuffer *cached, *res = NULL;
+  guint channels;
+
+  if ((cached = gstbt_wave_cache_lookup (wd->key, &format, &channels))) {
+    if (channels != wd->channels) {
+      GST_WARNING ("cached wave %s has %u channels instead of %u", wd->key,
+          channels, wd->channels);
+    } else if (format == GSTBT_WAVE_CACHE_FORMAT_F32) {
+      res = gstbt_osc_wave_convert_f32 (cached);
+    } else {
+      res = gst_buffer_ref (cached);
+    }
+    gst_buffer_unref (cached);
+  } else if (wd->buffer) {
+    res = gstbt_wave_cache_store (wd->key, GSTBT_WAVE_CACHE_FORMAT_S16,
+        wd->channels, wd->buffer);
+  }
+  return res;
+}
+
+static void
+gstbt_osc_wave_data_unref (GstBtOscWaveData * wd)
+{
+  gboolean last;
+
+  /* the lock keeps lookups from taking a reference meanwhile */
+  g_mutex_lock (&shared_waves_lock);
+  if ((last = g_atomic_int_dec_and_test (&wd->ref_count)) && wd->id) {
+    g_hash_table_remove (shared_waves, wd->id);
+  }
+  g_mutex_unlock (&shared_waves_lock);
+  if (last) {
+    gstbt_osc_wave_data_free (wd);
+  }
+}
+
+/* get the shared wave for @id, if another oscillator plays it already */
+static GstBtOscWaveData *
+gstbt_osc_wave_data_lookup (const gchar * id)
+{
+  GstBtOscWaveData *wd;
+
+  g_mutex_lock (&shared_waves_lock);
+  if ((wd = g_hash_table_lookup (shared_waves, id))) {
+    g_atomic_int_inc (&wd->ref_count);
+  }
+  g_mutex_unlock (&shared_waves_lock);
+  return wd;
+}
+
+/* Share the wave @buffer (can be %NULL for cached waves) under @id, takes
+ * ownership of @buffer. Waves with a cache @key are loaded by the loader
+ * thread, the others are ready right away. */
+static GstBtOscWaveData *
+gstbt_osc_wave_data_new (const gchar * id, const gchar * key,
+    GstBuffer * buffer, guint channels)
+{
+  GstBtOscWaveData *wd, *other;
+
+  wd = g_new0 (GstBtOscWaveData, 1);
+  wd->ref_count = 1;
+  wd->id = g_strdup (id);
+  wd->key = g_strdup (key);
+  wd->buffer = buffer;
+  wd->channels = channels;
+  if (!key) {
+    wd->state = gstbt_osc_wave_data_map (wd) ? WAVE_DATA_READY :
+        WAVE_DATA_FAILED;
+  }
+
+  /* another oscillator might have bound the same wave meanwhile */
+  g_mutex_lock (&shared_waves_lock);
+  if ((other = g_hash_table_lookup (shared_waves, id))) {
+    g_atomic_int_inc (&other->ref_count);
+  } else {
+    g_hash_table_insert (shared_waves, wd->id, wd);
+  }
+  g_mutex_unlock (&shared_waves_lock);
+  if (other) {
+    gstbt_osc_wave_data_free (wd);
+    return other;
+  }
+  if (wd->state == WAVE_DATA_LOADING) {
+    g_atomic_int_inc (&wd->ref_count);
+    g_thread_pool_push (loader, wd, NULL);
+  }
+  return wd;
+}
+
+/* Stream the cached wave @key, the wave @buffer (can be %NULL) is stored
+ * first if needed, takes ownership of @buffer. The stream is opened by the
+ * loader thread. */
+static GstBtOscWaveData *
+gstbt_osc_wave_data_new_stream (const gchar * key, GstBuffer * buffer,
+    guint channels)
+{
+  GstBtOscWaveData *wd;
+
+  wd = g_new0 (GstBtOscWaveData, 1);
+  wd->ref_count = 2;
+  wd->key = g_strdup (key);
+  wd->buffer = buffer;
+  wd->channels = channels;
+  wd->streaming = TRUE;
+  g_thread_pool_push (loader, wd, NULL);
+  return wd;
+}
+
+/* runs in the loader thread */
+static void
+gstbt_osc_wave_load (GstBtOscWaveData * wd, gpointer user_data)
+{
+  GstBuffer *data;
+  gint state;
+
+  if (g_atomic_int_get (&wd->state) == WAVE_DATA_LOADING) {
+    /* if the wave can't be streamed, it is mapped instead */
+    if (wd->streaming && (wd->stream = gstbt_osc_wave_open_stream (wd))) {
+      state = WAVE_DATA_READY;
+    } else {
+      if ((data = gstbt_osc_wave_load_cached (wd))) {
+        gst_buffer_replace (&wd->buffer, data);
+        gst_buffer_unref (data);
+      }
+      state = (wd->buffer && gstbt_osc_wave_data_map (wd)) ? WAVE_DATA_READY :
+          WAVE_DATA_FAILED;
+    }
+    g_atomic_int_set (&wd->state, state);
+  }
+  if (g_atomic_int_get (&wd->want_mips) &&
+      !g_atomic_int_get (&wd->has_mips) &&
+      g_atomic_int_get (&wd->state) == WAVE_DATA_READY) {
+    gstbt_osc_wave_build_mips (wd);
+    g_atomic_int_set (&wd->has_mips, TRUE);
+  }
+  gstbt_osc_wave_data_unref (wd);
+}
+
+/* pick the mip level for the current rate, if the levels are not ready yet,
+ * have them built and play the wave itself meanwhile */
+static void
+gstbt_osc_wave_select_mip (GstBtOscWave * self)
+{
+  GstBtOscWaveData *wd = self->shared;
+  gdouble level;
+  guint l;
+
+  self->mip_level = 0;
+  self->mip_fade = 0.0;
+  self->mip_pending = FALSE;
+  if (!self->mipmaps || self->rate <= 1.0)
+    return;
+
+  if (!g_atomic_int_get (&wd->has_mips)) {
+    if (g_atomic_int_compare_and_exchange (&wd->want_mips, FALSE, TRUE)) {
+      g_atomic_int_inc (&wd->ref_count);
+      g_thread_pool_push (loader, wd, NULL);
+    }
+    self->mip_pending = TRUE;
+    return;
+  }
+
+  /* without crossfading take the next lower level, so that the wave is
+   * not read faster than its rate */
+  level = log2 (self->rate);
+  l = (guint) (self->mip_crossfade ? floor (level) : ceil (level));
+  if (l >= wd->num_mips) {
+    l = wd->num_mips - 1;
+  } else if (self->mip_crossfade && l + 1 < wd->num_mips) {
+    self->mip_fade = (gfloat) (level - l);
+  }
+  self->mip_level = l;
+  GST_DEBUG ("using mip level %u, fade %f", l, self->mip_fade);
+}
+
+/* sample @i of channel @c, in the checked variant 0 outside of the wave */
+#define WAVE_SAMPLE(i) (checked ? \
+  (((guint64) (i) < frames) ? (gfloat) src[(i) * ch + c] : 0.0f) : \
+  (gfloat) src[(i) * ch + c])
+
+/* The interpolators get the position as 32.32 fixed point. If @checked is
+ * %FALSE the caller guarantees that all taps are inside the wave. */
+
+static inline gfloat
+gstbt_osc_wave_interpolate_none (const gint16 * src, guint ch, guint c,
+    guint64 frames, guint64 phase, gboolean checked)
+{
+  const gint64 i = (gint64) (phase >> 32);
+
+  return WAVE_SAMPLE (i);
+}
+
+static inline gfloat
+gstbt_osc_wave_interpolate_linear (const gint16 * src, guint ch, guint c,
+    guint64 frames, guint64 phase, gboolean checked)
+{
+  const gint64 i = (gint64) (phase >> 32);
+  const gfloat f = (gfloat) (phase & PHASE_MASK) * PHASE_SCALE;
+  const gfloat x0 = WAVE_SAMPLE (i);
+  const gfloat x1 = WAVE_SAMPLE (i + 1);
+
+  return x0 + f * (x1 - x0);
+}
+
+static inline gfloat
+gstbt_osc_wave_interpolate_cubic (const gint16 * src, guint ch, guint c,
+    guint64 frames, guint64 phase, gboolean checked)
+{
+  const gint64 i = (gint64) (phase >> 32);
+  const gfloat f = (gfloat) (phase & PHASE_MASK) * PHASE_SCALE;
+  const gfloat xm = WAVE_SAMPLE (i - 1);
+  const gfloat x0 = WAVE_SAMPLE (i);
+  const gfloat x1 = WAVE_SAMPLE (i + 1);
+  const gfloat x2 = WAVE_SAMPLE (i + 2);
+  const gfloat c1 = 0.5f * (x1 - xm);
+  const gfloat c2 = xm - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+  const gfloat c3 = 0.5f * (x2 - xm) + 1.5f * (x0 - x1);
+
+  return ((c3 * f + c2) * f + c1) * f + x0;
+}
+
+static inline gfloat
+gstbt_osc_wave_interpolate_sinc (const gint16 * src, guint ch, guint c,
+    guint64 frames, guint64 phase, gboolean checked)
+{
+  const gint64 i = (gint64) (phase >> 32) - (SINC_TAPS / 2 - 1);
+  const gfloat *h =
+      sinc_table[(phase & PHASE_MASK) >> (32 - SINC_PHASE_BITS)];
+  gfloat v = 0.0f;
+  guint j;
+
+  for (j = 0; j < SINC_TAPS; j++) {
+    v += h[j] * WAVE_SAMPLE (i + j);
+  }
+  return v;
+}
+
+#undef WAVE_SAMPLE
+
+/* number of steps from @phase that stay below @limit, at most @ct */
+static inline guint
+gstbt_osc_wave_steps_below (guint64 phase, guint64 step, guint64 limit,
+    guint ct)
+{
+  if (phase >= limit)
+    return 0;
+  return (guint) MIN ((limit - phase + step - 1) / step, ct);
+}
+
+/* Run @fn over the block: the head and the end of the wave need bounds
+ * checks, the bulk in between is branch-free and behind the wave is silence.
+ */
+#define INTERPOLATE_BLOCK(fn) G_STMT_START { \
+  for (d = 0; d < d_head; d++) \
+    out[d] = fn (src, ch, c, frames, phase + d * step, TRUE); \
+  for (; d < d_bulk; d++) \
+    out[d] = fn (src, ch, c, frames, phase + d * step, FALSE); \
+  for (; d < d_tail; d++) \
+    out[d] = fn (src, ch, c, frames, phase + d * step, TRUE); \
+  memset (&out[d], 0, (ct - d) * sizeof (gfloat)); \
+} G_STMT_END
+
+/* Interpolate @ct samples of channel @c from @src with @frames frames. The
+ * first sample is at @phase, @step is the increment, both are 32.32 fixed
+ * point. */
+static void
+gstbt_osc_wave_interpolate (GstBtOscWave * self, const gint16 * src,
+    guint64 frames, guint64 step, guint64 phase, guint ct, guint c,
+    gfloat * out)
+{
+  const guint ch = self->channels;
+  guint before, after, d, d_head, d_bulk, d_tail;
+
+  /* taps before and after the position */
+  switch (self->interpolation) {
+    case GSTBT_OSC_WAVE_INTERPOLATION_LINEAR:
+      before = 0;
+      after = 1;
+      break;
+    case GSTBT_OSC_WAVE_INTERPOLATION_CUBIC:
+      before = 1;
+      after = 2;
+      break;
+    case GSTBT_OSC_WAVE_INTERPOLATION_SINC:
+      before = SINC_TAPS / 2 - 1;
+      after = SINC_TAPS / 2;
+      break;
+    default:
+      before = after = 0;
+      break;
+  }
+  /* the block boundaries are computed once instead of checking each tap */
+  d_head = gstbt_osc_wave_steps_below (phase, step, (guint64) before << 32, ct);
+  d_bulk = (frames > after) ?
+      gstbt_osc_wave_steps_below (phase, step, (frames - after) << 32, ct) : 0;
+  d_bulk = MAX (d_bulk, d_head);
+  d_tail = gstbt_osc_wave_steps_below (phase, step, (frames + before) << 32,
+      ct);
+  d_tail = MAX (d_tail, d_bulk);
+
+  switch (self->interpolation) {
+    case GSTBT_OSC_WAVE_INTERPOLATION_NONE:
+      INTERPOLATE_BLOCK (gstbt_osc_wave_interpolate_none);
+      break;
+    case GSTBT_OSC_WAVE_INTERPOLATION_LINEAR:
+      INTERPOLATE_BLOCK (gstbt_osc_wave_interpolate_linear);
+      break;
+    case GSTBT_OSC_WAVE_INTERPOLATION_CUBIC:
+      INTERPOLATE_BLOCK (gstbt_osc_wave_interpolate_cubic);
+      break;
+    case GSTBT_OSC_WAVE_INTERPOLATION_SINC:
+      INTERPOLATE_BLOCK (gstbt_osc_wave_interpolate_sinc);
+      break;
+  }
+}
+
+#undef INTERPOLATE_BLOCK
+
+/* position of frame @p of the endlessly looped wave in the wave */
+static inline gint64
+gstbt_osc_wave_fold (GstBtOscWave * self, gint64 p)
+{
+  const gboolean pingpong =
+      (self->loop_mode == GSTBT_OSC_WAVE_LOOP_PINGPONG);
+  const gint64 start = (gint64) self->loop_start;
+  const gint64 len = (gint64) self->loop_end - (pingpong ? 1 : 0) - start;
+  const gint64 period = pingpong ? 2 * len : len;
+  gint64 u = (p - start) % period;
+
+  if (u < 0)
+    u += period;
+  return (u <= len) ? start + u : start + period - u;
+}
+
+/* sample of channel @c at frame @p of the wave in mip level @l, the frame
+ * does not need to be on the grid of the level */
+static inline gfloat
+gstbt_osc_wave_level_sample (const gint16 * src, guint64 frames, guint ch,
+    guint c, guint l, gint64 p)
+{
+  const gint64 i = p >> l;
+  const gfloat f = (gfloat) (p & ((1 << l) - 1)) / (gfloat) (1 << l);
+  const gfloat x0 = ((guint64) i < frames) ? (gfloat) src[i * ch + c] : 0.0f;
+  const gfloat x1 =
+      ((guint64) (i + 1) < frames) ? (gfloat) src[(i + 1) * ch + c] : 0.0f;
+
+  return x0 + f * (x1 - x0);
+}
+
+/* first frame of the guard of level @l for the loop point @edge */
+#define GUARD_BASE(edge, l) ((gint64) ((edge) >> (l)) - 2 * GUARD_HALF)
+
+/* Fill the guards of mip level @l. Around the loop start the wave continues
+ * with the end of the loop (or mirrored for ping-pong loops), around the turn
+ * the loop starts over. Before the loop start the wave is the original, as
+ * this is only read on the first pass. */
+static void
+gstbt_osc_wave_build_loop_guards (GstBtOscWave * self, const gint16 * src,
+    guint64 frames, guint l)
+{
+  const guint ch = self->channels;
+  const gint64 start = (gint64) self->loop_start;
+  const gint64 turn = (gint64) self->loop_end -
+      (self->loop_mode == GSTBT_OSC_WAVE_LOOP_PINGPONG ? 1 : 0);
+  gint16 *guard = &self->loop_guards[l * 2 * GUARD_FRAMES * ch];
+  gint64 p;
+  guint c, j;
+
+  for (j = 0; j < 2 * GUARD_FRAMES; j++) {
+    if (j < GUARD_FRAMES) {
+      p = (GUARD_BASE (start, l) + j) * (1 << l);
+      p = gstbt_osc_wave_fold (self, p);
+    } else {
+      p = (GUARD_BASE (turn, l) + j - GUARD_FRAMES) * (1 << l);
+      if (p >= start)
+        p = gstbt_osc_wave_fold (self, p);
+    }
+    for (c = 0; c < ch; c++) {
+      guard[j * ch + c] = (gint16) lrintf (gstbt_osc_wave_level_sample (src,
+              frames, ch, c, l, p));
+    }
+  }
+  self->loop_guard_levels |= 1 << l;
+}
+
+/* Render @ct samples of channel @c from mip level @l of a looped wave. The
+ * unlooped read position is split into runs that don't cross a loop boundary.
+ * Each run is a plain forward (or for the way back of a ping-pong loop, a
+ * reversed) read, thus the wrapping costs nothing per sample. Runs close to
+ * a loop point are read from the loop guards, so that the taps of the
+ * interpolation see the looped wave. */
+static void
+gstbt_osc_wave_render_looped (GstBtOscWave * self, const gint16 * src,
+    guint64 frames, guint l, guint64 off, guint ct, guint c, gfloat * out)
+{
+  const guint ch = self->channels;
+  const guint64 step = self->step;
+  const gboolean pingpong =
+      (self->loop_mode == GSTBT_OSC_WAVE_LOOP_PINGPONG);
+  const guint64 start = self->loop_start << 32;
+  /* in ping-pong mode the wave turns at the last sample of the loop */
+  const guint64 turn = (self->loop_end << 32) - (pingpong ? PHASE_ONE : 0);
+  const guint64 len = turn - start;
+  const gboolean copy = (step == PHASE_ONE && l == 0);
+  /* distance from the loop points that is read from the guards */
+  const guint64 reach = (guint64) GUARD_HALF << (32 + l);
+  const gint16 *guards = NULL, *guard;
+  guint64 v = off * step, u, pos, left, lo, edge;
+  gboolean backwards;
+  guint d, k, m;
+  gfloat t;
+
+  if (!copy) {
+    if (!(self->loop_guard_levels & (1 << l)))
+      gstbt_osc_wave_build_loop_guards (self, src, frames, l);
+    guards = &self->loop_guards[l * 2 * GUARD_FRAMES * ch];
+  }
+
+  for (d = 0; d < ct; d += m, v += m * step) {
+    backwards = FALSE;
+    if (v < turn) {
+      pos = v;
+      left = turn - v;
+    } else {
+      u = (v - start) % (pingpong ? 2 * len : len);
+      if (u < len) {
+        pos = start + u;
+        left = len - u;
+      } else {
+        pos = turn - (u - len);
+        left = 2 * len - u;
+        backwards = TRUE;
+      }
+    }
+    /* split the run where it enters or leaves the reach of a guard */
+    guard = NULL;
+    edge = 0;
+    if (!copy) {
+      if (!backwards) {
+        if (v >= turn && pos < start + reach) {
+          guard = guards;
+          edge = start;
+          left = MIN (left, start + reach - pos);
+        } else if (pos + reach >= turn) {
+          guard = &guards[GUARD_FRAMES * ch];
+          edge = turn;
+        } else {
+          left = MIN (left, turn - reach - pos);
+        }
+      } else {
+        if (pos + reach >= turn) {
+          guard = &guards[GUARD_FRAMES * ch];
+          edge = turn;
+          left = MIN (left, pos - (turn - reach) + 1);
+        } else if (pos < start + reach) {
+          guard = guards;
+          edge = start;
+        } else {
+          left = MIN (left, pos - (start + reach) + 1);
+        }
+      }
+    }
+    m = (guint) MIN ((left + step - 1) / step, ct - d);
+
+    if (copy) {
+      const gint16 *s = &src[(pos >> 32) * ch + c];
+
+      if (!backwards) {
+        for (k = 0; k < m; k++)
+          out[d + k] = (gfloat) s[k * ch];
+      } else {
+        for (k = 0; k < m; k++)
+          out[d + k] = (gfloat) s[-(gint64) (k * ch)];
+      }
+      continue;
+    }
+
+    /* a backwards run is rendered forwards and reversed */
+    lo = backwards ? pos - (m - 1) * step : pos;
+    if (guard) {
+      gstbt_osc_wave_interpolate (self, guard, GUARD_FRAMES, step >> l,
+          (lo >> l) - (guint64) GUARD_BASE (edge >> 32, l) * PHASE_ONE, m, c,
+          &out[d]);
+    } else {
+      gstbt_osc_wave_interpolate (self, src, frames, step >> l, lo >> l, m, c,
+          &out[d]);
+    }
+    if (backwards) {
+      for (k = 0; k < m / 2; k++) {
+        t = out[d + k];
+        out[d + k] = out[d + m - 1 - k];
+        out[d + m - 1 - k] = t;
+      }
+    }
+  }
+}
+
+#undef GUARD_BASE
+
+/* Render @ct samples of channel @c from mip level @l */
+static void
+gstbt_osc_wave_render_level (GstBtOscWave * self, guint l, guint64 off,
+    guint ct, guint c, gfloat * out)
+{
+  const gint16 *src = self->shared->mip_data[l];
+  const guint64 frames = self->shared->mip_frames[l];
+  const guint64 step = self->step >> l;
+
+  if (self->loop_mode != GSTBT_OSC_WAVE_LOOP_OFF) {
+    gstbt_osc_wave_render_looped (self, src, frames, l, off, ct, c, out);
+  } else {
+    gstbt_osc_wave_interpolate (self, src, frames, step, off * step, ct, c,
+        out);
+  }
 }
 
 static gboolean
-gstbt_osc_wave_create_stereo_resampled (GstBtOscWave * self, guint64 off,
-    guint ct, gint16 * dst)
+gstbt_osc_wave_create_resampled (GstBtOscWave * self, guint64 off, guint ct,
+    gint16 * dst)
 {
   if (!self->data) {
     GST_DEBUG ("no wave buffer");
     return FALSE;
   }
-  const guint ss = 2 * sizeof (gint16);
-  guint size = self->map_info.size;
-  if (off * ss >= size) {
+  const guint ch = self->channels;
+  const guint64 frames = self->map_info.size / (ch * sizeof (gint16));
+  if (self->loop_mode == GSTBT_OSC_WAVE_LOOP_OFF && off * self->rate >= frames) {
     GST_DEBUG ("beyond size");
     return FALSE;
   }
 
-  gint16 *src = (gint16 *) self->map_info.data;
-  gdouble rate = self->rate;
-  guint64 s, d;
-
-  for (d = 0; d < ct; d++) {
-    s = (off + d) * rate;
-    if (s * ss < size) {
-      dst[d << 1] = src[(s << 1)];
-      dst[(d << 1) + 1] = src[(s << 1) + 1];
-    } else {
-      dst[d << 1] = 0;
-      dst[(d << 1) + 1] = 0;
+  gfloat buf[RESAMPLE_BLOCK], buf2[RESAMPLE_BLOCK];
+  guint c, d, n, l;
+  gfloat fade;
+
+  if (G_UNLIKELY (self->mip_pending) &&
+      g_atomic_int_get (&self->shared->has_mips)) {
+    gstbt_osc_wave_select_mip (self);
+  }
+  l = self->mip_level;
+  fade = self->mip_fade;
+
+  for (; ct; ct -= n, off += n, dst += n * ch) {
+    n = MIN (ct, RESAMPLE_BLOCK);
+    for (c = 0; c < ch; c++) {
+      gstbt_osc_wave_render_level (self, l, off, n, c, buf);
+      if (fade > 0.0) {
+        gstbt_osc_wave_render_level (self, l + 1, off, n, c, buf2);
+        for (d = 0; d < n; d++) {
+          buf[d] += fade * (buf2[d] - buf[d]);
+        }
+      }
+      for (d = 0; d < n; d++) {
+        dst[d * ch + c] = (gint16) CLAMP (buf[d], G_MININT16, G_MAXINT16);
+      }
     }
   }
 
   return TRUE;
 }
 
-/**
- * gstbt_osc_wave_setup:
- * @self: the oscillator
- *
- * Prepare the oscillator. Should be called before first use to ensure it is
- * configured for the default parameters.
- */
-void
-gstbt_osc_wave_setup (GstBtOscWave * self)
+static void
+gstbt_osc_wave_release (GstBtOscWave * self)
+{
+  if (self->shared) {
+    gstbt_osc_wave_data_unref (self->shared);
+    self->shared = NULL;
+    self->data = NULL;
+    self->stream = NULL;
+    self->stream_failed = FALSE;
+    self->mip_level = 0;
+    self->mip_fade = 0.0;
+    self->mip_pending = FALSE;
+    g_free (self->loop_guards);
+    self->loop_guards = NULL;
+    self->loop_guard_levels = 0;
+  }
+}
+
+/* fetch and map the wave for the current wave and wave-level */
+static void
+gstbt_osc_wave_bind (GstBtOscWave * self)
 {
   gpointer *cb = self->wave_callbacks;
   GstStructure *(*get_wave_buffer) (gpointer, guint, guint);
   GstStructure *s;
   GstBtNote root_note;
+  GstBuffer *data = NULL;
+  const gchar *key;
+  gchar *id;
+  gint loop_mode;
 
-  if (!cb) {
-    return;
-  }
-  if (self->data) {
-    gst_buffer_unmap (self->data, &self->map_info);
-    gst_buffer_unref (self->data);
-    self->data = NULL;
-  }
+  gstbt_osc_wave_release (self);
+  self->loop_mode = GSTBT_OSC_WAVE_LOOP_OFF;
+  self->bound = TRUE;
   get_wave_buffer = cb[1];
   if (!(s = get_wave_buffer (cb[0], self->wave, self->wave_level)))
     return;
 
   gst_structure_get (s,
       "channels", G_TYPE_INT, &self->channels,
-      "root-note", GSTBT_TYPE_NOTE, &root_note,
-      "buffer", GST_TYPE_BUFFER, &self->data, NULL);
+      "root-note", GSTBT_TYPE_NOTE, &root_note, NULL);
 
-  if (!self->data) {
+  key = gst_structure_get_string (s, "cache-key");
+  self->root_freq =
+      gstbt_tone_conversion_translate_from_number (self->n2f, root_note);
+
+  gst_structure_get (s, "buffer", GST_TYPE_BUFFER, &data, NULL);
+
+  /* stream long waves from the wave cache instead of mapping them */
+  if (self->streaming && key) {
+    self->shared = gstbt_osc_wave_data_new_stream (key, data, self->channels);
     return;
   }
 
-  if (!gst_buffer_map (self->data, &self->map_info, GST_MAP_READ)) {
-    GST_WARNING_OBJECT (self, "unable to map buffer for read");
+  /* waves are shared by their cache key or else by their buffer */
+  if (key) {
+    id = g_strdup (key);
+  } else if (data) {
+    id = g_strdup_printf ("buffer:%p", data);
+  } else {
+    return;
+  }
+  if ((self->shared = gstbt_osc_wave_data_lookup (id))) {
+    if (data)
+      gst_buffer_unref (data);
+  } else {
+    self->shared = gstbt_osc_wave_data_new (id, key, data, self->channels);
+  }
+  g_free (id);
+
+  /* optional loop, checked against the wave once it is loaded */
+  if (!gst_structure_get_int (s, "loop-mode", &loop_mode) ||
+      !gst_structure_get_uint64 (s, "loop-start", &self->loop_start) ||
+      !gst_structure_get_uint64 (s, "loop-end", &self->loop_end)) {
+    loop_mode = GSTBT_OSC_WAVE_LOOP_OFF;
+  }
+  self->loop_mode = loop_mode;
+}
+
+/* take the wave from the shared data once it is loaded */
+static gboolean
+gstbt_osc_wave_adopt (GstBtOscWave * self)
+{
+  GstBtOscWaveData *wd = self->shared;
+  guint64 frames;
+
+  if (self->data || self->stream)
+    return TRUE;
+  if (!wd || g_atomic_int_get (&wd->state) != WAVE_DATA_READY)
+    return FALSE;
+
+  if (wd->stream) {
+    self->stream = wd->stream;
+    GST_INFO ("streaming wave with %d channels", self->channels);
+    return TRUE;
+  }
+  self->data = wd->buffer;
+  self->map_info = wd->map_info;
+
+  frames = wd->mip_frames[0];
+  if (self->loop_mode != GSTBT_OSC_WAVE_LOOP_OFF) {
+    self->loop_end = MIN (self->loop_end, frames);
+    /* a ping-pong loop needs two samples to turn around */
+    if (self->loop_start + (self->loop_mode ==
+            GSTBT_OSC_WAVE_LOOP_PINGPONG ? 1 : 0) >= self->loop_end) {
+      GST_WARNING ("ignoring empty loop %" G_GUINT64_FORMAT " ... %"
+          G_GUINT64_FORMAT, self->loop_start, self->loop_end);
+      self->loop_mode = GSTBT_OSC_WAVE_LOOP_OFF;
+    } else {
+      self->loop_guards = g_new (gint16,
+          GSTBT_OSC_WAVE_MAX_MIP_LEVELS * 2 * GUARD_FRAMES * self->channels);
+      self->loop_guard_levels = 0;
+    }
+  }
+
+  GST_WARNING ("got wave with %d channels", self->channels);
+  return TRUE;
+}
+
+static gboolean
+gstbt_osc_wave_create_streamed (GstBtOscWave * self, guint64 off, guint ct,
+    gint16 * dst)
+{
+  return gstbt_wave_stream_read (self->stream, off, ct, dst);
+}
+
+/* update the playback rate of the bound wave for the current frequency */
+static void
+gstbt_osc_wave_update_rate (GstBtOscWave * self)
+{
+  if (self->stream) {
+    /* streamed waves are played at their original rate */
+    self->rate = 1.0;
+    self->step = PHASE_ONE;
+    self->duration = gstbt_wave_stream_get_frames (self->stream);
+    self->process = gstbt_osc_wave_create_streamed;
     return;
   }
 
   if (self->freq > 0.0) {
-    gdouble freq =
-        gstbt_tone_conversion_translate_from_number (self->n2f, root_note);
-    self->rate = freq / self->freq;
+    self->rate = self->root_freq / self->freq;
   } else {
     self->rate = 1.0;
   }
+  self->rate = CLAMP (self->rate, MIN_RATE, MAX_RATE);
+  self->step = MAX ((guint64) (self->rate * PHASE_ONE + 0.5), 1);
 
-  GST_WARNING ("got wave with %d channels", self->channels);
+  gstbt_osc_wave_select_mip (self);
 
   self->duration = self->map_info.size / (self->rate * sizeof (gint16));
 
   switch (self->channels) {
     case 1:
-      if (self->rate == 1.0) {
+      if (self->rate == 1.0 && self->loop_mode == GSTBT_OSC_WAVE_LOOP_OFF) {
         self->process = gstbt_osc_wave_create_mono;
       } else {
-        self->process = gstbt_osc_wave_create_mono_resampled;
+        self->process = gstbt_osc_wave_create_resampled;
       }
       break;
     case 2:
       self->duration >>= 1;
-      if (self->rate == 1.0) {
+      if (self->rate == 1.0 && self->loop_mode == GSTBT_OSC_WAVE_LOOP_OFF) {
         self->process = gstbt_osc_wave_create_stereo;
       } else {
-        self->process = gstbt_osc_wave_create_stereo_resampled;
+        self->process = gstbt_osc_wave_create_resampled;
       }
       break;
     default:
@@ -263,12 +1165,96 @@ gstbt_osc_wave_setup (GstBtOscWave * self)
       break;
   }
 
-  GST_WARNING ("duration at rate %lf is %" G_GUINT64_FORMAT, self->rate,
+  GST_DEBUG ("duration at rate %lf is %" G_GUINT64_FORMAT, self->rate,
       self->duration);
 }
 
+/* installed as the process function while the wave is not bound, binds the
+ * wave on first use */
+static gboolean
+gstbt_osc_wave_create_unbound (GstBtOscWave * self, guint64 off, guint ct,
+    gint16 * dst)
+{
+  gstbt_osc_wave_setup (self);
+  if ((!self->data && !self->stream) ||
+      self->process == gstbt_osc_wave_create_unbound)
+    return FALSE;
+  return self->process (self, off, ct, dst);
+}
+
+/* installed as the process function while the shared wave is loaded, plays
+ * silence until it is ready */
+static gboolean
+gstbt_osc_wave_create_loading (GstBtOscWave * self, guint64 off, guint ct,
+    gint16 * dst)
+{
+  if (!gstbt_osc_wave_adopt (self))
+    return FALSE;
+  gstbt_osc_wave_update_rate (self);
+  return self->process (self, off, ct, dst);
+}
+
+/* the wave identity changed, drop the wave and bind the new one on demand */
+static void
+gstbt_osc_wave_unbind (GstBtOscWave * self)
+{
+  gstbt_osc_wave_release (self);
+  self->bound = FALSE;
+  self->process = self->wave_callbacks ? gstbt_osc_wave_create_unbound : NULL;
+}
+
+/**
+ * gstbt_osc_wave_setup:
+ * @self: the oscillator
+ *
+ * Prepare the oscillator. Should be called before first use to ensure it is
+ * configured for the default parameters.
+ *
+ * The wave is only fetched again if the wave or wave-level has changed since
+ * the last call, otherwise just the playback rate is updated. Cached waves
+ * are loaded in the background, the oscillator is silent until then.
+ */
+void
+gstbt_osc_wave_setup (GstBtOscWave * self)
+{
+  if (!self->wave_callbacks) {
+    return;
+  }
+  if (!self->bound) {
+    gstbt_osc_wave_bind (self);
+  }
+  if (gstbt_osc_wave_adopt (self)) {
+    gstbt_osc_wave_update_rate (self);
+  } else if (self->shared) {
+    self->process = gstbt_osc_wave_create_loading;
+  }
+}
+
 //-- public methods
 
+/**
+ * gstbt_osc_wave_take_stream_error:
+ * @self: the oscillator
+ *
+ * Check if reading the streamed wave has failed. The stream is silent from
+ * then on. The error is only returned once, the element should post it with
+ * GST_ELEMENT_WARNING().
+ *
+ * Returns: the errno of the failed read or 0
+ */
+gint
+gstbt_osc_wave_take_stream_error (GstBtOscWave * self)
+{
+  gint err;
+
+  if (!self->stream || self->stream_failed)
+    return 0;
+  if ((err = gstbt_wave_stream_get_error (self->stream))) {
+    self->stream_failed = TRUE;
+  }
+  return err;
+}
+
 //-- virtual methods
 
 static void
@@ -280,23 +1266,53 @@ gstbt_osc_wave_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_WAVE_CALLBACKS:
       self->wave_callbacks = g_value_get_pointer (value);
-      gstbt_osc_wave_setup (self);
+      gstbt_osc_wave_unbind (self);
       break;
-    case PROP_WAVE:
-      //GST_INFO("change wave %u -> %u",g_value_get_uint (value),self->wave);
-      self->wave = g_value_get_uint (value);
-      gstbt_osc_wave_setup (self);
+    case PROP_WAVE:{
+      guint wave = g_value_get_uint (value);
+      //GST_INFO("change wave %u -> %u",wave,self->wave);
+      if (wave != self->wave) {
+        self->wave = wave;
+        gstbt_osc_wave_unbind (self);
+      }
       break;
-    case PROP_WAVE_LEVEL:
-      //GST_INFO("change wave-level %u -> %u",g_value_get_uint (value),self->wave_level);
-      self->wave_level = g_value_get_uint (value);
-      gstbt_osc_wave_setup (self);
+    }
+    case PROP_WAVE_LEVEL:{
+      guint wave_level = g_value_get_uint (value);
+      //GST_INFO("change wave-level %u -> %u",wave_level,self->wave_level);
+      if (wave_level != self->wave_level) {
+        self->wave_level = wave_level;
+        gstbt_osc_wave_unbind (self);
+      }
       break;
+    }
     case PROP_FREQUENCY:
       //GST_INFO("change frequency %lf -> %lf",g_value_get_double (value),self->freq);
       self->freq = g_value_get_double (value);
-      gstbt_osc_wave_setup (self);
+      if (self->data || self->stream)
+        gstbt_osc_wave_update_rate (self);
+      break;
+    case PROP_INTERPOLATION:
+      self->interpolation = g_value_get_enum (value);
+      break;
+    case PROP_MIPMAPS:
+      self->mipmaps = g_value_get_boolean (value);
+      if (self->data)
+        gstbt_osc_wave_select_mip (self);
       break;
+    case PROP_MIP_CROSSFADE:
+      self->mip_crossfade = g_value_get_boolean (value);
+      if (self->data)
+        gstbt_osc_wave_select_mip (self);
+      break;
+    case PROP_STREAMING:{
+      gboolean streaming = g_value_get_boolean (value);
+      if (streaming != self->streaming) {
+        self->streaming = streaming;
+        gstbt_osc_wave_unbind (self);
+      }
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -322,7 +1338,21 @@ gstbt_osc_wave_get_property (GObject * object, guint prop_id,
     case PROP_FREQUENCY:
       g_value_set_double (value, self->freq);
       break;
+    case PROP_INTERPOLATION:
+      g_value_set_enum (value, self->interpolation);
+      break;
+    case PROP_MIPMAPS:
+      g_value_set_boolean (value, self->mipmaps);
+      break;
+    case PROP_MIP_CROSSFADE:
+      g_value_set_boolean (value, self->mip_crossfade);
+      break;
+    case PROP_STREAMING:
+      g_value_set_boolean (value, self->streaming);
+      break;
     case PROP_DURATION:
+      if (!self->bound)
+        gstbt_osc_wave_setup (self);
       g_value_set_uint64 (value, self->duration);
       break;
     default:
@@ -342,10 +1372,7 @@ gstbt_osc_wave_dispose (GObject * object)
 
   if (self->n2f)
     g_object_unref (self->n2f);
-  if (self->data) {
-    gst_buffer_unmap (self->data, &self->map_info);
-    gst_buffer_unref (self->data);
-  }
+  gstbt_osc_wave_release (self);
 
   G_OBJECT_CLASS (gstbt_osc_wave_parent_class)->dispose (object);
 }
@@ -356,6 +1383,8 @@ gstbt_osc_wave_init (GstBtOscWave * self)
   self->wave = 1;
   self->freq = 0.0;
   self->rate = 1.0;
+  self->interpolation = GSTBT_OSC_WAVE_INTERPOLATION_LINEAR;
+  self->mipmaps = TRUE;
   self->n2f =
       gstbt_tone_conversion_new (GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
 }
@@ -368,6 +1397,12 @@ gstbt_osc_wave_class_init (GstBtOscWaveClass * klass)
   GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "osc-wave",
       GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "wavetable oscillator");
 
+  gstbt_osc_wave_init_sinc_table ();
+  gstbt_osc_wave_init_mip_filter ();
+  shared_waves = g_hash_table_new (g_str_hash, g_str_equal);
+  loader = g_thread_pool_new ((GFunc) gstbt_osc_wave_load, NULL, 1, FALSE,
+      NULL);
+
   gobject_class->set_property = gstbt_osc_wave_set_property;
   gobject_class->get_property = gstbt_osc_wave_get_property;
   gobject_class->dispose = gstbt_osc_wave_dispose;
@@ -392,6 +1427,28 @@ gstbt_osc_wave_class_init (GstBtOscWaveClass * klass)
           "Frequency of tone (0.0 for original)", 0.0, G_MAXDOUBLE, 0.0,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation mode for playing the wave at a different pitch",
+          GSTBT_TYPE_OSC_WAVE_INTERPOLATION,
+          GSTBT_OSC_WAVE_INTERPOLATION_LINEAR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIPMAPS,
+      g_param_spec_boolean ("mipmaps", "Mipmaps",
+          "Use band-limited copies of the wave when playing at a higher pitch",
+          TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIP_CROSSFADE,
+      g_param_spec_boolean ("mip-crossfade", "Mip crossfade",
+          "Crossfade between the two closest band-limited copies", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STREAMING,
+      g_param_spec_boolean ("streaming", "Streaming",
+          "Read the wave from the wave cache while playing instead of keeping "
+          "it in memory", FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_DURATION,
       g_param_spec_uint64 ("duration", "Duration",
           "Duration in samples at the given rate", 0, G_MAXUINT64, 0,
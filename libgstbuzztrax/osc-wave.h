@@ -22,9 +22,47 @@
 
 #include <gst/gst.h>
 #include <libgstbuzztrax/toneconversion.h>
+#include <libgstbuzztrax/wave-stream.h>
 
 G_BEGIN_DECLS
 
+#define GSTBT_TYPE_OSC_WAVE_INTERPOLATION (gstbt_osc_wave_interpolation_get_type())
+
+/**
+ * GstBtOscWaveInterpolation:
+ * @GSTBT_OSC_WAVE_INTERPOLATION_NONE: use the previous sample
+ * @GSTBT_OSC_WAVE_INTERPOLATION_LINEAR: linear interpolation
+ * @GSTBT_OSC_WAVE_INTERPOLATION_CUBIC: 4-point cubic hermite interpolation
+ * @GSTBT_OSC_WAVE_INTERPOLATION_SINC: 8-point windowed sinc interpolation
+ *
+ * Interpolation modes for playing waves at a different pitch.
+ */
+typedef enum
+{
+  GSTBT_OSC_WAVE_INTERPOLATION_NONE,
+  GSTBT_OSC_WAVE_INTERPOLATION_LINEAR,
+  GSTBT_OSC_WAVE_INTERPOLATION_CUBIC,
+  GSTBT_OSC_WAVE_INTERPOLATION_SINC
+} GstBtOscWaveInterpolation;
+
+GType gstbt_osc_wave_interpolation_get_type(void);
+
+/**
+ * GstBtOscWaveLoopMode:
+ * @GSTBT_OSC_WAVE_LOOP_OFF: play the wave once
+ * @GSTBT_OSC_WAVE_LOOP_FORWARD: jump back to the loop start at the loop end
+ * @GSTBT_OSC_WAVE_LOOP_PINGPONG: alternate between playing the loop forwards
+ *   and backwards
+ *
+ * Loop modes as given in the "loop-mode" field of the wave structure.
+ */
+typedef enum
+{
+  GSTBT_OSC_WAVE_LOOP_OFF = 0,
+  GSTBT_OSC_WAVE_LOOP_FORWARD,
+  GSTBT_OSC_WAVE_LOOP_PINGPONG
+} GstBtOscWaveLoopMode;
+
 #define GSTBT_TYPE_OSC_WAVE            (gstbt_osc_wave_get_type())
 #define GSTBT_OSC_WAVE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_OSC_WAVE,GstBtOscWave))
 #define GSTBT_IS_OSC_WAVE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_OSC_WAVE))
@@ -32,8 +70,11 @@ G_BEGIN_DECLS
 #define GSTBT_IS_OSC_WAVE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_OSC_WAVE))
 #define GSTBT_OSC_WAVE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_OSC_WAVE,GstBtOscWaveClass))
 
+#define GSTBT_OSC_WAVE_MAX_MIP_LEVELS 8
+
 typedef struct _GstBtOscWave GstBtOscWave;
 typedef struct _GstBtOscWaveClass GstBtOscWaveClass;
+typedef struct _GstBtOscWaveData GstBtOscWaveData;
 
 /**
  * GstBtOscWave:
@@ -49,15 +90,32 @@ struct _GstBtOscWave {
   gpointer *wave_callbacks;
   guint wave, wave_level;
   gdouble freq;
+  GstBtOscWaveInterpolation interpolation;
+  gboolean mipmaps, mip_crossfade;
+  gboolean streaming;
 
   /* oscillator state */
   GstBtToneConversion *n2f;
-  GstBuffer *data;
+  GstBtOscWaveData *shared;     /* wave and mip levels, shared per wave */
+  GstBuffer *data;              /* the wave from shared, mapped to map_info */
   GstMapInfo map_info;
+  GstBtWaveStream *stream;      /* the stream from shared */
+  gboolean stream_failed;       /* reading the stream failed */
+  gboolean bound;               /* data matches wave and wave-level */
   gint channels;
+  gdouble root_freq;
+  GstBtOscWaveLoopMode loop_mode;
+  guint64 loop_start, loop_end; /* in frames */
+  gint16 *loop_guards;          /* the looped wave around the loop points */
+  guint loop_guard_levels;      /* mip levels that have guards, as bits */
   gdouble rate;
+  guint64 step;                 /* rate as 32.32 fixed point */
   guint64 duration;
 
+  guint mip_level;
+  gfloat mip_fade;              /* crossfade to the next level */
+  gboolean mip_pending;         /* the mip levels are still being built */
+
   /* < private > */
   gboolean (*process) (GstBtOscWave *, guint64, guint, gint16 *);  
 };
@@ -67,6 +125,7 @@ struct _GstBtOscWaveClass {
 };
 
 void gstbt_osc_wave_setup(GstBtOscWave * self);
+gint gstbt_osc_wave_take_stream_error(GstBtOscWave * self);
 
 GType gstbt_osc_wave_get_type(void);
 
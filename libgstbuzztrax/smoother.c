@@ -0,0 +1,196 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * smoother.c: smoothed parameter values
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:smoother
+ * @title: GstBtSmoother
+ * @include: libgstbuzztrax/smoother.h
+ * @short_description: smoothed parameter values
+ *
+ * Controller changes are applied once per buffer. For continuous parameters
+ * such as a filter cut-off or an effect level the resulting steps are
+ * audible as clicks. A #GstBtSmoother turns the steps into a ramp that is
+ * spread over the following samples.
+ *
+ * The owner calls gstbt_smoother_set_target() from its property setter and
+ * gstbt_smoother_get_block() from its processing loop. Once the target is
+ * reached gstbt_smoother_is_active() returns %FALSE and the block is filled
+ * with a constant.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "smoother.h"
+
+/* number of time constants until a one-pole ramp snaps to the target,
+ * exp(-8) is about -70 dB */
+#define ONE_POLE_SETTLE 8
+
+//-- private methods
+
+static void
+gstbt_smoother_start_ramp (GstBtSmoother * self)
+{
+  if (self->length == 0 || self->value == self->target) {
+    self->value = self->target;
+    self->remain = 0;
+    return;
+  }
+  switch (self->mode) {
+    case GSTBT_SMOOTHER_LINEAR:
+      self->step = (self->target - self->value) / self->length;
+      self->remain = self->length;
+      break;
+    case GSTBT_SMOOTHER_ONE_POLE:
+      self->coeff = exp (-1.0 / self->length);
+      self->remain = self->length * ONE_POLE_SETTLE;
+      break;
+  }
+}
+
+//-- public methods
+
+/**
+ * gstbt_smoother_init:
+ * @self: the smoother
+ * @mode: the smoothing curve
+ * @length: the ramp length in samples
+ * @value: the initial value
+ *
+ * Initialize the smoother. The value is set without a ramp.
+ */
+void
+gstbt_smoother_init (GstBtSmoother * self, GstBtSmootherMode mode,
+    guint length, gdouble value)
+{
+  self->mode = mode;
+  self->length = length;
+  self->step = 0.0;
+  self->coeff = 0.0;
+  gstbt_smoother_reset (self, value);
+}
+
+/**
+ * gstbt_smoother_set_length:
+ * @self: the smoother
+ * @length: the ramp length in samples
+ *
+ * Change the ramp length, e.g. after the sampling rate has changed. A running
+ * ramp is restarted from the current value.
+ */
+void
+gstbt_smoother_set_length (GstBtSmoother * self, guint length)
+{
+  self->length = length;
+  if (self->remain)
+    gstbt_smoother_start_ramp (self);
+}
+
+/**
+ * gstbt_smoother_set_target:
+ * @self: the smoother
+ * @target: the new value
+ *
+ * Start a ramp from the current value to @target. Setting the same target
+ * again does not restart a running ramp.
+ */
+void
+gstbt_smoother_set_target (GstBtSmoother * self, gdouble target)
+{
+  if (target == self->target)
+    return;
+  self->target = target;
+  gstbt_smoother_start_ramp (self);
+}
+
+/**
+ * gstbt_smoother_reset:
+ * @self: the smoother
+ * @value: the new value
+ *
+ * Jump to @value without a ramp. Use this when the signal path has been
+ * reset anyway (e.g. after a flush).
+ */
+void
+gstbt_smoother_reset (GstBtSmoother * self, gdouble value)
+{
+  self->value = self->target = value;
+  self->remain = 0;
+}
+
+/**
+ * gstbt_smoother_is_active:
+ * @self: the smoother
+ *
+ * Checks if the smoother is still ramping. Can be used to take a faster path
+ * with a constant parameter value.
+ *
+ * Returns: %TRUE if the target has not been reached yet
+ */
+gboolean
+gstbt_smoother_is_active (GstBtSmoother * self)
+{
+  return (self->remain > 0);
+}
+
+/**
+ * gstbt_smoother_get_block:
+ * @self: the smoother
+ * @n: the number of samples to generate
+ * @out: array for the values
+ *
+ * Fill @out with the next @n parameter values and advance the ramp by @n.
+ * The linear ramp has no dependency between the samples and thus vectorizes.
+ */
+void
+gstbt_smoother_get_block (GstBtSmoother * self, guint n, gdouble * out)
+{
+  guint i, ct = MIN (n, self->remain);
+  gdouble value = self->value;
+
+  if (ct) {
+    if (self->mode == GSTBT_SMOOTHER_LINEAR) {
+      gdouble step = self->step;
+
+      for (i = 0; i < ct; i++) {
+        out[i] = value + step * (gdouble) (i + 1);
+      }
+      value += step * (gdouble) ct;
+    } else {
+      gdouble target = self->target, coeff = self->coeff;
+      gdouble delta = value - target;
+
+      for (i = 0; i < ct; i++) {
+        delta *= coeff;
+        out[i] = target + delta;
+      }
+      value = target + delta;
+    }
+    self->remain -= ct;
+    if (!self->remain)
+      value = self->target;
+    self->value = value;
+  }
+  for (i = ct; i < n; i++) {
+    out[i] = value;
+  }
+}
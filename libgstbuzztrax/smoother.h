@@ -0,0 +1,67 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * smoother.h: smoothed parameter values
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_SMOOTHER_H__
+#define __GSTBT_SMOOTHER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstBtSmootherMode:
+ * @GSTBT_SMOOTHER_LINEAR: linear ramp that reaches the target after the
+ *   configured length
+ * @GSTBT_SMOOTHER_ONE_POLE: exponential approach (one-pole lowpass) with the
+ *   configured length as the time constant
+ *
+ * Smoothing curves.
+ */
+typedef enum
+{
+  GSTBT_SMOOTHER_LINEAR,
+  GSTBT_SMOOTHER_ONE_POLE
+} GstBtSmootherMode;
+
+/**
+ * GstBtSmoother:
+ *
+ * A parameter value that glides towards its target. This is a plain
+ * structure that is embedded into the objects using it.
+ */
+typedef struct
+{
+  /* < private > */
+  GstBtSmootherMode mode;
+  guint length;                 /* ramp length / time constant in samples */
+  gdouble value, target;
+  gdouble step;                 /* per sample increment (linear) */
+  gdouble coeff;                /* feedback coefficient (one-pole) */
+  guint remain;                 /* samples until the target is reached */
+} GstBtSmoother;
+
+void gstbt_smoother_init (GstBtSmoother *self, GstBtSmootherMode mode, guint length, gdouble value);
+void gstbt_smoother_set_length (GstBtSmoother *self, guint length);
+void gstbt_smoother_set_target (GstBtSmoother *self, gdouble target);
+void gstbt_smoother_reset (GstBtSmoother *self, gdouble value);
+gboolean gstbt_smoother_is_active (GstBtSmoother *self);
+void gstbt_smoother_get_block (GstBtSmoother *self, guint n, gdouble *out);
+
+G_END_DECLS
+#endif /* __GSTBT_SMOOTHER_H__ */
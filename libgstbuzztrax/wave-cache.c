@@ -0,0 +1,460 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wave-cache.c: memory mapped on-disk cache for decoded waves
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:wave-cache
+ * @title: GstBtWaveCache
+ * @include: libgstbuzztrax/wave-cache.h
+ * @short_description: memory mapped on-disk cache for decoded waves
+ *
+ * Sample based songs load a lot of waves. Decoding them each time a song is
+ * opened takes time and each process keeps its own copy of the samples.
+ *
+ * The wave cache stores decoded samples in files below the users cache
+ * directory. The files are named after a key, usually the checksum of the
+ * encoded wave as returned by gstbt_wave_cache_make_key(). The same content
+ * thus always ends up in the same entry.
+ *
+ * gstbt_wave_cache_lookup() maps an entry read-only and wraps it into a
+ * #GstBuffer. All users of the same entry share the pages, also across
+ * processes. Very long waves can be read in pieces through
+ * gstbt_wave_cache_open() instead.
+ *
+ * #GstBtOscWave uses the cache if the wave structure returned by the
+ * wave-table callbacks has a "cache-key" field. A host can use
+ * gstbt_wave_cache_contains() to skip decoding waves that are already cached.
+ *
+ * The cache is not limited in size by itself. Hosts should call
+ * gstbt_wave_cache_trim() from time to time, e.g. on startup, to remove the
+ * least recently used entries.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include "wave-cache.h"
+
+#define GST_CAT_DEFAULT wave_cache_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define CACHE_MAGIC "BTWC"
+#define CACHE_VERSION 1
+/* the samples start at this offset, this keeps them aligned for simd loads */
+#define CACHE_DATA_OFFSET 64
+
+/* file header, the samples follow at CACHE_DATA_OFFSET */
+typedef struct
+{
+  gchar magic[4];
+  guint32 version;
+  guint32 byte_order;
+  guint32 format;
+  guint32 channels;
+  guint32 reserved;
+  guint64 size;                 /* size of the samples in bytes */
+} GstBtWaveCacheHeader;
+
+/* entries in the cache directory with this suffix are cache entries */
+#define CACHE_SUFFIX ".pcm"
+
+/* a cache entry as seen by gstbt_wave_cache_trim() */
+typedef struct
+{
+  gchar *path;
+  goffset size;
+  time_t mtime;
+} GstBtWaveCacheEntry;
+
+//-- private methods
+
+static gchar *
+gstbt_wave_cache_get_dir (void)
+{
+  static gsize init = 0;
+  gchar *dir;
+
+  if (g_once_init_enter (&init)) {
+    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "wave-cache",
+        GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "wave cache");
+    g_once_init_leave (&init, 1);
+  }
+
+  dir = g_build_filename (g_get_user_cache_dir (), "gst-buzztrax", "waves",
+      NULL);
+  if (g_mkdir_with_parents (dir, 0755) == -1) {
+    GST_WARNING ("can't create cache directory %s: %s", dir,
+        g_strerror (errno));
+    g_free (dir);
+    return NULL;
+  }
+  return dir;
+}
+
+/* The key is used as a file name, only accept hex digits */
+static gchar *
+gstbt_wave_cache_get_path (const gchar * key)
+{
+  const gchar *k;
+  gchar *dir, *name, *path;
+
+  if (!key || !*key) {
+    return NULL;
+  }
+  for (k = key; *k; k++) {
+    if (!g_ascii_isxdigit (*k)) {
+      GST_WARNING ("invalid cache key '%s'", key);
+      return NULL;
+    }
+  }
+
+  if (!(dir = gstbt_wave_cache_get_dir ()))
+    return NULL;
+  name = g_strconcat (key, CACHE_SUFFIX, NULL);
+  path = g_build_filename (dir, name, NULL);
+  g_free (name);
+  g_free (dir);
+  return path;
+}
+
+static gboolean
+gstbt_wave_cache_check_header (const GstBtWaveCacheHeader * h, gsize length)
+{
+  return (length >= CACHE_DATA_OFFSET && !memcmp (h->magic, CACHE_MAGIC, 4) &&
+      h->version == CACHE_VERSION && h->byte_order == G_BYTE_ORDER &&
+      h->format <= GSTBT_WAVE_CACHE_FORMAT_F32 && h->channels &&
+      h->size <= length - CACHE_DATA_OFFSET);
+}
+
+/* mark the entry as recently used for gstbt_wave_cache_trim() */
+static void
+gstbt_wave_cache_touch (const gchar * path)
+{
+  if (g_utime (path, NULL) == -1) {
+    GST_DEBUG ("can't touch %s: %s", path, g_strerror (errno));
+  }
+}
+
+/* newest first */
+static gint
+gstbt_wave_cache_compare_entries (gconstpointer a, gconstpointer b)
+{
+  const GstBtWaveCacheEntry *ea = a, *eb = b;
+
+  return (ea->mtime < eb->mtime) - (ea->mtime > eb->mtime);
+}
+
+static void
+gstbt_wave_cache_free_entry (GstBtWaveCacheEntry * e)
+{
+  g_free (e->path);
+  g_free (e);
+}
+
+static gboolean
+gstbt_wave_cache_write (gint fd, const guint8 * data, gsize size)
+{
+  gssize res;
+
+  while (size) {
+    if ((res = write (fd, data, size)) == -1) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    data += res;
+    size -= res;
+  }
+  return TRUE;
+}
+
+//-- public methods
+
+/**
+ * gstbt_wave_cache_make_key:
+ * @data: the content to compute the key for
+ * @size: size of @data in bytes
+ *
+ * Compute a cache key from the content of a wave. Use the encoded wave (e.g.
+ * the sample file), so that the key is known without decoding it.
+ *
+ * Returns: the key, free with g_free()
+ */
+gchar *
+gstbt_wave_cache_make_key (gconstpointer data, gsize size)
+{
+  return g_compute_checksum_for_data (G_CHECKSUM_SHA256, data, size);
+}
+
+/**
+ * gstbt_wave_cache_contains:
+ * @key: the cache key
+ *
+ * Check if the cache has an entry for @key.
+ *
+ * Returns: %TRUE if the entry exists
+ */
+gboolean
+gstbt_wave_cache_contains (const gchar * key)
+{
+  gchar *path;
+  gboolean res;
+
+  if (!(path = gstbt_wave_cache_get_path (key)))
+    return FALSE;
+  res = g_file_test (path, G_FILE_TEST_IS_REGULAR);
+  g_free (path);
+  return res;
+}
+
+/**
+ * gstbt_wave_cache_lookup:
+ * @key: the cache key
+ * @format: (out): the sample format of the entry
+ * @channels: (out): the number of channels of the entry
+ *
+ * Map the cache entry for @key. The returned buffer is read-only and shares
+ * its memory with all other users of the entry.
+ *
+ * Returns: the samples or %NULL if there is no valid entry for @key
+ */
+GstBuffer *
+gstbt_wave_cache_lookup (const gchar * key, GstBtWaveCacheFormat * format,
+    guint * channels)
+{
+  const GstBtWaveCacheHeader *h;
+  GMappedFile *file;
+  GError *err = NULL;
+  GstBuffer *buf = NULL;
+  gchar *path, *contents;
+  gsize length;
+
+  if (!(path = gstbt_wave_cache_get_path (key)))
+    return NULL;
+
+  if (!(file = g_mapped_file_new (path, FALSE, &err))) {
+    GST_DEBUG ("no cache entry for %s: %s", key, err->message);
+    g_error_free (err);
+    g_free (path);
+    return NULL;
+  }
+  contents = g_mapped_file_get_contents (file);
+  length = g_mapped_file_get_length (file);
+  h = (const GstBtWaveCacheHeader *) contents;
+
+  /* the header is only looked at if the file is large enough */
+  if (length < CACHE_DATA_OFFSET || !gstbt_wave_cache_check_header (h, length)) {
+    GST_WARNING ("ignoring invalid cache entry %s", path);
+    g_mapped_file_unref (file);
+  } else {
+    *format = (GstBtWaveCacheFormat) h->format;
+    *channels = h->channels;
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, contents, length,
+            CACHE_DATA_OFFSET, h->size, file,
+            (GDestroyNotify) g_mapped_file_unref));
+    GST_DEBUG ("mapped cache entry %s with %" G_GUINT64_FORMAT " bytes", key,
+        h->size);
+    gstbt_wave_cache_touch (path);
+  }
+  g_free (path);
+  return buf;
+}
+
+/**
+ * gstbt_wave_cache_open:
+ * @key: the cache key
+ * @format: (out): the sample format of the entry
+ * @channels: (out): the number of channels of the entry
+ * @size: (out): the size of the samples in bytes
+ * @offset: (out): the file offset of the first sample
+ *
+ * Open the cache entry for @key for reading it in pieces, e.g. to stream long
+ * waves instead of mapping them.
+ *
+ * Returns: the file descriptor or -1 if there is no valid entry for @key,
+ * close it with close()
+ */
+gint
+gstbt_wave_cache_open (const gchar * key, GstBtWaveCacheFormat * format,
+    guint * channels, guint64 * size, goffset * offset)
+{
+  GstBtWaveCacheHeader h;
+  struct stat st;
+  gchar *path;
+  gint fd;
+
+  if (!(path = gstbt_wave_cache_get_path (key)))
+    return -1;
+
+  if ((fd = g_open (path, O_RDONLY, 0)) == -1) {
+    GST_DEBUG ("no cache entry for %s: %s", key, g_strerror (errno));
+    g_free (path);
+    return -1;
+  }
+  if (fstat (fd, &st) == -1 || read (fd, &h, sizeof (h)) != sizeof (h) ||
+      !gstbt_wave_cache_check_header (&h, st.st_size)) {
+    GST_WARNING ("ignoring invalid cache entry %s", path);
+    close (fd);
+    fd = -1;
+  } else {
+    *format = (GstBtWaveCacheFormat) h.format;
+    *channels = h.channels;
+    *size = h.size;
+    *offset = CACHE_DATA_OFFSET;
+    gstbt_wave_cache_touch (path);
+  }
+  g_free (path);
+  return fd;
+}
+
+/**
+ * gstbt_wave_cache_store:
+ * @key: the cache key
+ * @format: the sample format of @data
+ * @channels: the number of channels of @data
+ * @data: the samples
+ *
+ * Write @data to the cache entry for @key. The entry is written to a
+ * temporary file that is renamed when complete, thus concurrent lookups never
+ * see a partial entry.
+ *
+ * Returns: the samples mapped from the new entry (see
+ * gstbt_wave_cache_lookup()) or %NULL if writing failed
+ */
+GstBuffer *
+gstbt_wave_cache_store (const gchar * key, GstBtWaveCacheFormat format,
+    guint channels, GstBuffer * data)
+{
+  guint8 head[CACHE_DATA_OFFSET] = { 0, };
+  GstBtWaveCacheHeader h = { {0,}, };
+  GstBtWaveCacheFormat f;
+  GstBuffer *buf = NULL;
+  GstMapInfo info;
+  gchar *path, *tmp;
+  gboolean res;
+  guint c;
+  gint fd;
+
+  if (!(path = gstbt_wave_cache_get_path (key)))
+    return NULL;
+  if (!gst_buffer_map (data, &info, GST_MAP_READ)) {
+    GST_WARNING ("unable to map buffer for read");
+    g_free (path);
+    return NULL;
+  }
+
+  memcpy (h.magic, CACHE_MAGIC, 4);
+  h.version = CACHE_VERSION;
+  h.byte_order = G_BYTE_ORDER;
+  h.format = format;
+  h.channels = channels;
+  h.size = info.size;
+  memcpy (head, &h, sizeof (h));
+
+  tmp = g_strconcat (path, ".XXXXXX", NULL);
+  if ((fd = g_mkstemp (tmp)) == -1) {
+    GST_WARNING ("can't create %s: %s", tmp, g_strerror (errno));
+  } else {
+    res = gstbt_wave_cache_write (fd, head, CACHE_DATA_OFFSET) &&
+        gstbt_wave_cache_write (fd, info.data, info.size);
+    res = (close (fd) == 0) && res;
+    if (res && !g_rename (tmp, path)) {
+      GST_INFO ("stored cache entry %s with %" G_GSIZE_FORMAT " bytes", key,
+          info.size);
+      buf = gstbt_wave_cache_lookup (key, &f, &c);
+    } else {
+      GST_WARNING ("can't write %s: %s", path, g_strerror (errno));
+      g_unlink (tmp);
+    }
+  }
+  gst_buffer_unmap (data, &info);
+  g_free (tmp);
+  g_free (path);
+  return buf;
+}
+
+/**
+ * gstbt_wave_cache_trim:
+ * @max_size: the size in bytes the cache may use
+ *
+ * Remove the least recently used entries until the entries use at most
+ * @max_size bytes. Entries are used by gstbt_wave_cache_lookup(),
+ * gstbt_wave_cache_open() and gstbt_wave_cache_store(). Removing an entry
+ * does not affect the waves that are mapped or streamed from it.
+ *
+ * Returns: the number of bytes the remaining entries use
+ */
+guint64
+gstbt_wave_cache_trim (guint64 max_size)
+{
+  GstBtWaveCacheEntry *e;
+  GList *entries = NULL, *node;
+  GDir *dir;
+  GStatBuf st;
+  const gchar *name;
+  gchar *path;
+  guint64 total = 0;
+
+  if (!(path = gstbt_wave_cache_get_dir ()))
+    return 0;
+  if (!(dir = g_dir_open (path, 0, NULL))) {
+    g_free (path);
+    return 0;
+  }
+  while ((name = g_dir_read_name (dir))) {
+    if (!g_str_has_suffix (name, CACHE_SUFFIX))
+      continue;
+    e = g_new0 (GstBtWaveCacheEntry, 1);
+    e->path = g_build_filename (path, name, NULL);
+    if (g_stat (e->path, &st) == -1 || !S_ISREG (st.st_mode)) {
+      gstbt_wave_cache_free_entry (e);
+      continue;
+    }
+    e->size = st.st_size;
+    e->mtime = st.st_mtime;
+    entries = g_list_prepend (entries, e);
+  }
+  g_dir_close (dir);
+  g_free (path);
+
+  /* keep the recently used entries as long as they fit */
+  entries = g_list_sort (entries, gstbt_wave_cache_compare_entries);
+  for (node = entries; node; node = g_list_next (node)) {
+    e = (GstBtWaveCacheEntry *) node->data;
+    if (total + e->size <= max_size) {
+      total += e->size;
+    } else if (g_unlink (e->path) == -1) {
+      GST_WARNING ("can't remove %s: %s", e->path, g_strerror (errno));
+      total += e->size;
+    } else {
+      GST_INFO ("removed cache entry %s", e->path);
+    }
+  }
+  g_list_free_full (entries, (GDestroyNotify) gstbt_wave_cache_free_entry);
+  return total;
+}
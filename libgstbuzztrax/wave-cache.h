@@ -0,0 +1,49 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wave-cache.h: memory mapped on-disk cache for decoded waves
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_WAVE_CACHE_H__
+#define __GSTBT_WAVE_CACHE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstBtWaveCacheFormat:
+ * @GSTBT_WAVE_CACHE_FORMAT_S16: interleaved signed 16 bit samples
+ * @GSTBT_WAVE_CACHE_FORMAT_F32: interleaved 32 bit float samples
+ *
+ * Sample formats of the cached waves. The samples are stored in the native
+ * byte order.
+ */
+typedef enum
+{
+  GSTBT_WAVE_CACHE_FORMAT_S16 = 0,
+  GSTBT_WAVE_CACHE_FORMAT_F32
+} GstBtWaveCacheFormat;
+
+gchar *gstbt_wave_cache_make_key (gconstpointer data, gsize size);
+gboolean gstbt_wave_cache_contains (const gchar *key);
+GstBuffer *gstbt_wave_cache_lookup (const gchar *key, GstBtWaveCacheFormat *format, guint *channels);
+gint gstbt_wave_cache_open (const gchar *key, GstBtWaveCacheFormat *format, guint *channels, guint64 *size, goffset *offset);
+GstBuffer *gstbt_wave_cache_store (const gchar *key, GstBtWaveCacheFormat format, guint channels, GstBuffer *data);
+guint64 gstbt_wave_cache_trim (guint64 max_size);
+
+G_END_DECLS
+#endif /* __GSTBT_WAVE_CACHE_H__ */
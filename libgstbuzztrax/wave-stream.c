@@ -0,0 +1,356 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wave-stream.c: prefetching reader for long waves
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:wave-stream
+ * @title: GstBtWaveStream
+ * @include: libgstbuzztrax/wave-stream.h
+ * @short_description: prefetching reader for long waves
+ *
+ * Reads interleaved samples from a file without loading the whole file. A
+ * prefetch thread keeps a ring of a few seconds ahead of the read position
+ * filled. Float samples are converted to signed 16 bit when they are read.
+ *
+ * If reading the file fails, the prefetch thread stops and the reader only
+ * returns silence from then on. gstbt_wave_stream_get_error() tells about it.
+ *
+ * gstbt_wave_stream_read() is called from the streaming thread and never
+ * blocks. The ring is shared through atomic positions, not through a lock.
+ * If the read position differs from the one following the previous read, the
+ * reader requests a refill from the new position and returns silence until
+ * the prefetch thread has caught up.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "wave-stream.h"
+
+#define GST_CAT_DEFAULT wave_stream_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* size of the ring, about 6 seconds at 44.1 kHz */
+#define RING_FRAMES (1 << 18)
+/* the prefetch thread reads this many frames at once */
+#define CHUNK_FRAMES (1 << 14)
+/* the prefetch thread also checks for work after this time, in case it
+ * missed a wake up */
+#define PREFETCH_POLL (10 * G_TIME_SPAN_MILLISECOND)
+
+struct _GstBtWaveStream
+{
+  gint fd;
+  goffset offset;
+  GstBtWaveCacheFormat format;
+  guint64 frames;
+  guint channels;
+
+  gint16 *ring;
+  gfloat *chunk;                /* read buffer for float samples */
+  volatile gint error;          /* errno of a failed read */
+
+  /* written by the reader */
+  volatile gsize read_pos;      /* frames before this can be overwritten */
+  volatile gsize seek_pos;      /* where to refill from after a seek */
+  volatile gint seek_gen;       /* incremented on each seek */
+  guint64 expected;             /* the position following the last read */
+  gint gen;
+
+  /* written by the prefetch thread, valid when fill_gen == seek_gen */
+  volatile gsize fill_start, fill_end;
+  volatile gint fill_gen;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  volatile gint running;
+};
+
+//-- private methods
+
+static gboolean
+gstbt_wave_stream_pread (GstBtWaveStream * self, gpointer data, gsize size,
+    goffset offset)
+{
+  guint8 *d = data;
+  gssize res;
+
+  while (size) {
+    if ((res = pread (self->fd, d, size, offset)) <= 0) {
+      if (res == -1 && errno == EINTR)
+        continue;
+      /* the file got shorter */
+      if (res == 0)
+        errno = EIO;
+      return FALSE;
+    }
+    d += res;
+    offset += res;
+    size -= res;
+  }
+  return TRUE;
+}
+
+/* read @n frames starting at frame @pos to @dst */
+static gboolean
+gstbt_wave_stream_read_frames (GstBtWaveStream * self, gint16 * dst,
+    gsize pos, guint n)
+{
+  const guint ct = n * self->channels;
+  guint i;
+
+  if (self->format == GSTBT_WAVE_CACHE_FORMAT_S16) {
+    return gstbt_wave_stream_pread (self, dst, ct * sizeof (gint16),
+        self->offset + pos * self->channels * sizeof (gint16));
+  }
+  if (!gstbt_wave_stream_pread (self, self->chunk, ct * sizeof (gfloat),
+          self->offset + pos * self->channels * sizeof (gfloat))) {
+    return FALSE;
+  }
+  for (i = 0; i < ct; i++) {
+    dst[i] = (gint16) CLAMP (self->chunk[i] * 32767.0f, G_MININT16,
+        G_MAXINT16);
+  }
+  return TRUE;
+}
+
+static gpointer
+gstbt_wave_stream_prefetch (gpointer data)
+{
+  GstBtWaveStream *self = (GstBtWaveStream *) data;
+  gsize start = 0, end = 0, limit, read_pos;
+  gint g, gen = 0;
+  guint n, r;
+
+  while (g_atomic_int_get (&self->running)) {
+    if ((g = g_atomic_int_get (&self->seek_gen)) != gen) {
+      gen = g;
+      start = end = g_atomic_pointer_get (&self->seek_pos);
+      g_atomic_pointer_set (&self->fill_start, start);
+      g_atomic_pointer_set (&self->fill_end, end);
+      g_atomic_int_set (&self->fill_gen, gen);
+    }
+    read_pos = g_atomic_pointer_get (&self->read_pos);
+    limit = MIN (read_pos + RING_FRAMES, self->frames);
+    if (end < limit) {
+      /* read up to the end of the ring, the next chunk starts at its head */
+      r = end % RING_FRAMES;
+      n = MIN (MIN (limit - end, CHUNK_FRAMES), RING_FRAMES - r);
+      /* the frames that get overwritten are no longer valid */
+      if (end + n > start + RING_FRAMES) {
+        start = end + n - RING_FRAMES;
+        g_atomic_pointer_set (&self->fill_start, start);
+      }
+      if (!gstbt_wave_stream_read_frames (self, &self->ring[r * self->channels],
+              end, n)) {
+        GST_WARNING ("reading %u frames at %" G_GSIZE_FORMAT " failed: %s", n,
+            end, g_strerror (errno));
+        g_atomic_int_set (&self->error, errno);
+        break;
+      }
+      /* drop the chunk if the reader has seeked meanwhile */
+      if (g_atomic_int_get (&self->seek_gen) == gen) {
+        end += n;
+        g_atomic_pointer_set (&self->fill_end, end);
+      }
+      continue;
+    }
+    /* the ring is full, wait for the reader to make room */
+    g_mutex_lock (&self->lock);
+    if (g_atomic_int_get (&self->running)) {
+      g_cond_wait_until (&self->cond, &self->lock,
+          g_get_monotonic_time () + PREFETCH_POLL);
+    }
+    g_mutex_unlock (&self->lock);
+  }
+  return NULL;
+}
+
+static void
+gstbt_wave_stream_wake (GstBtWaveStream * self)
+{
+  /* don't block the caller if the prefetch thread holds the lock, it is busy
+   * then anyway */
+  if (g_mutex_trylock (&self->lock)) {
+    g_cond_signal (&self->cond);
+    g_mutex_unlock (&self->lock);
+  }
+}
+
+//-- public methods
+
+/**
+ * gstbt_wave_stream_new:
+ * @fd: the file to read from, the stream takes ownership
+ * @offset: the file offset of the first sample
+ * @format: the sample format in the file
+ * @frames: the number of frames in the file
+ * @channels: the number of channels
+ *
+ * Create a reader for the interleaved samples in @fd and start prefetching
+ * from the beginning.
+ *
+ * Returns: the new reader, free with gstbt_wave_stream_free()
+ */
+GstBtWaveStream *
+gstbt_wave_stream_new (gint fd, goffset offset, GstBtWaveCacheFormat format,
+    guint64 frames, guint channels)
+{
+  static gsize init = 0;
+  GstBtWaveStream *self;
+
+  if (g_once_init_enter (&init)) {
+    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "wave-stream",
+        GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "wave stream");
+    g_once_init_leave (&init, 1);
+  }
+
+  self = g_new0 (GstBtWaveStream, 1);
+  self->fd = fd;
+  self->offset = offset;
+  self->format = format;
+  self->frames = frames;
+  self->channels = channels;
+  self->ring = g_new (gint16, RING_FRAMES * channels);
+  if (format == GSTBT_WAVE_CACHE_FORMAT_F32) {
+    self->chunk = g_new (gfloat, CHUNK_FRAMES * channels);
+  }
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  self->running = TRUE;
+  self->thread = g_thread_new ("wave-stream", gstbt_wave_stream_prefetch,
+      self);
+  GST_INFO ("streaming %" G_GUINT64_FORMAT " frames with %u channels", frames,
+      channels);
+  return self;
+}
+
+/**
+ * gstbt_wave_stream_free:
+ * @self: the reader
+ *
+ * Stop the prefetch thread, close the file and free the reader.
+ */
+void
+gstbt_wave_stream_free (GstBtWaveStream * self)
+{
+  g_atomic_int_set (&self->running, FALSE);
+  g_mutex_lock (&self->lock);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+  g_thread_join (self->thread);
+
+  close (self->fd);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+  g_free (self->ring);
+  g_free (self->chunk);
+  g_free (self);
+}
+
+/**
+ * gstbt_wave_stream_get_frames:
+ * @self: the reader
+ *
+ * Get the length of the wave.
+ *
+ * Returns: the number of frames
+ */
+guint64
+gstbt_wave_stream_get_frames (GstBtWaveStream * self)
+{
+  return self->frames;
+}
+
+/**
+ * gstbt_wave_stream_get_error:
+ * @self: the reader
+ *
+ * Check if the prefetch thread has stopped because reading the file failed.
+ *
+ * Returns: the errno of the failed read or 0
+ */
+gint
+gstbt_wave_stream_get_error (GstBtWaveStream * self)
+{
+  return g_atomic_int_get (&self->error);
+}
+
+/**
+ * gstbt_wave_stream_read:
+ * @self: the reader
+ * @pos: the frame to start at
+ * @ct: the number of frames to read
+ * @dst: target for the interleaved samples
+ *
+ * Copy @ct frames starting at @pos from the ring. Frames that have not been
+ * prefetched yet, e.g. right after a seek, and frames past the end of the
+ * wave are filled with silence.
+ *
+ * Returns: %FALSE if @pos is beyond the end of the wave
+ */
+gboolean
+gstbt_wave_stream_read (GstBtWaveStream * self, guint64 pos, guint ct,
+    gint16 * dst)
+{
+  const guint ch = self->channels;
+  gsize start, end;
+  guint n = 0, m, r;
+
+  if (pos >= self->frames) {
+    return FALSE;
+  }
+
+  if (pos != self->expected) {
+    GST_DEBUG ("seek from %" G_GUINT64_FORMAT " to %" G_GUINT64_FORMAT,
+        self->expected, pos);
+    g_atomic_pointer_set (&self->read_pos, pos);
+    g_atomic_pointer_set (&self->seek_pos, pos);
+    self->gen++;
+    g_atomic_int_set (&self->seek_gen, self->gen);
+  }
+
+  if (g_atomic_int_get (&self->fill_gen) == self->gen) {
+    start = g_atomic_pointer_get (&self->fill_start);
+    end = g_atomic_pointer_get (&self->fill_end);
+    if (pos >= start && pos < end) {
+      n = (guint) MIN (ct, end - pos);
+      /* the data can wrap around the end of the ring once */
+      r = pos % RING_FRAMES;
+      m = MIN (n, RING_FRAMES - r);
+      memcpy (dst, &self->ring[r * ch], m * ch * sizeof (gint16));
+      memcpy (&dst[m * ch], self->ring, (n - m) * ch * sizeof (gint16));
+    }
+  }
+  if (n < ct) {
+    if (pos + n < self->frames) {
+      GST_INFO ("underrun at %" G_GUINT64_FORMAT, pos + n);
+    }
+    memset (&dst[n * ch], 0, (ct - n) * ch * sizeof (gint16));
+  }
+
+  self->expected = pos + ct;
+  g_atomic_pointer_set (&self->read_pos, pos + ct);
+  gstbt_wave_stream_wake (self);
+  return TRUE;
+}
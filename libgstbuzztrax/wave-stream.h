@@ -0,0 +1,42 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wave-stream.h: prefetching reader for long waves
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_WAVE_STREAM_H__
+#define __GSTBT_WAVE_STREAM_H__
+
+#include <gst/gst.h>
+#include <libgstbuzztrax/wave-cache.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstBtWaveStream:
+ *
+ * Opaque reader instance.
+ */
+typedef struct _GstBtWaveStream GstBtWaveStream;
+
+GstBtWaveStream *gstbt_wave_stream_new (gint fd, goffset offset, GstBtWaveCacheFormat format, guint64 frames, guint channels);
+void gstbt_wave_stream_free (GstBtWaveStream *self);
+guint64 gstbt_wave_stream_get_frames (GstBtWaveStream *self);
+gint gstbt_wave_stream_get_error (GstBtWaveStream *self);
+gboolean gstbt_wave_stream_read (GstBtWaveStream *self, guint64 pos, guint ct, gint16 *dst);
+
+G_END_DECLS
+#endif /* __GSTBT_WAVE_STREAM_H__ */
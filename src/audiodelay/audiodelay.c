@@ -23,6 +23,20 @@
  *
  * <refsect2>
  * Echo effect with controllable effect-ratio, delay-time and feedback.
+ * Changes of the effect-ratio and the feedback are smoothed.
+ *
+ * Each channel has its own delay line. With #GstBtAudioDelay:ping-pong
+ * enabled the echos of a channel are fed back into the next channel, thus
+ * the echos of a stereo signal bounce between left and right.
+ *
+ * The delay time can be given in absolute time using
+ * #GstBtAudioDelay:delaytime or synced to the song tempo in ticks or beats
+ * using #GstBtAudioDelay:sync-time. The #GstBtAudioDelay:time-mode property
+ * selects which one is used. Changes of the delay time are crossfaded.
+ *
+ * Once the input is silent (gap buffers) and the echos have decayed below
+ * -100 dB for a whole delay period, the delay lines are cleared and further
+ * gap buffers are passed through without processing.
  * <title>Example launch line</title>
  * <para>
  * <programlisting>
@@ -39,20 +53,33 @@
 #include "config.h"
 #endif
 
-#include <stdlib.h>
+#include <math.h>
 #include <string.h>
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 #include <gst/audio/audio.h>
 
+#include <libgstbuzztrax/denormal.h>
 #include <libgstbuzztrax/tempo.h>
 
 #include "audiodelay.h"
+#include "gstaudiodelayorc.h"
 
 #define GST_CAT_DEFAULT gst_audio_delay_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#define BLOCK_SIZE 256
+/* level changes are spread over this time (in seconds) */
+#define LEVEL_SMOOTHING 0.01
+/* maximum for the delaytime property, the ring-buffers are allocated for it */
+#define MAX_DELAYTIME 1000
+/* maximum for the sync-time property */
+#define MAX_SYNC_TIME 16
+/* echos below this level are considered to be silent (relative to full
+ * scale, about -100 dB) */
+#define TAIL_THRESHOLD 1.0e-5
+
 enum
 {
   // static class properties
@@ -60,28 +87,31 @@ enum
   PROP_DRYWET = 1,
   PROP_FEEDBACK,
   PROP_DELAYTIME,
+  PROP_PING_PONG,
+  PROP_TIME_MODE,
+  PROP_SYNC_TIME,
   // tempo iface
   PROP_BPM,
   PROP_TPB,
   PROP_STPT
 };
 
+#define AUDIO_DELAY_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1")
+    GST_STATIC_CAPS (AUDIO_DELAY_CAPS)
     );
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1")
+    GST_STATIC_CAPS (AUDIO_DELAY_CAPS)
     );
 
 //-- the class
@@ -93,24 +123,273 @@ G_DEFINE_TYPE_WITH_CODE (GstBtAudioDelay, gstbt_audio_delay,
     GST_TYPE_BASE_TRANSFORM, G_IMPLEMENT_INTERFACE (GSTBT_TYPE_TEMPO,
         gstbt_audio_delay_tempo_interface_init));
 
-//-- basetransform vmethods
+//-- enums
 
-static gboolean
-gstbt_audio_delay_set_caps (GstBaseTransform * base, GstCaps * incaps,
-    GstCaps * outcaps)
+GType
+gstbt_audio_delay_time_mode_get_type (void)
 {
-  GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (base);
-  const GstStructure *structure = gst_caps_get_structure (incaps, 0);
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_AUDIO_DELAY_TIME_MODE_ABSOLUTE, "Absolute", "absolute"},
+    {GSTBT_AUDIO_DELAY_TIME_MODE_TICKS, "Ticks", "ticks"},
+    {GSTBT_AUDIO_DELAY_TIME_MODE_BEATS, "Beats", "beats"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtAudioDelayTimeMode", enums);
+  }
+  return type;
+}
+
+//-- private methods
+
+/* the longest delay in samples, synced delays are limited to it as well */
+static guint
+gstbt_audio_delay_get_max_delay (GstBtAudioDelay * self)
+{
+  return (MAX_DELAYTIME * self->samplerate) / 100;
+}
+
+/* Must be called with the object lock held, the delay lines are replaced
+ * from the streaming thread when the caps change. */
+static void
+gstbt_audio_delay_update_delay (GstBtAudioDelay * self)
+{
+  GstClockTime time;
+  guint c, delay;
+
+  switch (self->time_mode) {
+    case GSTBT_AUDIO_DELAY_TIME_MODE_TICKS:
+      time = self->ticktime * self->sync_time;
+      break;
+    case GSTBT_AUDIO_DELAY_TIME_MODE_BEATS:
+      time = self->ticktime * self->ticks_per_beat * self->sync_time;
+      break;
+    default:
+      time = (self->delaytime * GST_SECOND) / 100;
+      break;
+  }
+  delay = (guint) MIN (gst_util_uint64_scale (time, self->samplerate,
+          GST_SECOND), gstbt_audio_delay_get_max_delay (self));
+  delay = MAX (delay, 1);
+  GST_DEBUG_OBJECT (self, "delay is %u samples", delay);
+
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_set_delay (self->delays[c], delay);
+  }
+}
+
+/* Must be called with the object lock held. */
+static void
+gstbt_audio_delay_free_delays (GstBtAudioDelay * self)
+{
+  guint c;
+
+  if (self->delays) {
+    for (c = 0; c < self->channels; c++) {
+      g_object_unref (self->delays[c]);
+    }
+    g_free (self->delays);
+    self->delays = NULL;
+  }
+  g_free (self->dry);
+  self->dry = NULL;
+  g_free (self->fx);
+  self->fx = NULL;
+  self->channels = 0;
+}
+
+static void
+gstbt_audio_delay_flush (GstBtAudioDelay * self)
+{
+  guint c;
+
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_flush (self->delays[c]);
+  }
+  self->quiet_frames = 0;
+  self->tail_done = FALSE;
+  gstbt_smoother_reset (&self->drywet_smoother, self->drywet / 100.0);
+  gstbt_smoother_reset (&self->feedback_smoother, self->feedback / 100.0);
+}
+
+/* Write the clamped sum of @dry and the scaled @fb into the ring-buffer
+ * starting at @rb_in. The write is split into at most two contiguous spans at
+ * the wrap-around. */
+static void
+gstbt_audio_delay_write_spans (GstBtDelay * delay, guint rb_in, guint n,
+    const gfloat * dry, const gfloat * fb, const gdouble * feedback,
+    gfloat lo, gfloat hi)
+{
+  guint ct = MIN (n, delay->max_delaytime - rb_in);
+
+  orc_audio_delay_feedback_f32 (&delay->ring_buffer[rb_in], dry, fb, feedback,
+      lo, hi, ct);
+  if (n > ct) {
+    orc_audio_delay_feedback_f32 (delay->ring_buffer, &dry[ct], &fb[ct],
+        &feedback[ct], lo, hi, n - ct);
+  }
+}
 
-  return gst_structure_get_int (structure, "rate", &self->samplerate);
+/* Check if the tail has decayed, i.e. everything that can still be read
+ * from the delay lines is below the threshold. In that case the delay lines
+ * are cleared, so that gap buffers can be passed through as they are.
+ */
+static void
+gstbt_audio_delay_check_tail (GstBtAudioDelay * self)
+{
+  GstBtDelay *delay = self->delays[0];
+  guint c, reach;
+
+  reach = MAX (MAX (delay->delay, delay->read_delay), delay->old_delay);
+  if (self->quiet_frames < reach)
+    return;
+
+  GST_DEBUG_OBJECT (self, "tail has decayed, bypassing gaps");
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_flush (self->delays[c]);
+  }
+  self->tail_done = TRUE;
 }
 
+/* Process @num_frames interleaved frames in place. If @silent is %TRUE, the
+ * input is ignored and only the echos are rendered.
+ * Returns %TRUE if the output is not silent.
+ */
 static gboolean
-gstbt_audio_delay_start (GstBaseTransform * base)
+gstbt_audio_delay_process (GstBtAudioDelay * self, gpointer data,
+    guint num_frames, gboolean silent)
 {
-  GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (base);
+  const guint channels = self->channels;
+  const gboolean is_float =
+      (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32);
+  const gfloat lo = is_float ? -G_MAXFLOAT : G_MININT16;
+  const gfloat hi = is_float ? G_MAXFLOAT : G_MAXINT16;
+  const gfloat threshold = (gfloat) (is_float ? TAIL_THRESHOLD :
+      TAIL_THRESHOLD * 32768.0);
+  gint16 *d16 = (gint16 *) data;
+  gfloat *d32 = (gfloat *) data;
+  gdouble feedback[BLOCK_SIZE], wet[BLOCK_SIZE];
+  GstBtDelay *delay;
+  gfloat *dry, *fx, *fb;
+  gfloat peak;
+  guint c, i, s, n, rb_in, max_block;
+  gboolean audible = FALSE;
+
+  /* all echos of a block are read before any of them is fed back, thus a
+   * block must not be longer than the delay, neither the current nor the
+   * previous one while crossfading or a pending new one */
+  delay = self->delays[0];
+  max_block = MIN (MIN (delay->delay, delay->read_delay), delay->old_delay);
+  max_block = CLAMP (max_block, 1, BLOCK_SIZE);
+
+  while (num_frames) {
+    n = MIN (num_frames, max_block);
+    gstbt_smoother_get_block (&self->feedback_smoother, n, feedback);
+    gstbt_smoother_get_block (&self->drywet_smoother, n, wet);
+
+    /* deinterleave */
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      if (silent) {
+        memset (dry, 0, n * sizeof (gfloat));
+      } else if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = d32[s];
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = (gfloat) d16[s];
+        }
+      }
+    }
+    for (c = 0; c < channels; c++) {
+      gstbt_delay_read_block (self->delays[c], n, &self->fx[c * BLOCK_SIZE]);
+    }
+    /* track how long input and echos have been below the threshold */
+    peak = 0.0;
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      fx = &self->fx[c * BLOCK_SIZE];
+      for (i = 0; i < n; i++) {
+        peak = MAX (peak, MAX (fabsf (dry[i]), fabsf (fx[i])));
+      }
+    }
+    if (peak < threshold)
+      self->quiet_frames += n;
+    else
+      self->quiet_frames = 0;
+    for (c = 0; c < channels; c++) {
+      delay = self->delays[c];
+      dry = &self->dry[c * BLOCK_SIZE];
+      fx = &self->fx[c * BLOCK_SIZE];
+      /* for ping-pong take the feedback from the previous channel */
+      fb = self->ping_pong ?
+          &self->fx[((c + channels - 1) % channels) * BLOCK_SIZE] : fx;
+      rb_in = delay->rb_ptr;
+      gstbt_audio_delay_write_spans (delay, rb_in, n, dry, fb, feedback, lo,
+          hi);
+      rb_in = (rb_in + n) & delay->mask;
+      GSTBT_DELAY_AFTER (delay, rb_in, rb_in);
+      orc_audio_delay_mix_f32 (dry, fx, wet, n);
+    }
+    /* interleave */
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d32[s] = dry[i];
+          audible |= (dry[i] != 0.0);
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d16[s] = (gint16) CLAMP (dry[i], G_MININT16, G_MAXINT16);
+          audible |= (d16[s] != 0);
+        }
+      }
+    }
+    d16 += n * channels;
+    d32 += n * channels;
+    num_frames -= n;
+  }
+  return audible;
+}
 
-  gstbt_delay_start (self->delay, self->samplerate);
+//-- basetransform vmethods
+
+static gboolean
+gstbt_audio_delay_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (base);
+  guint c, length;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  self->samplerate = GST_AUDIO_INFO_RATE (&self->info);
+  length = (guint) (self->samplerate * LEVEL_SMOOTHING);
+  gstbt_smoother_set_length (&self->drywet_smoother, length);
+  gstbt_smoother_set_length (&self->feedback_smoother, length);
+
+  /* one delay line per channel, allocated for the longest delay, so that
+   * changing the delay or the tempo never needs to reallocate */
+  GST_OBJECT_LOCK (self);
+  gstbt_audio_delay_free_delays (self);
+  self->channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  self->delays = g_new (GstBtDelay *, self->channels);
+  for (c = 0; c < self->channels; c++) {
+    self->delays[c] = gstbt_delay_new ();
+    gstbt_delay_start (self->delays[c], self->samplerate,
+        gstbt_audio_delay_get_max_delay (self));
+  }
+  gstbt_audio_delay_update_delay (self);
+  self->quiet_frames = 0;
+  self->tail_done = FALSE;
+  self->dry = g_new0 (gfloat, self->channels * BLOCK_SIZE);
+  self->fx = g_new0 (gfloat, self->channels * BLOCK_SIZE);
+  GST_OBJECT_UNLOCK (self);
   return TRUE;
 }
 
@@ -118,62 +397,58 @@ static GstFlowReturn
 gstbt_audio_delay_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
 {
   GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (base);
-  GstBtDelay *delay = self->delay;
   GstMapInfo info;
   GstClockTime timestamp;
-  gdouble feedback, dry, wet;
-  gint16 *data;
-  gdouble val_dry, val_fx;
-  glong val, sum_fx = 0;
-  guint i, num_samples, rb_in, rb_out;
-
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
-    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
-    return GST_FLOW_ERROR;
+  gboolean silent, audible;
+  guint num_frames;
+  guint fpu_state;
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (!self->delays)) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_FLOW_NOT_NEGOTIATED;
   }
-  data = (gint16 *) info.data;
-  num_samples = info.size / sizeof (gint16);
 
   /* flush ring_buffer on DISCONT */
   if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
-    gstbt_delay_flush (delay);
+    gstbt_audio_delay_flush (self);
   }
+  GST_OBJECT_UNLOCK (self);
 
   timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
       GST_BUFFER_TIMESTAMP (outbuf));
   if (GST_CLOCK_TIME_IS_VALID (timestamp))
     gst_object_sync_values (GST_OBJECT (self), timestamp);
 
-  feedback = (gdouble) self->feedback / 100.0;
-  wet = (gdouble) self->drywet / 100.0;
-  dry = 1.0 - wet;
-  GSTBT_DELAY_BEFORE (delay, rb_in, rb_out);
-
-  if (G_UNLIKELY (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
-          gst_base_transform_is_passthrough (base))) {
-    /* input is silence */
-    for (i = 0; i < num_samples; i++) {
-      GSTBT_DELAY_READ (delay, rb_out, val_fx);
-      val = (glong) (val_fx * feedback);
-      GSTBT_DELAY_WRITE (delay, rb_in, CLAMP (val, G_MININT16, G_MAXINT16));
-      val = (glong) (wet * val_fx);
-      sum_fx += abs (val);
-      *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
-    }
-  } else {
-    for (i = 0; i < num_samples; i++) {
-      GSTBT_DELAY_READ (delay, rb_out, val_fx);
-      val_dry = (gdouble) * data;
-      val = (glong) (val_fx * feedback + val_dry);
-      GSTBT_DELAY_WRITE (delay, rb_in, CLAMP (val, G_MININT16, G_MAXINT16));
-      val = (glong) (wet * val_fx + dry * val_dry);
-      sum_fx += abs (val);
-      *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
-    }
+  /* the echos have decayed and the input is silence, nothing to do */
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && self->tail_done)
+    return GST_FLOW_OK;
+  self->tail_done = FALSE;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
   }
-  GSTBT_DELAY_AFTER (delay, rb_in, rb_out);
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
 
-  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && sum_fx) {
+  /* input is silence */
+  silent = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
+      gst_base_transform_is_passthrough (base);
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (!self->delays)) {
+    GST_OBJECT_UNLOCK (self);
+    gst_buffer_unmap (outbuf, &info);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+  fpu_state = gstbt_denormal_enter ();
+  audible = gstbt_audio_delay_process (self, info.data, num_frames, silent);
+  if (silent)
+    gstbt_audio_delay_check_tail (self);
+  gstbt_denormal_leave (fpu_state);
+  GST_OBJECT_UNLOCK (self);
+
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && audible) {
     GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
   }
 
@@ -187,8 +462,9 @@ gstbt_audio_delay_stop (GstBaseTransform * base)
 {
   GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (base);
 
-  if (self->delay)
-    gstbt_delay_stop (self->delay);
+  GST_OBJECT_LOCK (self);
+  gstbt_audio_delay_free_delays (self);
+  GST_OBJECT_UNLOCK (self);
 
   return TRUE;
 }
@@ -234,7 +510,10 @@ gstbt_audio_delay_tempo_change_tempo (GstBtTempo * tempo,
   if (changed) {
     GST_DEBUG ("changing tempo to %ld BPM  %ld TPB  %ld STPT",
         self->beats_per_minute, self->ticks_per_beat, self->subticks_per_tick);
+    GST_OBJECT_LOCK (self);
     gstbt_audio_delay_calculate_tick_time (self);
+    gstbt_audio_delay_update_delay (self);
+    GST_OBJECT_UNLOCK (self);
   }
 }
 
@@ -258,12 +537,33 @@ gstbt_audio_delay_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_DRYWET:
       self->drywet = g_value_get_uint (value);
+      gstbt_smoother_set_target (&self->drywet_smoother, self->drywet / 100.0);
       break;
     case PROP_FEEDBACK:
       self->feedback = g_value_get_uint (value);
+      gstbt_smoother_set_target (&self->feedback_smoother,
+          self->feedback / 100.0);
       break;
     case PROP_DELAYTIME:
-      g_object_set_property ((GObject *) (self->delay), pspec->name, value);
+      GST_OBJECT_LOCK (self);
+      self->delaytime = g_value_get_uint (value);
+      gstbt_audio_delay_update_delay (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PING_PONG:
+      self->ping_pong = g_value_get_boolean (value);
+      break;
+    case PROP_TIME_MODE:
+      GST_OBJECT_LOCK (self);
+      self->time_mode = g_value_get_enum (value);
+      gstbt_audio_delay_update_delay (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SYNC_TIME:
+      GST_OBJECT_LOCK (self);
+      self->sync_time = g_value_get_uint (value);
+      gstbt_audio_delay_update_delay (self);
+      GST_OBJECT_UNLOCK (self);
       break;
       // tempo iface
     case PROP_BPM:
@@ -291,7 +591,16 @@ gstbt_audio_delay_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value, self->feedback);
       break;
     case PROP_DELAYTIME:
-      g_object_get_property ((GObject *) (self->delay), pspec->name, value);
+      g_value_set_uint (value, self->delaytime);
+      break;
+    case PROP_PING_PONG:
+      g_value_set_boolean (value, self->ping_pong);
+      break;
+    case PROP_TIME_MODE:
+      g_value_set_enum (value, self->time_mode);
+      break;
+    case PROP_SYNC_TIME:
+      g_value_set_uint (value, self->sync_time);
       break;
       // tempo iface
     case PROP_BPM:
@@ -314,8 +623,7 @@ gstbt_audio_delay_finalize (GObject * object)
 {
   GstBtAudioDelay *self = GSTBT_AUDIO_DELAY (object);
 
-  if (self->delay)
-    g_object_unref (self->delay);
+  gstbt_audio_delay_free_delays (self);
 
   G_OBJECT_CLASS (gstbt_audio_delay_parent_class)->finalize (object);
 }
@@ -327,15 +635,20 @@ gstbt_audio_delay_init (GstBtAudioDelay * self)
 {
   self->drywet = 50;
   self->feedback = 50;
+  self->delaytime = 100;
+  self->time_mode = GSTBT_AUDIO_DELAY_TIME_MODE_ABSOLUTE;
+  self->sync_time = 3;
 
   self->samplerate = GST_AUDIO_DEF_RATE;
+  gstbt_smoother_init (&self->drywet_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->drywet / 100.0);
+  gstbt_smoother_init (&self->feedback_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->feedback / 100.0);
   self->beats_per_minute = 120;
   self->ticks_per_beat = 4;
   self->subticks_per_tick = 1;
   gstbt_audio_delay_calculate_tick_time (self);
-
-  /* effect components */
-  self->delay = gstbt_delay_new ();
+  gst_audio_info_init (&self->info);
 
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
 }
@@ -373,11 +686,27 @@ gstbt_audio_delay_class_init (GstBtAudioDelayClass * klass)
   g_object_class_install_property (gobject_class, PROP_DELAYTIME,
       g_param_spec_uint ("delaytime", "Delay time",
           "Time difference between two echos as milliseconds", 1,
-          1000, 100, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+          MAX_DELAYTIME, 100, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TIME_MODE,
+      g_param_spec_enum ("time-mode", "Time mode",
+          "Use the absolute delay time or sync the delay to the tempo",
+          GSTBT_TYPE_AUDIO_DELAY_TIME_MODE,
+          GSTBT_AUDIO_DELAY_TIME_MODE_ABSOLUTE,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_SYNC_TIME,
+      g_param_spec_uint ("sync-time", "Sync time",
+          "Time difference between two echos in ticks or beats", 1,
+          MAX_SYNC_TIME, 3, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_PING_PONG,
+      g_param_spec_boolean ("ping-pong", "Ping-pong",
+          "Feed the echos of a channel back into the next channel", FALSE,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
 
   gstbasetransform_class->set_caps =
       GST_DEBUG_FUNCPTR (gstbt_audio_delay_set_caps);
-  gstbasetransform_class->start = GST_DEBUG_FUNCPTR (gstbt_audio_delay_start);
   gstbasetransform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gstbt_audio_delay_transform_ip);
   gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gstbt_audio_delay_stop);
@@ -21,10 +21,31 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
 #include <libgstbuzztrax/delay.h>
+#include <libgstbuzztrax/smoother.h>
 
 G_BEGIN_DECLS
 
+#define GSTBT_TYPE_AUDIO_DELAY_TIME_MODE (gstbt_audio_delay_time_mode_get_type())
+
+/**
+ * GstBtAudioDelayTimeMode:
+ * @GSTBT_AUDIO_DELAY_TIME_MODE_ABSOLUTE: use #GstBtAudioDelay:delaytime
+ * @GSTBT_AUDIO_DELAY_TIME_MODE_TICKS: #GstBtAudioDelay:sync-time is in ticks
+ * @GSTBT_AUDIO_DELAY_TIME_MODE_BEATS: #GstBtAudioDelay:sync-time is in beats
+ *
+ * How the delay time is specified.
+ */
+typedef enum
+{
+  GSTBT_AUDIO_DELAY_TIME_MODE_ABSOLUTE,
+  GSTBT_AUDIO_DELAY_TIME_MODE_TICKS,
+  GSTBT_AUDIO_DELAY_TIME_MODE_BEATS
+} GstBtAudioDelayTimeMode;
+
+GType gstbt_audio_delay_time_mode_get_type (void);
+
 #define GSTBT_TYPE_AUDIO_DELAY            (gstbt_audio_delay_get_type())
 #define GSTBT_AUDIO_DELAY(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_AUDIO_DELAY,GstBtAudioDelay))
 #define GSTBT_IS_AUDIO_DELAY(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_AUDIO_DELAY))
@@ -47,9 +68,20 @@ struct _GstBtAudioDelay {
   /* properties */
   guint drywet;
   guint feedback;
+  guint delaytime;
+  gboolean ping_pong;
+  GstBtAudioDelayTimeMode time_mode;
+  guint sync_time;
+  GstBtSmoother drywet_smoother, feedback_smoother;
 
+  GstAudioInfo info;
   gint samplerate;
-  GstBtDelay *delay;
+  guint channels;
+  GstBtDelay **delays;          /* one delay line per channel */
+  gfloat *dry;                  /* input/output of the current block per channel */
+  gfloat *fx;                   /* echos of the current block per channel */
+  guint quiet_frames;           /* frames since the echos went below -100 dB */
+  gboolean tail_done;           /* delay lines are cleared, bypass gaps */
 
   /* tempo handling */
   gulong beats_per_minute;
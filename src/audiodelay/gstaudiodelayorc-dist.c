@@ -0,0 +1,565 @@
+
+/* autogenerated from gstaudiodelayorc.orc */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <glib.h>
+
+#ifndef _ORC_INTEGER_TYPEDEFS_
+#define _ORC_INTEGER_TYPEDEFS_
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#include <stdint.h>
+typedef int8_t orc_int8;
+typedef int16_t orc_int16;
+typedef int32_t orc_int32;
+typedef int64_t orc_int64;
+typedef uint8_t orc_uint8;
+typedef uint16_t orc_uint16;
+typedef uint32_t orc_uint32;
+typedef uint64_t orc_uint64;
+#define ORC_UINT64_C(x) UINT64_C(x)
+#elif defined(_MSC_VER)
+typedef signed __int8 orc_int8;
+typedef signed __int16 orc_int16;
+typedef signed __int32 orc_int32;
+typedef signed __int64 orc_int64;
+typedef unsigned __int8 orc_uint8;
+typedef unsigned __int16 orc_uint16;
+typedef unsigned __int32 orc_uint32;
+typedef unsigned __int64 orc_uint64;
+#define ORC_UINT64_C(x) (x##Ui64)
+#define inline __inline
+#else
+#include <limits.h>
+typedef signed char orc_int8;
+typedef short orc_int16;
+typedef int orc_int32;
+typedef unsigned char orc_uint8;
+typedef unsigned short orc_uint16;
+typedef unsigned int orc_uint32;
+#if INT_MAX == LONG_MAX
+typedef long long orc_int64;
+typedef unsigned long long orc_uint64;
+#define ORC_UINT64_C(x) (x##ULL)
+#else
+typedef long orc_int64;
+typedef unsigned long orc_uint64;
+#define ORC_UINT64_C(x) (x##UL)
+#endif
+#endif
+typedef union { orc_int16 i; orc_int8 x2[2]; } orc_union16;
+typedef union { orc_int32 i; float f; orc_int16 x2[2]; orc_int8 x4[4]; } orc_union32;
+typedef union { orc_int64 i; double f; orc_int32 x2[2]; float x2f[2]; orc_int16 x4[4]; } orc_union64;
+#endif
+#ifndef ORC_RESTRICT
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define ORC_RESTRICT restrict
+#elif defined(__GNUC__) && __GNUC__ >= 4
+#define ORC_RESTRICT __restrict__
+#else
+#define ORC_RESTRICT
+#endif
+#endif
+
+#ifndef ORC_INTERNAL
+#if defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
+#define ORC_INTERNAL __attribute__((visibility("hidden")))
+#elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x550)
+#define ORC_INTERNAL __hidden
+#elif defined (__GNUC__)
+#define ORC_INTERNAL __attribute__((visibility("hidden")))
+#else
+#define ORC_INTERNAL
+#endif
+#endif
+
+
+#ifndef DISABLE_ORC
+#include <orc/orc.h>
+#endif
+void orc_audio_delay_feedback_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const float * ORC_RESTRICT s2, const double * ORC_RESTRICT s3, float p1, float p2, int n);
+void orc_audio_delay_mix_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const double * ORC_RESTRICT s2, int n);
+
+
+/* begin Orc C target preamble */
+#define ORC_CLAMP(x,a,b) ((x)<(a) ? (a) : ((x)>(b) ? (b) : (x)))
+#define ORC_ABS(a) ((a)<0 ? -(a) : (a))
+#define ORC_MIN(a,b) ((a)<(b) ? (a) : (b))
+#define ORC_MAX(a,b) ((a)>(b) ? (a) : (b))
+#define ORC_SB_MAX 127
+#define ORC_SB_MIN (-1-ORC_SB_MAX)
+#define ORC_UB_MAX 255
+#define ORC_UB_MIN 0
+#define ORC_SW_MAX 32767
+#define ORC_SW_MIN (-1-ORC_SW_MAX)
+#define ORC_UW_MAX 65535
+#define ORC_UW_MIN 0
+#define ORC_SL_MAX 2147483647
+#define ORC_SL_MIN (-1-ORC_SL_MAX)
+#define ORC_UL_MAX 4294967295U
+#define ORC_UL_MIN 0
+#define ORC_CLAMP_SB(x) ORC_CLAMP(x,ORC_SB_MIN,ORC_SB_MAX)
+#define ORC_CLAMP_UB(x) ORC_CLAMP(x,ORC_UB_MIN,ORC_UB_MAX)
+#define ORC_CLAMP_SW(x) ORC_CLAMP(x,ORC_SW_MIN,ORC_SW_MAX)
+#define ORC_CLAMP_UW(x) ORC_CLAMP(x,ORC_UW_MIN,ORC_UW_MAX)
+#define ORC_CLAMP_SL(x) ORC_CLAMP(x,ORC_SL_MIN,ORC_SL_MAX)
+#define ORC_CLAMP_UL(x) ORC_CLAMP(x,ORC_UL_MIN,ORC_UL_MAX)
+#define ORC_SWAP_W(x) ((((x)&0xff)<<8) | (((x)&0xff00)>>8))
+#define ORC_SWAP_L(x) ((((x)&0xff)<<24) | (((x)&0xff00)<<8) | (((x)&0xff0000)>>8) | (((x)&0xff000000)>>24))
+#define ORC_SWAP_Q(x) ((((x)&ORC_UINT64_C(0xff))<<56) | (((x)&ORC_UINT64_C(0xff00))<<40) | (((x)&ORC_UINT64_C(0xff0000))<<24) | (((x)&ORC_UINT64_C(0xff000000))<<8) | (((x)&ORC_UINT64_C(0xff00000000))>>8) | (((x)&ORC_UINT64_C(0xff0000000000))>>24) | (((x)&ORC_UINT64_C(0xff000000000000))>>40) | (((x)&ORC_UINT64_C(0xff00000000000000))>>56))
+#define ORC_PTR_OFFSET(ptr,offset) ((void *)(((unsigned char *)(ptr)) + (offset)))
+#define ORC_DENORMAL(x) ((x) & ((((x)&0x7f800000) == 0) ? 0xff800000 : 0xffffffff))
+#define ORC_ISNAN(x) ((((x)&0x7f800000) == 0x7f800000) && (((x)&0x007fffff) != 0))
+#define ORC_DENORMAL_DOUBLE(x) ((x) & ((((x)&ORC_UINT64_C(0x7ff0000000000000)) == 0) ? ORC_UINT64_C(0xfff0000000000000) : ORC_UINT64_C(0xffffffffffffffff)))
+#define ORC_ISNAN_DOUBLE(x) ((((x)&ORC_UINT64_C(0x7ff0000000000000)) == ORC_UINT64_C(0x7ff0000000000000)) && (((x)&ORC_UINT64_C(0x000fffffffffffff)) != 0))
+#ifndef ORC_RESTRICT
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define ORC_RESTRICT restrict
+#elif defined(__GNUC__) && __GNUC__ >= 4
+#define ORC_RESTRICT __restrict__
+#else
+#define ORC_RESTRICT
+#endif
+#endif
+/* end Orc C target preamble */
+
+
+
+
+/* orc_audio_delay_feedback_f32 */
+#ifdef DISABLE_ORC
+void
+orc_audio_delay_feedback_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const float * ORC_RESTRICT s2, const double * ORC_RESTRICT s3, float p1, float p2, int n){
+  int i;
+  orc_union32 * ORC_RESTRICT ptr0;
+  const orc_union32 * ORC_RESTRICT ptr4;
+  const orc_union32 * ORC_RESTRICT ptr5;
+  const orc_union64 * ORC_RESTRICT ptr6;
+  orc_union64 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+
+  ptr0 = (orc_union32 *)d1;
+  ptr4 = (orc_union32 *)s1;
+  ptr5 = (orc_union32 *)s2;
+  ptr6 = (orc_union64 *)s3;
+
+    /* 6: loadpl */
+    var36.f = p1;
+    /* 8: loadpl */
+    var37.f = p2;
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr6[i];
+    /* 1: convdf */
+    {
+       orc_union64 _src1;
+       orc_union32 _dest;
+       _src1.i = ORC_DENORMAL_DOUBLE(var33.i);
+       _dest.f = _src1.f;
+       var39.i = ORC_DENORMAL(_dest.i);
+    }
+    /* 2: loadl */
+    var34 = ptr5[i];
+    /* 3: mulf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var34.i);
+       _dest1.f = _src1.f * _src2.f;
+       var39.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 4: loadl */
+    var35 = ptr4[i];
+    /* 5: addf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var35.i);
+       _dest1.f = _src1.f + _src2.f;
+       var39.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 7: maxf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var36.i);
+       if (ORC_ISNAN(_src1.i))
+         var40.i = _src1.i;
+       else if (ORC_ISNAN(_src2.i))
+         var40.i = _src2.i;
+       else
+         var40.f = (_src1.f > _src2.f) ? _src1.f : _src2.f;
+    }
+    /* 9: minf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       _src1.i = ORC_DENORMAL(var40.i);
+       _src2.i = ORC_DENORMAL(var37.i);
+       if (ORC_ISNAN(_src1.i))
+         var38.i = _src1.i;
+       else if (ORC_ISNAN(_src2.i))
+         var38.i = _src2.i;
+       else
+         var38.f = (_src1.f < _src2.f) ? _src1.f : _src2.f;
+    }
+    /* 10: storel */
+    ptr0[i] = var38;
+  }
+
+}
+
+#else
+static void
+_backup_orc_audio_delay_feedback_f32 (OrcExecutor * ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union32 * ORC_RESTRICT ptr0;
+  const orc_union32 * ORC_RESTRICT ptr4;
+  const orc_union32 * ORC_RESTRICT ptr5;
+  const orc_union64 * ORC_RESTRICT ptr6;
+  orc_union64 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+  orc_union32 var38;
+  orc_union32 var39;
+  orc_union32 var40;
+
+  ptr0 = (orc_union32 *)ex->arrays[0];
+  ptr4 = (orc_union32 *)ex->arrays[4];
+  ptr5 = (orc_union32 *)ex->arrays[5];
+  ptr6 = (orc_union64 *)ex->arrays[6];
+
+    /* 6: loadpl */
+    var36.i = ex->params[24];
+    /* 8: loadpl */
+    var37.i = ex->params[25];
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr6[i];
+    /* 1: convdf */
+    {
+       orc_union64 _src1;
+       orc_union32 _dest;
+       _src1.i = ORC_DENORMAL_DOUBLE(var33.i);
+       _dest.f = _src1.f;
+       var39.i = ORC_DENORMAL(_dest.i);
+    }
+    /* 2: loadl */
+    var34 = ptr5[i];
+    /* 3: mulf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var34.i);
+       _dest1.f = _src1.f * _src2.f;
+       var39.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 4: loadl */
+    var35 = ptr4[i];
+    /* 5: addf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var35.i);
+       _dest1.f = _src1.f + _src2.f;
+       var39.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 7: maxf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       _src1.i = ORC_DENORMAL(var39.i);
+       _src2.i = ORC_DENORMAL(var36.i);
+       if (ORC_ISNAN(_src1.i))
+         var40.i = _src1.i;
+       else if (ORC_ISNAN(_src2.i))
+         var40.i = _src2.i;
+       else
+         var40.f = (_src1.f > _src2.f) ? _src1.f : _src2.f;
+    }
+    /* 9: minf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       _src1.i = ORC_DENORMAL(var40.i);
+       _src2.i = ORC_DENORMAL(var37.i);
+       if (ORC_ISNAN(_src1.i))
+         var38.i = _src1.i;
+       else if (ORC_ISNAN(_src2.i))
+         var38.i = _src2.i;
+       else
+         var38.f = (_src1.f < _src2.f) ? _src1.f : _src2.f;
+    }
+    /* 10: storel */
+    ptr0[i] = var38;
+  }
+
+}
+
+void
+orc_audio_delay_feedback_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const float * ORC_RESTRICT s2, const double * ORC_RESTRICT s3, float p1, float p2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcProgram *p = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+
+      p = orc_program_new ();
+      orc_program_set_name (p, "orc_audio_delay_feedback_f32");
+      orc_program_set_backup_function (p, _backup_orc_audio_delay_feedback_f32);
+      orc_program_add_destination (p, 4, "d1");
+      orc_program_add_source (p, 4, "s1");
+      orc_program_add_source (p, 4, "s2");
+      orc_program_add_source (p, 8, "s3");
+      orc_program_add_parameter_float (p, 4, "p1");
+      orc_program_add_parameter_float (p, 4, "p2");
+      orc_program_add_temporary (p, 4, "t1");
+      orc_program_add_temporary (p, 4, "t2");
+
+      orc_program_append (p, "convdf", ORC_VAR_T1, ORC_VAR_S3, ORC_VAR_D1);
+      orc_program_append (p, "mulf", ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_S2);
+      orc_program_append (p, "addf", ORC_VAR_T1, ORC_VAR_T1, ORC_VAR_S1);
+      orc_program_append (p, "maxf", ORC_VAR_T2, ORC_VAR_T1, ORC_VAR_P1);
+      orc_program_append (p, "minf", ORC_VAR_D1, ORC_VAR_T2, ORC_VAR_P2);
+
+      orc_program_compile (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->program = p;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *)s1;
+  ex->arrays[ORC_VAR_S2] = (void *)s2;
+  ex->arrays[ORC_VAR_S3] = (void *)s3;
+  {
+    orc_union32 tmp;
+    tmp.f = p1;
+    ex->params[ORC_VAR_P1] = tmp.i;
+  }
+  {
+    orc_union32 tmp;
+    tmp.f = p2;
+    ex->params[ORC_VAR_P2] = tmp.i;
+  }
+
+  func = p->code_exec;
+  func (ex);
+}
+#endif
+
+
+/* orc_audio_delay_mix_f32 */
+#ifdef DISABLE_ORC
+void
+orc_audio_delay_mix_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const double * ORC_RESTRICT s2, int n){
+  int i;
+  orc_union32 * ORC_RESTRICT ptr0;
+  const orc_union32 * ORC_RESTRICT ptr4;
+  const orc_union64 * ORC_RESTRICT ptr5;
+  orc_union32 var32;
+  orc_union64 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+
+  ptr0 = (orc_union32 *)d1;
+  ptr4 = (orc_union32 *)s1;
+  ptr5 = (orc_union64 *)s2;
+
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr5[i];
+    /* 1: convdf */
+    {
+       orc_union64 _src1;
+       orc_union32 _dest;
+       _src1.i = ORC_DENORMAL_DOUBLE(var33.i);
+       _dest.f = _src1.f;
+       var36.i = ORC_DENORMAL(_dest.i);
+    }
+    /* 2: loadl */
+    var34 = ptr4[i];
+    /* 3: loadl */
+    var32 = ptr0[i];
+    /* 4: subf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var34.i);
+       _src2.i = ORC_DENORMAL(var32.i);
+       _dest1.f = _src1.f - _src2.f;
+       var37.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 5: mulf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var37.i);
+       _src2.i = ORC_DENORMAL(var36.i);
+       _dest1.f = _src1.f * _src2.f;
+       var37.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 6: addf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var32.i);
+       _src2.i = ORC_DENORMAL(var37.i);
+       _dest1.f = _src1.f + _src2.f;
+       var35.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 7: storel */
+    ptr0[i] = var35;
+  }
+
+}
+
+#else
+static void
+_backup_orc_audio_delay_mix_f32 (OrcExecutor * ex)
+{
+  int i;
+  int n = ex->n;
+  orc_union32 * ORC_RESTRICT ptr0;
+  const orc_union32 * ORC_RESTRICT ptr4;
+  const orc_union64 * ORC_RESTRICT ptr5;
+  orc_union32 var32;
+  orc_union64 var33;
+  orc_union32 var34;
+  orc_union32 var35;
+  orc_union32 var36;
+  orc_union32 var37;
+
+  ptr0 = (orc_union32 *)ex->arrays[0];
+  ptr4 = (orc_union32 *)ex->arrays[4];
+  ptr5 = (orc_union64 *)ex->arrays[5];
+
+
+  for (i = 0; i < n; i++) {
+    /* 0: loadq */
+    var33 = ptr5[i];
+    /* 1: convdf */
+    {
+       orc_union64 _src1;
+       orc_union32 _dest;
+       _src1.i = ORC_DENORMAL_DOUBLE(var33.i);
+       _dest.f = _src1.f;
+       var36.i = ORC_DENORMAL(_dest.i);
+    }
+    /* 2: loadl */
+    var34 = ptr4[i];
+    /* 3: loadl */
+    var32 = ptr0[i];
+    /* 4: subf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var34.i);
+       _src2.i = ORC_DENORMAL(var32.i);
+       _dest1.f = _src1.f - _src2.f;
+       var37.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 5: mulf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var37.i);
+       _src2.i = ORC_DENORMAL(var36.i);
+       _dest1.f = _src1.f * _src2.f;
+       var37.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 6: addf */
+    {
+       orc_union32 _src1;
+       orc_union32 _src2;
+       orc_union32 _dest1;
+       _src1.i = ORC_DENORMAL(var32.i);
+       _src2.i = ORC_DENORMAL(var37.i);
+       _dest1.f = _src1.f + _src2.f;
+       var35.i = ORC_DENORMAL(_dest1.i);
+    }
+    /* 7: storel */
+    ptr0[i] = var35;
+  }
+
+}
+
+void
+orc_audio_delay_mix_f32 (float * ORC_RESTRICT d1, const float * ORC_RESTRICT s1, const double * ORC_RESTRICT s2, int n)
+{
+  OrcExecutor _ex, *ex = &_ex;
+  static volatile int p_inited = 0;
+  static OrcProgram *p = 0;
+  void (*func) (OrcExecutor *);
+
+  if (!p_inited) {
+    orc_once_mutex_lock ();
+    if (!p_inited) {
+
+      p = orc_program_new ();
+      orc_program_set_name (p, "orc_audio_delay_mix_f32");
+      orc_program_set_backup_function (p, _backup_orc_audio_delay_mix_f32);
+      orc_program_add_destination (p, 4, "d1");
+      orc_program_add_source (p, 4, "s1");
+      orc_program_add_source (p, 8, "s2");
+      orc_program_add_temporary (p, 4, "t1");
+      orc_program_add_temporary (p, 4, "t2");
+
+      orc_program_append (p, "convdf", ORC_VAR_T1, ORC_VAR_S2, ORC_VAR_D1);
+      orc_program_append (p, "subf", ORC_VAR_T2, ORC_VAR_S1, ORC_VAR_D1);
+      orc_program_append (p, "mulf", ORC_VAR_T2, ORC_VAR_T2, ORC_VAR_T1);
+      orc_program_append (p, "addf", ORC_VAR_D1, ORC_VAR_D1, ORC_VAR_T2);
+
+      orc_program_compile (p);
+    }
+    p_inited = TRUE;
+    orc_once_mutex_unlock ();
+  }
+  ex->program = p;
+
+  ex->n = n;
+  ex->arrays[ORC_VAR_D1] = d1;
+  ex->arrays[ORC_VAR_S1] = (void *)s1;
+  ex->arrays[ORC_VAR_S2] = (void *)s2;
+
+  func = p->code_exec;
+  func (ex);
+}
+#endif
+
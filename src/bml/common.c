@@ -1009,7 +1009,9 @@ gstbml_dispose (GstBML * bml)
  * @info: the GstMapInfo for the data buffer
  * @has_data: indication wheter the buffer has values != 0.0
  *
- * Fixes elements that output denormalized values (sets them to 0.0).
+ * Checks for silence and scales the data to the gstreamer range. On platforms
+ * that can't flush denormals to zero, it also fixes elements that output
+ * denormalized values (sets them to 0.0).
  *
  * Returns: TRUE if the gap flag could be set
  */
@@ -1023,15 +1025,17 @@ gstbml_fix_data (GstElement * elem, GstMapInfo * info, gboolean has_data)
     has_data = FALSE;
 
     // see also http://www.musicdsp.org/archive.php?classid=5#191
+#ifdef GSTBT_DENORMAL_HAVE_FTZ
+    /* the machines run with denormals flushed to zero, see the
+     * gstbt_denormal_enter() calls around work() */
     for (i = 0; i < num_samples; i++) {
       if (data[i] != 0.0) {
         has_data = TRUE;
         break;
       }
-/* FIXME(ensonic): we configure the FPU to DAZ|FZ in libbuzztrax-core
- * this would not apply to other clients
- */
-#if 0
+    }
+#else
+    for (i = 0; i < num_samples; i++) {
       /* isnormal checks for != zero */
       if (G_LIKELY (isnormal (data[i]))) {
         has_data = TRUE;
@@ -1042,13 +1046,11 @@ gstbml_fix_data (GstElement * elem, GstMapInfo * info, gboolean has_data)
         } else if (isinf (data[i])) {
           GST_WARNING_OBJECT (elem, "data contains Inf");
         } else if (data[i] != 0.0) {    //fpclassify(data[i])==FP_SUBNORMAL
-          GST_WARNING_OBJECT (bml_transform, "data contains Denormal");
+          GST_LOG_OBJECT (elem, "data contains Denormal");
         }
         data[i] = 0.0;
       }
-#endif
     }
-#if 0
     for (; i < num_samples; i++) {
       if (G_UNLIKELY (!isnormal (data[i]))) {
         data[i] = 0.0;
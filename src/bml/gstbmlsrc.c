@@ -430,6 +430,7 @@ gst_bml_src_create_mono (GstBaseSrc * base, GstClockTime offset, guint length,
   gpointer bm = bml->bm;
   guint todo, seg_size, samples_per_buffer;
   gboolean has_data;
+  guint fpu_state;
   gboolean partial_buffer = FALSE;
 
   if (G_UNLIKELY (bml->eos_reached)) {
@@ -532,6 +533,7 @@ gst_bml_src_create_mono (GstBaseSrc * base, GstClockTime offset, guint length,
   todo = samples_per_buffer;
   seg_data = data;
   has_data = FALSE;
+  fpu_state = gstbt_denormal_enter ();
   while (todo) {
     // 256 is MachineInterface.h::MAX_BUFFER_LENGTH
     seg_size = (todo > 256) ? 256 : todo;
@@ -540,6 +542,7 @@ gst_bml_src_create_mono (GstBaseSrc * base, GstClockTime offset, guint length,
     seg_data = &seg_data[seg_size];
     todo -= seg_size;
   }
+  gstbt_denormal_leave (fpu_state);
   if (gstbml_fix_data ((GstElement *) bml_src, &info, has_data)) {
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   } else {
@@ -571,6 +574,7 @@ gst_bml_src_create_stereo (GstBaseSrc * base, GstClockTime offset, guint length,
   gpointer bm = bml->bm;
   guint todo, seg_size, samples_per_buffer;
   gboolean has_data;
+  guint fpu_state;
   gboolean partial_buffer = FALSE;
 
   if (G_UNLIKELY (bml->eos_reached)) {
@@ -674,6 +678,7 @@ gst_bml_src_create_stereo (GstBaseSrc * base, GstClockTime offset, guint length,
   todo = samples_per_buffer;
   seg_data = data;
   has_data = FALSE;
+  fpu_state = gstbt_denormal_enter ();
   while (todo) {
     // 256 is MachineInterface.h::MAX_BUFFER_LENGTH
     seg_size = (todo > 256) ? 256 : todo;
@@ -683,6 +688,7 @@ gst_bml_src_create_stereo (GstBaseSrc * base, GstClockTime offset, guint length,
     seg_data = &seg_data[seg_size * 2];
     todo -= seg_size;
   }
+  gstbt_denormal_leave (fpu_state);
   if (gstbml_fix_data ((GstElement *) bml_src, &info, has_data)) {
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   } else {
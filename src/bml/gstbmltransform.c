@@ -288,6 +288,7 @@ gst_bml_transform_transform_ip_mono (GstBaseTransform * base,
   gpointer bm = bml->bm;
   guint todo, seg_size, samples_per_buffer;
   gboolean has_data;
+  guint fpu_state;
   guint mode = 3;               /*WM_READWRITE */
 
   bml->running_time =
@@ -333,6 +334,7 @@ gst_bml_transform_transform_ip_mono (GstBaseTransform * base,
   todo = samples_per_buffer;
   seg_data = data;
   has_data = FALSE;
+  fpu_state = gstbt_denormal_enter ();
   while (todo) {
     // 256 is MachineInterface.h::MAX_BUFFER_LENGTH
     seg_size = (todo > 256) ? 256 : todo;
@@ -340,6 +342,7 @@ gst_bml_transform_transform_ip_mono (GstBaseTransform * base,
     seg_data = &seg_data[seg_size];
     todo -= seg_size;
   }
+  gstbt_denormal_leave (fpu_state);
   if (gstbml_fix_data ((GstElement *) bml_transform, &info, has_data)) {
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
   } else {
@@ -364,6 +367,7 @@ gst_bml_transform_transform_ip_stereo (GstBaseTransform * base,
   gpointer bm = bml->bm;
   guint todo, seg_size, samples_per_buffer;
   gboolean has_data;
+  guint fpu_state;
   guint mode = 3;               /*WM_READWRITE */
 
   bml->running_time =
@@ -408,6 +412,7 @@ gst_bml_transform_transform_ip_stereo (GstBaseTransform * base,
   todo = samples_per_buffer;
   seg_data = data;
   has_data = FALSE;
+  fpu_state = gstbt_denormal_enter ();
   while (todo) {
     // 256 is MachineInterface.h::MAX_BUFFER_LENGTH
     seg_size = (todo > 256) ? 256 : todo;
@@ -416,6 +421,7 @@ gst_bml_transform_transform_ip_stereo (GstBaseTransform * base,
     seg_data = &seg_data[seg_size * 2];
     todo -= seg_size;
   }
+  gstbt_denormal_leave (fpu_state);
   if (gstbml_fix_data ((GstElement *) bml_transform, &info, has_data)) {
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
   } else {
@@ -440,6 +446,7 @@ gst_bml_transform_transform_mono_to_stereo (GstBaseTransform * base,
   gpointer bm = bml->bm;
   guint todo, seg_size, samples_per_buffer;
   gboolean has_data;
+  guint fpu_state;
   guint mode = 3;               /*WM_READWRITE */
 
   bml->running_time =
@@ -497,6 +504,7 @@ gst_bml_transform_transform_mono_to_stereo (GstBaseTransform * base,
   seg_datai = datai;
   seg_datao = datao;
   has_data = FALSE;
+  fpu_state = gstbt_denormal_enter ();
   while (todo) {
     // 256 is MachineInterface.h::MAX_BUFFER_LENGTH
     seg_size = (todo > 256) ? 256 : todo;
@@ -505,6 +513,7 @@ gst_bml_transform_transform_mono_to_stereo (GstBaseTransform * base,
     seg_datao = &seg_datao[seg_size * 2];
     todo -= seg_size;
   }
+  gstbt_denormal_leave (fpu_state);
   if (gstbml_fix_data ((GstElement *) bml_transform, &infoo, has_data)) {
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
   } else {
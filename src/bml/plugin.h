@@ -40,6 +40,7 @@
 #include <gst/audio/audio.h>
 //-- gstbuzztrax
 #include <libgstbuzztrax/childbin.h>
+#include <libgstbuzztrax/denormal.h>
 #include <libgstbuzztrax/musicenums.h>
 #include <libgstbuzztrax/toneconversion.h>
 #include <libgstbuzztrax/propertymeta.h>
@@ -0,0 +1,780 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * chorus.c: chorus and flanger effect
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:chorus
+ * @title: GstBtChorus
+ * @short_description: chorus and flanger effect
+ *
+ * <refsect2>
+ * Mixes several copies of the signal, that are read from a delay line with
+ * a slowly modulated delay time. The voices are spread evenly over the
+ * period of the modulation, in multi-channel streams the modulation of each
+ * channel is shifted by a quarter period.
+ *
+ * Long delays (10-30 ms) with a small #GstBtChorus:depth give a chorus, short
+ * delays (1-5 ms) with a single voice and some #GstBtChorus:feedback give a
+ * flanger. The modulation rate can be given in Hz or synced to the song
+ * tempo using #GstBtChorus:sync-time, the #GstBtChorus:rate-mode property
+ * selects which one is used.
+ *
+ * The modulation is evaluated once per block and the delay time is ramped
+ * linearly in between. The fractional delays are read using the
+ * #GstBtChorus:interpolation mode.
+ * <title>Example launch line</title>
+ * <para>
+ * <programlisting>
+ * gst-launch-1.0 filesrc location="melo1.ogg" ! decodebin ! audioconvert ! chorus voices=3 delay=20 depth=3 ! autoaudiosink
+ * gst-launch-1.0 filesrc location="melo1.ogg" ! decodebin ! audioconvert ! chorus voices=1 delay=2 depth=1.5 feedback=70 ! autoaudiosink
+ * </programlisting>
+ * The latter example gives a flanger.
+ * </para>
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include <libgstbuzztrax/denormal.h>
+#include <libgstbuzztrax/tempo.h>
+
+#include "chorus.h"
+
+#define GST_CAT_DEFAULT chorus_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define BLOCK_SIZE 256
+/* level changes are spread over this time (in seconds) */
+#define LEVEL_SMOOTHING 0.01
+/* maximum for the delay and depth properties in ms */
+#define MAX_DELAY 50.0
+#define MAX_DEPTH 20.0
+/* shortest modulated delay in samples, the cubic interpolation needs it */
+#define MIN_READ_DELAY 2.0
+/* maximum for the sync-time property */
+#define MAX_SYNC_TIME 64
+
+enum
+{
+  // static class properties
+  // dynamic class properties
+  PROP_DRYWET = 1,
+  PROP_FEEDBACK,
+  PROP_VOICES,
+  PROP_DELAY,
+  PROP_DEPTH,
+  PROP_RATE,
+  PROP_RATE_MODE,
+  PROP_SYNC_TIME,
+  PROP_INTERPOLATION,
+  // tempo iface
+  PROP_BPM,
+  PROP_TPB,
+  PROP_STPT
+};
+
+#define CHORUS_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CHORUS_CAPS)
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CHORUS_CAPS)
+    );
+
+//-- the class
+
+static void gstbt_chorus_tempo_interface_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstBtChorus, gstbt_chorus, GST_TYPE_BASE_TRANSFORM,
+    G_IMPLEMENT_INTERFACE (GSTBT_TYPE_TEMPO,
+        gstbt_chorus_tempo_interface_init));
+
+//-- enums
+
+GType
+gstbt_chorus_rate_mode_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_CHORUS_RATE_MODE_HZ, "Hz", "hz"},
+    {GSTBT_CHORUS_RATE_MODE_TICKS, "Ticks", "ticks"},
+    {GSTBT_CHORUS_RATE_MODE_BEATS, "Beats", "beats"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtChorusRateMode", enums);
+  }
+  return type;
+}
+
+//-- private methods
+
+static void
+gstbt_chorus_update_rate (GstBtChorus * self)
+{
+  GstClockTime period;
+
+  switch (self->rate_mode) {
+    case GSTBT_CHORUS_RATE_MODE_TICKS:
+      period = self->ticktime * self->sync_time;
+      break;
+    case GSTBT_CHORUS_RATE_MODE_BEATS:
+      period = self->ticktime * self->ticks_per_beat * self->sync_time;
+      break;
+    default:
+      period = 0;
+      break;
+  }
+  if (period) {
+    self->phase_inc = (gdouble) GST_SECOND / ((gdouble) period *
+        self->samplerate);
+  } else {
+    self->phase_inc = self->rate / self->samplerate;
+  }
+  GST_DEBUG_OBJECT (self, "lfo phase increment is %lf", self->phase_inc);
+}
+
+/* fade voices in and out when the number of voices changes */
+static void
+gstbt_chorus_update_voice_gains (GstBtChorus * self, gboolean reset)
+{
+  guint v;
+  gdouble gain;
+
+  for (v = 0; v < GSTBT_CHORUS_MAX_VOICES; v++) {
+    gain = (v < self->voices) ? 1.0 / self->voices : 0.0;
+    if (reset)
+      gstbt_smoother_reset (&self->voice_gains[v], gain);
+    else
+      gstbt_smoother_set_target (&self->voice_gains[v], gain);
+  }
+}
+
+static void
+gstbt_chorus_free_delays (GstBtChorus * self)
+{
+  guint c;
+
+  if (self->delays) {
+    for (c = 0; c < self->channels; c++) {
+      g_object_unref (self->delays[c]);
+    }
+    g_free (self->delays);
+    self->delays = NULL;
+  }
+  g_free (self->last_delays);
+  self->last_delays = NULL;
+  g_free (self->ap_states);
+  self->ap_states = NULL;
+  g_free (self->gains);
+  self->gains = NULL;
+  self->channels = 0;
+}
+
+static void
+gstbt_chorus_flush (GstBtChorus * self)
+{
+  guint c;
+
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_flush (self->delays[c]);
+  }
+  memset (self->ap_states, 0,
+      self->channels * GSTBT_CHORUS_MAX_VOICES * sizeof (gfloat));
+  gstbt_smoother_reset (&self->drywet_smoother, self->drywet / 100.0);
+  gstbt_smoother_reset (&self->feedback_smoother, self->feedback / 100.0);
+  gstbt_chorus_update_voice_gains (self, TRUE);
+}
+
+/* Add the voice read with the delays from @read_delays and scaled by @gain to
+ * @fx. The write position of the first sample is @rb_in. */
+static void
+gstbt_chorus_read_voice (GstBtChorus * self, GstBtDelay * delay, guint rb_in,
+    guint n, const gfloat * read_delays, const gdouble * gain,
+    gfloat * ap_state, gfloat * fx)
+{
+  guint i;
+  gfloat v;
+
+  switch (self->interpolation) {
+    case GSTBT_DELAY_INTERPOLATION_NONE:
+      for (i = 0; i < n; i++) {
+        fx[i] += (gfloat) gain[i] * delay->ring_buffer[(rb_in + i -
+                (guint) (read_delays[i] + 0.5f)) & delay->mask];
+      }
+      break;
+    case GSTBT_DELAY_INTERPOLATION_LINEAR:
+      for (i = 0; i < n; i++) {
+        GSTBT_DELAY_READ_LINEAR (delay, rb_in + i, read_delays[i], v);
+        fx[i] += (gfloat) gain[i] * v;
+      }
+      break;
+    case GSTBT_DELAY_INTERPOLATION_ALLPASS:
+      for (i = 0; i < n; i++) {
+        GSTBT_DELAY_READ_ALLPASS (delay, rb_in + i, read_delays[i], *ap_state,
+            v);
+        fx[i] += (gfloat) gain[i] * v;
+      }
+      break;
+    case GSTBT_DELAY_INTERPOLATION_CUBIC:
+      for (i = 0; i < n; i++) {
+        GSTBT_DELAY_READ_CUBIC (delay, rb_in + i, read_delays[i], v);
+        fx[i] += (gfloat) gain[i] * v;
+      }
+      break;
+  }
+}
+
+/* Process @num_frames interleaved frames in place. If @silent is %TRUE, the
+ * input is ignored and only the feedback is rendered.
+ * Returns %TRUE if the output is not silent.
+ */
+static gboolean
+gstbt_chorus_process (GstBtChorus * self, gpointer data, guint num_frames,
+    gboolean silent)
+{
+  const guint channels = self->channels;
+  const gboolean is_float =
+      (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32);
+  const gdouble ms = self->samplerate / 1000.0;
+  const gfloat centre = (gfloat) (self->delay * ms);
+  const gfloat depth = (gfloat) (self->depth * ms);
+  const gfloat max_delay = (gfloat) ((MAX_DELAY + MAX_DEPTH) * ms);
+  gint16 *d16 = (gint16 *) data;
+  gfloat *d32 = (gfloat *) data;
+  gdouble feedback[BLOCK_SIZE], wet[BLOCK_SIZE];
+  gfloat dry[BLOCK_SIZE], fx[BLOCK_SIZE], fb[BLOCK_SIZE];
+  gfloat read_delays[BLOCK_SIZE];
+  GstBtDelay *delay;
+  gfloat d0, d1, step, min_delay;
+  gdouble phase;
+  guint c, v, i, s, n, k, voices;
+  gboolean audible = FALSE;
+
+  while (num_frames) {
+    /* all voices of a block are read before the block is written, thus a
+     * block must be shorter than the shortest delay in it, the delays ramp
+     * from the last ones towards values that are at least centre-depth */
+    min_delay = MAX (centre - depth, MIN_READ_DELAY);
+    for (k = 0; k < channels * GSTBT_CHORUS_MAX_VOICES; k++) {
+      min_delay = MIN (min_delay, self->last_delays[k]);
+    }
+    n = CLAMP ((guint) min_delay - 1, 1, BLOCK_SIZE);
+    n = MIN (num_frames, n);
+    gstbt_smoother_get_block (&self->feedback_smoother, n, feedback);
+    gstbt_smoother_get_block (&self->drywet_smoother, n, wet);
+    /* also run the voices that are still fading out */
+    for (v = voices = 0; v < GSTBT_CHORUS_MAX_VOICES; v++) {
+      if (v < self->voices || gstbt_smoother_is_active (&self->voice_gains[v]))
+        voices = v + 1;
+    }
+    for (v = 0; v < voices; v++) {
+      gstbt_smoother_get_block (&self->voice_gains[v], n,
+          &self->gains[v * BLOCK_SIZE]);
+    }
+    self->phase += self->phase_inc * n;
+    self->phase -= floor (self->phase);
+
+    for (c = 0; c < channels; c++) {
+      delay = self->delays[c];
+      /* deinterleave */
+      if (silent) {
+        memset (dry, 0, n * sizeof (gfloat));
+      } else if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = d32[s];
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = (gfloat) d16[s];
+        }
+      }
+
+      memset (fx, 0, n * sizeof (gfloat));
+      for (v = 0; v < voices; v++) {
+        k = c * GSTBT_CHORUS_MAX_VOICES + v;
+        phase = self->phase + (gdouble) v / self->voices + c * 0.25;
+        d0 = self->last_delays[k];
+        d1 = centre + depth * (gfloat) sin (2.0 * G_PI * phase);
+        d1 = CLAMP (d1, MIN_READ_DELAY, max_delay);
+        step = (d1 - d0) / n;
+        for (i = 0; i < n; i++) {
+          read_delays[i] = d0 + step * (gfloat) (i + 1);
+        }
+        self->last_delays[k] = d1;
+        gstbt_chorus_read_voice (self, delay, delay->rb_ptr, n, read_delays,
+            &self->gains[v * BLOCK_SIZE], &self->ap_states[k], fx);
+      }
+
+      for (i = 0; i < n; i++) {
+        fb[i] = dry[i] + (gfloat) feedback[i] * fx[i];
+        dry[i] += (gfloat) wet[i] * (fx[i] - dry[i]);
+      }
+      gstbt_delay_write_block (delay, n, fb);
+
+      /* interleave */
+      if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d32[s] = dry[i];
+          audible |= (dry[i] != 0.0);
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d16[s] = (gint16) CLAMP (dry[i], G_MININT16, G_MAXINT16);
+          audible |= (d16[s] != 0);
+        }
+      }
+    }
+    d16 += n * channels;
+    d32 += n * channels;
+    num_frames -= n;
+  }
+  return audible;
+}
+
+//-- basetransform vmethods
+
+static gboolean
+gstbt_chorus_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtChorus *self = GSTBT_CHORUS (base);
+  guint c, k, v, length, max_delay;
+  gfloat centre;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  self->samplerate = GST_AUDIO_INFO_RATE (&self->info);
+  length = (guint) (self->samplerate * LEVEL_SMOOTHING);
+  gstbt_smoother_set_length (&self->drywet_smoother, length);
+  gstbt_smoother_set_length (&self->feedback_smoother, length);
+  for (v = 0; v < GSTBT_CHORUS_MAX_VOICES; v++) {
+    gstbt_smoother_set_length (&self->voice_gains[v], length);
+  }
+  gstbt_chorus_update_rate (self);
+
+  /* one delay line per channel, shared by all voices */
+  gstbt_chorus_free_delays (self);
+  self->channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  max_delay = (guint) ceil ((MAX_DELAY + MAX_DEPTH) * self->samplerate /
+      1000.0);
+  self->delays = g_new (GstBtDelay *, self->channels);
+  for (c = 0; c < self->channels; c++) {
+    self->delays[c] = gstbt_delay_new ();
+    gstbt_delay_start (self->delays[c], self->samplerate, max_delay);
+  }
+  self->last_delays = g_new (gfloat, self->channels * GSTBT_CHORUS_MAX_VOICES);
+  centre = (gfloat) MAX (self->delay * self->samplerate / 1000.0,
+      MIN_READ_DELAY);
+  for (k = 0; k < self->channels * GSTBT_CHORUS_MAX_VOICES; k++) {
+    self->last_delays[k] = centre;
+  }
+  self->ap_states = g_new0 (gfloat, self->channels * GSTBT_CHORUS_MAX_VOICES);
+  self->gains = g_new (gdouble, GSTBT_CHORUS_MAX_VOICES * BLOCK_SIZE);
+  return TRUE;
+}
+
+static GstFlowReturn
+gstbt_chorus_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
+{
+  GstBtChorus *self = GSTBT_CHORUS (base);
+  GstMapInfo info;
+  GstClockTime timestamp;
+  gboolean silent, audible;
+  guint num_frames;
+  guint fpu_state;
+
+  if (G_UNLIKELY (!self->delays))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
+  }
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
+
+  /* flush ring_buffer on DISCONT */
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
+    gstbt_chorus_flush (self);
+  }
+
+  timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    gst_object_sync_values (GST_OBJECT (self), timestamp);
+
+  /* input is silence */
+  silent = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
+      gst_base_transform_is_passthrough (base);
+
+  fpu_state = gstbt_denormal_enter ();
+  audible = gstbt_chorus_process (self, info.data, num_frames, silent);
+  gstbt_denormal_leave (fpu_state);
+
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && audible) {
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+  }
+
+  gst_buffer_unmap (outbuf, &info);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gstbt_chorus_stop (GstBaseTransform * base)
+{
+  GstBtChorus *self = GSTBT_CHORUS (base);
+
+  gstbt_chorus_free_delays (self);
+
+  return TRUE;
+}
+
+//-- interfaces
+
+static void
+gstbt_chorus_calculate_tick_time (GstBtChorus * self)
+{
+  self->ticktime =
+      ((GST_SECOND * 60) / (GstClockTime) (self->beats_per_minute *
+          self->ticks_per_beat));
+}
+
+static void
+gstbt_chorus_tempo_change_tempo (GstBtTempo * tempo, glong beats_per_minute,
+    glong ticks_per_beat, glong subticks_per_tick)
+{
+  GstBtChorus *self = GSTBT_CHORUS (tempo);
+  gboolean changed = FALSE;
+
+  if (beats_per_minute >= 0) {
+    if (self->beats_per_minute != beats_per_minute) {
+      self->beats_per_minute = (gulong) beats_per_minute;
+      g_object_notify (G_OBJECT (self), "beats-per-minute");
+      changed = TRUE;
+    }
+  }
+  if (ticks_per_beat >= 0) {
+    if (self->ticks_per_beat != ticks_per_beat) {
+      self->ticks_per_beat = (gulong) ticks_per_beat;
+      g_object_notify (G_OBJECT (self), "ticks-per-beat");
+      changed = TRUE;
+    }
+  }
+  if (subticks_per_tick >= 0) {
+    if (self->subticks_per_tick != subticks_per_tick) {
+      self->subticks_per_tick = (gulong) subticks_per_tick;
+      g_object_notify (G_OBJECT (self), "subticks-per-tick");
+      changed = TRUE;
+    }
+  }
+  if (changed) {
+    GST_DEBUG ("changing tempo to %ld BPM  %ld TPB  %ld STPT",
+        self->beats_per_minute, self->ticks_per_beat, self->subticks_per_tick);
+    gstbt_chorus_calculate_tick_time (self);
+    gstbt_chorus_update_rate (self);
+  }
+}
+
+static void
+gstbt_chorus_tempo_interface_init (gpointer g_iface, gpointer iface_data)
+{
+  GstBtTempoInterface *iface = g_iface;
+
+  GST_INFO ("initializing iface");
+  iface->change_tempo = gstbt_chorus_tempo_change_tempo;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_chorus_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtChorus *self = GSTBT_CHORUS (object);
+
+  switch (prop_id) {
+    case PROP_DRYWET:
+      self->drywet = g_value_get_uint (value);
+      gstbt_smoother_set_target (&self->drywet_smoother, self->drywet / 100.0);
+      break;
+    case PROP_FEEDBACK:
+      self->feedback = g_value_get_int (value);
+      gstbt_smoother_set_target (&self->feedback_smoother,
+          self->feedback / 100.0);
+      break;
+    case PROP_VOICES:
+      self->voices = g_value_get_uint (value);
+      gstbt_chorus_update_voice_gains (self, FALSE);
+      break;
+    case PROP_DELAY:
+      self->delay = g_value_get_double (value);
+      break;
+    case PROP_DEPTH:
+      self->depth = g_value_get_double (value);
+      break;
+    case PROP_RATE:
+      self->rate = g_value_get_double (value);
+      gstbt_chorus_update_rate (self);
+      break;
+    case PROP_RATE_MODE:
+      self->rate_mode = g_value_get_enum (value);
+      gstbt_chorus_update_rate (self);
+      break;
+    case PROP_SYNC_TIME:
+      self->sync_time = g_value_get_uint (value);
+      gstbt_chorus_update_rate (self);
+      break;
+    case PROP_INTERPOLATION:
+      self->interpolation = g_value_get_enum (value);
+      break;
+      // tempo iface
+    case PROP_BPM:
+    case PROP_TPB:
+    case PROP_STPT:
+      GST_WARNING ("use gstbt_tempo_change_tempo()");
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_chorus_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtChorus *self = GSTBT_CHORUS (object);
+
+  switch (prop_id) {
+    case PROP_DRYWET:
+      g_value_set_uint (value, self->drywet);
+      break;
+    case PROP_FEEDBACK:
+      g_value_set_int (value, self->feedback);
+      break;
+    case PROP_VOICES:
+      g_value_set_uint (value, self->voices);
+      break;
+    case PROP_DELAY:
+      g_value_set_double (value, self->delay);
+      break;
+    case PROP_DEPTH:
+      g_value_set_double (value, self->depth);
+      break;
+    case PROP_RATE:
+      g_value_set_double (value, self->rate);
+      break;
+    case PROP_RATE_MODE:
+      g_value_set_enum (value, self->rate_mode);
+      break;
+    case PROP_SYNC_TIME:
+      g_value_set_uint (value, self->sync_time);
+      break;
+    case PROP_INTERPOLATION:
+      g_value_set_enum (value, self->interpolation);
+      break;
+      // tempo iface
+    case PROP_BPM:
+      g_value_set_ulong (value, self->beats_per_minute);
+      break;
+    case PROP_TPB:
+      g_value_set_ulong (value, self->ticks_per_beat);
+      break;
+    case PROP_STPT:
+      g_value_set_ulong (value, self->subticks_per_tick);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_chorus_finalize (GObject * object)
+{
+  GstBtChorus *self = GSTBT_CHORUS (object);
+
+  gstbt_chorus_free_delays (self);
+
+  G_OBJECT_CLASS (gstbt_chorus_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_chorus_init (GstBtChorus * self)
+{
+  guint v;
+
+  self->drywet = 50;
+  self->feedback = 0;
+  self->voices = 3;
+  self->delay = 20.0;
+  self->depth = 3.0;
+  self->rate = 0.5;
+  self->rate_mode = GSTBT_CHORUS_RATE_MODE_HZ;
+  self->sync_time = 16;
+  self->interpolation = GSTBT_DELAY_INTERPOLATION_LINEAR;
+
+  self->samplerate = GST_AUDIO_DEF_RATE;
+  gstbt_smoother_init (&self->drywet_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->drywet / 100.0);
+  gstbt_smoother_init (&self->feedback_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->feedback / 100.0);
+  for (v = 0; v < GSTBT_CHORUS_MAX_VOICES; v++) {
+    gstbt_smoother_init (&self->voice_gains[v], GSTBT_SMOOTHER_LINEAR,
+        (guint) (self->samplerate * LEVEL_SMOOTHING),
+        (v < self->voices) ? 1.0 / self->voices : 0.0);
+  }
+  self->beats_per_minute = 120;
+  self->ticks_per_beat = 4;
+  self->subticks_per_tick = 1;
+  gstbt_chorus_calculate_tick_time (self);
+  gstbt_chorus_update_rate (self);
+  gst_audio_info_init (&self->info);
+
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
+}
+
+static void
+gstbt_chorus_class_init (GstBtChorusClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+
+  gobject_class->set_property = gstbt_chorus_set_property;
+  gobject_class->get_property = gstbt_chorus_get_property;
+  gobject_class->finalize = gstbt_chorus_finalize;
+
+  // override interface properties
+  g_object_class_override_property (gobject_class, PROP_BPM,
+      "beats-per-minute");
+  g_object_class_override_property (gobject_class, PROP_TPB, "ticks-per-beat");
+  g_object_class_override_property (gobject_class, PROP_STPT,
+      "subticks-per-tick");
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_DRYWET,
+      g_param_spec_uint ("drywet", "Dry-Wet",
+          "Intensity of effect (0 none -> 100 full)", 0, 100, 50,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FEEDBACK,
+      g_param_spec_int ("feedback", "Feedback",
+          "Feedback of the voices in percent, negative values invert it",
+          -99, 99, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOICES,
+      g_param_spec_uint ("voices", "Voices", "Number of delayed voices",
+          1, GSTBT_CHORUS_MAX_VOICES, 3,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DELAY,
+      g_param_spec_double ("delay", "Delay",
+          "Average delay of the voices in ms", 0.5, MAX_DELAY, 20.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DEPTH,
+      g_param_spec_double ("depth", "Depth",
+          "Modulation of the delay in ms", 0.0, MAX_DEPTH, 3.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RATE,
+      g_param_spec_double ("rate", "Rate", "Modulation rate in Hz",
+          0.01, 10.0, 0.5,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RATE_MODE,
+      g_param_spec_enum ("rate-mode", "Rate mode",
+          "Use the modulation rate or sync the modulation to the tempo",
+          GSTBT_TYPE_CHORUS_RATE_MODE, GSTBT_CHORUS_RATE_MODE_HZ,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SYNC_TIME,
+      g_param_spec_uint ("sync-time", "Sync time",
+          "Period of the modulation in ticks or beats", 1, MAX_SYNC_TIME, 16,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation mode for reading the modulated delays",
+          GSTBT_TYPE_DELAY_INTERPOLATION, GSTBT_DELAY_INTERPOLATION_LINEAR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstbasetransform_class->set_caps = GST_DEBUG_FUNCPTR (gstbt_chorus_set_caps);
+  gstbasetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gstbt_chorus_transform_ip);
+  gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gstbt_chorus_stop);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Chorus",
+      "Filter/Effect/Audio",
+      "Chorus and flanger with modulated delay lines",
+      "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtChorus.html");
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "chorus",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "chorus and flanger");
+
+  return gst_element_register (plugin, "chorus", GST_RANK_NONE,
+      GSTBT_TYPE_CHORUS);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    chorus,
+    "Chorus and flanger",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
@@ -0,0 +1,113 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * chorus.h: chorus and flanger effect
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_CHORUS_H__
+#define __GSTBT_CHORUS_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+#include <libgstbuzztrax/delay.h>
+#include <libgstbuzztrax/smoother.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_CHORUS_RATE_MODE (gstbt_chorus_rate_mode_get_type())
+
+/**
+ * GstBtChorusRateMode:
+ * @GSTBT_CHORUS_RATE_MODE_HZ: use #GstBtChorus:rate
+ * @GSTBT_CHORUS_RATE_MODE_TICKS: #GstBtChorus:sync-time is the period of the
+ *   modulation in ticks
+ * @GSTBT_CHORUS_RATE_MODE_BEATS: #GstBtChorus:sync-time is the period of the
+ *   modulation in beats
+ *
+ * How the modulation rate is specified.
+ */
+typedef enum
+{
+  GSTBT_CHORUS_RATE_MODE_HZ,
+  GSTBT_CHORUS_RATE_MODE_TICKS,
+  GSTBT_CHORUS_RATE_MODE_BEATS
+} GstBtChorusRateMode;
+
+GType gstbt_chorus_rate_mode_get_type (void);
+
+#define GSTBT_TYPE_CHORUS            (gstbt_chorus_get_type())
+#define GSTBT_CHORUS(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_CHORUS,GstBtChorus))
+#define GSTBT_IS_CHORUS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_CHORUS))
+#define GSTBT_CHORUS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_CHORUS,GstBtChorusClass))
+#define GSTBT_IS_CHORUS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_CHORUS))
+#define GSTBT_CHORUS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_CHORUS,GstBtChorusClass))
+
+#define GSTBT_CHORUS_MAX_VOICES 8
+
+typedef struct _GstBtChorus      GstBtChorus;
+typedef struct _GstBtChorusClass GstBtChorusClass;
+
+/**
+ * GstBtChorus:
+ *
+ * Class instance data.
+ */
+struct _GstBtChorus {
+  GstBaseTransform parent;
+
+  /* < private > */
+  /* properties */
+  guint drywet;
+  gint feedback;
+  guint voices;
+  gdouble delay, depth, rate;
+  GstBtChorusRateMode rate_mode;
+  guint sync_time;
+  GstBtDelayInterpolation interpolation;
+  GstBtSmoother drywet_smoother, feedback_smoother;
+  /* gain per voice, 1/voices for the active ones and 0 for the others */
+  GstBtSmoother voice_gains[GSTBT_CHORUS_MAX_VOICES];
+
+  GstAudioInfo info;
+  gint samplerate;
+  guint channels;
+  GstBtDelay **delays;          /* one delay line per channel */
+  /* modulated delay in samples at the end of the last block per channel and
+   * voice */
+  gfloat *last_delays;
+  gfloat *ap_states;            /* allpass interpolator per channel and voice */
+  gdouble *gains;               /* voice gains for a block per voice */
+
+  /* lfo */
+  gdouble phase, phase_inc;
+
+  /* tempo handling */
+  gulong beats_per_minute;
+  gulong ticks_per_beat;
+  gulong subticks_per_tick;
+  GstClockTime ticktime;
+};
+
+struct _GstBtChorusClass {
+  GstBaseTransformClass parent_class;
+};
+
+GType gstbt_chorus_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GSTBT_CHORUS_H__ */
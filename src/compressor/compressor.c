@@ -0,0 +1,648 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * compressor.c: lookahead compressor and limiter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:compressor
+ * @title: GstBtCompressor
+ * @short_description: lookahead compressor and limiter
+ *
+ * <refsect2>
+ * Reduces the dynamic range of the signal. The peak level of all channels is
+ * compared to the #GstBtCompressor:threshold and the level above it is
+ * reduced by the #GstBtCompressor:ratio, with a soft transition of
+ * #GstBtCompressor:knee dB. The gain reduction follows the level with the
+ * #GstBtCompressor:attack and #GstBtCompressor:release times and is applied
+ * to all channels alike, so that the stereo image is kept. A ratio of 100
+ * turns the element into a limiter.
+ *
+ * The audio is delayed by #GstBtCompressor:lookahead, while the level is
+ * measured on the undelayed signal. Thus the gain is already reduced when a
+ * transient arrives. The delay is reported in the latency query.
+ *
+ * The level can be taken from a sidechain instead. The last
+ * #GstBtCompressor:sidechain-channels channels of the stream are then only
+ * used as the key signal and passed through unchanged. Use
+ * <code>audiointerleave</code> to append the key signal to the stream.
+ * Samples are processed as floats internally, S16 is only scaled for the
+ * level measurement.
+ * <title>Example launch line</title>
+ * <para>
+ * <programlisting>
+ * gst-launch-1.0 filesrc location="melo1.ogg" ! decodebin ! audioconvert ! compressor threshold=-20 ratio=4 makeup-gain=6 ! autoaudiosink
+ * gst-launch-1.0 filesrc location="melo1.ogg" ! decodebin ! audioconvert ! compressor threshold=-1 ratio=100 attack=0.1 lookahead=5 ! autoaudiosink
+ * </programlisting>
+ * The latter example limits the output to -1 dB.
+ * </para>
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include <libgstbuzztrax/denormal.h>
+
+#include "compressor.h"
+
+#define GST_CAT_DEFAULT compressor_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define BLOCK_SIZE 256
+/* level changes are spread over this time (in seconds) */
+#define LEVEL_SMOOTHING 0.01
+/* maximum for the lookahead property in ms */
+#define MAX_LOOKAHEAD 20.0
+/* maximum for the sidechain-channels property */
+#define MAX_SIDECHAIN_CHANNELS 8
+/* lowest level the detector distinguishes, -120 dB */
+#define MIN_LEVEL 1.0e-6f
+#define DB_TO_LOG (G_LN10 / 20.0)
+
+enum
+{
+  // static class properties
+  PROP_LOOKAHEAD = 1,
+  PROP_SIDECHAIN_CHANNELS,
+  // dynamic class properties
+  PROP_THRESHOLD,
+  PROP_RATIO,
+  PROP_KNEE,
+  PROP_ATTACK,
+  PROP_RELEASE,
+  PROP_MAKEUP_GAIN
+};
+
+#define COMPRESSOR_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (COMPRESSOR_CAPS)
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (COMPRESSOR_CAPS)
+    );
+
+//-- the class
+
+G_DEFINE_TYPE (GstBtCompressor, gstbt_compressor, GST_TYPE_BASE_TRANSFORM);
+
+//-- private methods
+
+static void
+gstbt_compressor_update_envelope (GstBtCompressor * self)
+{
+  gdouble ms = self->samplerate / 1000.0;
+
+  self->attack_coeff = (gfloat) exp (-1.0 / (self->attack * ms));
+  self->release_coeff = (gfloat) exp (-1.0 / (self->release * ms));
+}
+
+static GstClockTime
+gstbt_compressor_get_latency (GstBtCompressor * self)
+{
+  return gst_util_uint64_scale_int (self->lookahead_samples, GST_SECOND,
+      self->samplerate);
+}
+
+static void
+gstbt_compressor_update_lookahead (GstBtCompressor * self)
+{
+  guint c, lookahead_samples;
+
+  lookahead_samples = (guint) (self->lookahead * self->samplerate / 1000.0 +
+      0.5);
+  if (lookahead_samples == self->lookahead_samples)
+    return;
+
+  self->lookahead_samples = lookahead_samples;
+  GST_DEBUG_OBJECT (self, "lookahead is %u samples", lookahead_samples);
+  /* without lookahead the delays are bypassed, but still kept up to date */
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_set_delay (self->delays[c], MAX (lookahead_samples, 1));
+  }
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_latency (GST_OBJECT (self)));
+}
+
+static void
+gstbt_compressor_free_delays (GstBtCompressor * self)
+{
+  guint c;
+
+  if (self->delays) {
+    for (c = 0; c < self->channels; c++) {
+      g_object_unref (self->delays[c]);
+    }
+    g_free (self->delays);
+    self->delays = NULL;
+  }
+  g_free (self->buf);
+  self->buf = NULL;
+  self->channels = 0;
+}
+
+static void
+gstbt_compressor_flush (GstBtCompressor * self)
+{
+  guint c;
+
+  for (c = 0; c < self->channels; c++) {
+    gstbt_delay_flush (self->delays[c]);
+  }
+  self->env = 0.0;
+  gstbt_smoother_reset (&self->makeup_smoother,
+      exp (self->makeup_gain * DB_TO_LOG));
+}
+
+/* Calculate the gain for each sample from the peak level in @level. */
+static void
+gstbt_compressor_compute_gain (GstBtCompressor * self, guint n,
+    const gfloat * level, gfloat * gain)
+{
+  const gfloat threshold = (gfloat) self->threshold;
+  const gfloat slope = (gfloat) (1.0 / self->ratio - 1.0);
+  const gfloat half_knee = (gfloat) (MAX (self->knee, 0.001) / 2.0);
+  const gfloat knee_scale = 1.0f / (4.0f * half_knee);
+  const gfloat attack_coeff = self->attack_coeff;
+  const gfloat release_coeff = self->release_coeff;
+  gdouble makeup[BLOCK_SIZE];
+  gfloat over, k, env = self->env;
+  guint i;
+
+  /* static curve: level over the threshold in dB to gain reduction in dB,
+   * the knee is a quadratic segment from -half_knee to +half_knee */
+  for (i = 0; i < n; i++) {
+    over = 20.0f * log10f (MAX (level[i], MIN_LEVEL)) - threshold;
+    k = CLAMP (over + half_knee, 0.0f, 2.0f * half_knee);
+    gain[i] = slope * ((over > half_knee) ? over : k * k * knee_scale);
+  }
+  /* envelope: the reduction follows with the attack time and recovers with
+   * the release time */
+  for (i = 0; i < n; i++) {
+    if (gain[i] < env)
+      env = gain[i] + attack_coeff * (env - gain[i]);
+    else
+      env = gain[i] + release_coeff * (env - gain[i]);
+    gain[i] = env;
+  }
+  self->env = env;
+
+  gstbt_smoother_get_block (&self->makeup_smoother, n, makeup);
+  for (i = 0; i < n; i++) {
+    gain[i] = expf (gain[i] * (gfloat) DB_TO_LOG) * (gfloat) makeup[i];
+  }
+}
+
+/* Process @num_frames interleaved frames in place. If @silent is %TRUE, the
+ * input is ignored and only the lookahead is rendered.
+ * Returns %TRUE if the output is not silent.
+ */
+static gboolean
+gstbt_compressor_process (GstBtCompressor * self, gpointer data,
+    guint num_frames, gboolean silent)
+{
+  const guint channels = self->channels;
+  const guint key_channels = MIN (self->sidechain_channels, channels - 1);
+  const guint audio_channels = channels - key_channels;
+  const guint first_key = key_channels ? audio_channels : 0;
+  const gboolean is_float =
+      (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32);
+  const gfloat scale = is_float ? 1.0f : 1.0f / 32768.0f;
+  gint16 *d16 = (gint16 *) data;
+  gfloat *d32 = (gfloat *) data;
+  gfloat level[BLOCK_SIZE], gain[BLOCK_SIZE], out[BLOCK_SIZE];
+  GstBtDelay *delay;
+  gfloat *buf;
+  guint c, i, s, n, max_block;
+  gboolean audible = FALSE;
+
+  /* the delayed block is read before the block is written, thus a block must
+   * not be longer than the delay, neither the current nor the previous one
+   * while crossfading or a pending new one */
+  if (self->lookahead_samples) {
+    delay = self->delays[0];
+    max_block = MIN (MIN (delay->delay, delay->read_delay), delay->old_delay);
+    max_block = CLAMP (max_block, 1, BLOCK_SIZE);
+  } else {
+    max_block = BLOCK_SIZE;
+  }
+
+  while (num_frames) {
+    n = MIN (num_frames, max_block);
+
+    /* deinterleave */
+    for (c = 0; c < channels; c++) {
+      buf = &self->buf[c * BLOCK_SIZE];
+      if (silent) {
+        memset (buf, 0, n * sizeof (gfloat));
+      } else if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          buf[i] = d32[s];
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          buf[i] = (gfloat) d16[s];
+        }
+      }
+    }
+
+    /* peak detector over the key channels */
+    memset (level, 0, n * sizeof (gfloat));
+    for (c = first_key; c < channels; c++) {
+      buf = &self->buf[c * BLOCK_SIZE];
+      for (i = 0; i < n; i++) {
+        level[i] = MAX (level[i], fabsf (buf[i]));
+      }
+    }
+    for (i = 0; i < n; i++) {
+      level[i] *= scale;
+    }
+    gstbt_compressor_compute_gain (self, n, level, gain);
+
+    for (c = 0; c < audio_channels; c++) {
+      delay = self->delays[c];
+      buf = &self->buf[c * BLOCK_SIZE];
+      if (self->lookahead_samples) {
+        gstbt_delay_read_block (delay, n, out);
+        gstbt_delay_write_block (delay, n, buf);
+      } else {
+        gstbt_delay_write_block (delay, n, buf);
+        memcpy (out, buf, n * sizeof (gfloat));
+      }
+      for (i = 0; i < n; i++) {
+        out[i] *= gain[i];
+      }
+      /* interleave */
+      if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d32[s] = out[i];
+          audible |= (out[i] != 0.0);
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d16[s] = (gint16) CLAMP (out[i], G_MININT16, G_MAXINT16);
+          audible |= (d16[s] != 0);
+        }
+      }
+    }
+    d16 += n * channels;
+    d32 += n * channels;
+    num_frames -= n;
+  }
+  return audible;
+}
+
+//-- basetransform vmethods
+
+static gboolean
+gstbt_compressor_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (base);
+  guint c, max_delay;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  self->samplerate = GST_AUDIO_INFO_RATE (&self->info);
+  gstbt_smoother_set_length (&self->makeup_smoother,
+      (guint) (self->samplerate * LEVEL_SMOOTHING));
+  gstbt_compressor_update_envelope (self);
+
+  /* one delay line per channel, allocated for the longest lookahead */
+  gstbt_compressor_free_delays (self);
+  self->channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  max_delay = (guint) ceil (MAX_LOOKAHEAD * self->samplerate / 1000.0);
+  self->delays = g_new (GstBtDelay *, self->channels);
+  for (c = 0; c < self->channels; c++) {
+    self->delays[c] = gstbt_delay_new ();
+    gstbt_delay_start (self->delays[c], self->samplerate, max_delay);
+  }
+  self->buf = g_new0 (gfloat, self->channels * BLOCK_SIZE);
+  self->lookahead_samples = G_MAXUINT;
+  gstbt_compressor_update_lookahead (self);
+  gstbt_compressor_flush (self);
+  return TRUE;
+}
+
+static GstFlowReturn
+gstbt_compressor_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (base);
+  GstMapInfo info;
+  GstClockTime timestamp;
+  gboolean silent, audible;
+  guint num_frames;
+  guint fpu_state;
+
+  if (G_UNLIKELY (!self->delays))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
+  }
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
+
+  /* flush ring_buffer on DISCONT */
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
+    gstbt_compressor_flush (self);
+  }
+
+  timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    gst_object_sync_values (GST_OBJECT (self), timestamp);
+
+  /* input is silence */
+  silent = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
+      gst_base_transform_is_passthrough (base);
+
+  fpu_state = gstbt_denormal_enter ();
+  audible = gstbt_compressor_process (self, info.data, num_frames, silent);
+  gstbt_denormal_leave (fpu_state);
+
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && audible) {
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+  }
+
+  gst_buffer_unmap (outbuf, &info);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gstbt_compressor_query (GstBaseTransform * base, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (base);
+  gboolean res;
+
+  res = GST_BASE_TRANSFORM_CLASS (gstbt_compressor_parent_class)->query (base,
+      direction, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_LATENCY &&
+      direction == GST_PAD_SRC) {
+    GstClockTime min, max, latency = gstbt_compressor_get_latency (self);
+    gboolean live;
+
+    gst_query_parse_latency (query, &live, &min, &max);
+    GST_DEBUG_OBJECT (self, "adding latency %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (latency));
+    min += latency;
+    if (GST_CLOCK_TIME_IS_VALID (max))
+      max += latency;
+    gst_query_set_latency (query, live, min, max);
+  }
+  return res;
+}
+
+static gboolean
+gstbt_compressor_stop (GstBaseTransform * base)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (base);
+
+  gstbt_compressor_free_delays (self);
+
+  return TRUE;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_compressor_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (object);
+
+  switch (prop_id) {
+    case PROP_LOOKAHEAD:
+      self->lookahead = g_value_get_double (value);
+      if (self->delays)
+        gstbt_compressor_update_lookahead (self);
+      break;
+    case PROP_SIDECHAIN_CHANNELS:
+      self->sidechain_channels = g_value_get_uint (value);
+      break;
+    case PROP_THRESHOLD:
+      self->threshold = g_value_get_double (value);
+      break;
+    case PROP_RATIO:
+      self->ratio = g_value_get_double (value);
+      break;
+    case PROP_KNEE:
+      self->knee = g_value_get_double (value);
+      break;
+    case PROP_ATTACK:
+      self->attack = g_value_get_double (value);
+      gstbt_compressor_update_envelope (self);
+      break;
+    case PROP_RELEASE:
+      self->release = g_value_get_double (value);
+      gstbt_compressor_update_envelope (self);
+      break;
+    case PROP_MAKEUP_GAIN:
+      self->makeup_gain = g_value_get_double (value);
+      gstbt_smoother_set_target (&self->makeup_smoother,
+          exp (self->makeup_gain * DB_TO_LOG));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_compressor_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (object);
+
+  switch (prop_id) {
+    case PROP_LOOKAHEAD:
+      g_value_set_double (value, self->lookahead);
+      break;
+    case PROP_SIDECHAIN_CHANNELS:
+      g_value_set_uint (value, self->sidechain_channels);
+      break;
+    case PROP_THRESHOLD:
+      g_value_set_double (value, self->threshold);
+      break;
+    case PROP_RATIO:
+      g_value_set_double (value, self->ratio);
+      break;
+    case PROP_KNEE:
+      g_value_set_double (value, self->knee);
+      break;
+    case PROP_ATTACK:
+      g_value_set_double (value, self->attack);
+      break;
+    case PROP_RELEASE:
+      g_value_set_double (value, self->release);
+      break;
+    case PROP_MAKEUP_GAIN:
+      g_value_set_double (value, self->makeup_gain);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_compressor_finalize (GObject * object)
+{
+  GstBtCompressor *self = GSTBT_COMPRESSOR (object);
+
+  gstbt_compressor_free_delays (self);
+
+  G_OBJECT_CLASS (gstbt_compressor_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_compressor_init (GstBtCompressor * self)
+{
+  self->threshold = -12.0;
+  self->ratio = 4.0;
+  self->knee = 6.0;
+  self->attack = 5.0;
+  self->release = 100.0;
+  self->makeup_gain = 0.0;
+  self->lookahead = 5.0;
+
+  self->samplerate = GST_AUDIO_DEF_RATE;
+  gstbt_smoother_init (&self->makeup_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), 1.0);
+  gstbt_compressor_update_envelope (self);
+  gst_audio_info_init (&self->info);
+
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
+}
+
+static void
+gstbt_compressor_class_init (GstBtCompressorClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+
+  gobject_class->set_property = gstbt_compressor_set_property;
+  gobject_class->get_property = gstbt_compressor_get_property;
+  gobject_class->finalize = gstbt_compressor_finalize;
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_LOOKAHEAD,
+      g_param_spec_double ("lookahead", "Lookahead",
+          "Delay of the audio against the level detection in ms",
+          0.0, MAX_LOOKAHEAD, 5.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SIDECHAIN_CHANNELS,
+      g_param_spec_uint ("sidechain-channels", "Sidechain channels",
+          "Number of trailing channels that are only used as the key signal",
+          0, MAX_SIDECHAIN_CHANNELS, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_THRESHOLD,
+      g_param_spec_double ("threshold", "Threshold",
+          "Level in dB above which the gain is reduced", -60.0, 0.0, -12.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RATIO,
+      g_param_spec_double ("ratio", "Ratio",
+          "Compression ratio above the threshold, 100 for limiting",
+          1.0, 100.0, 4.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_KNEE,
+      g_param_spec_double ("knee", "Knee",
+          "Width of the soft transition around the threshold in dB",
+          0.0, 24.0, 6.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ATTACK,
+      g_param_spec_double ("attack", "Attack",
+          "Time for reducing the gain in ms", 0.1, 500.0, 5.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RELEASE,
+      g_param_spec_double ("release", "Release",
+          "Time for restoring the gain in ms", 1.0, 5000.0, 100.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAKEUP_GAIN,
+      g_param_spec_double ("makeup-gain", "Makeup gain",
+          "Gain in dB applied after the compression", 0.0, 40.0, 0.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  gstbasetransform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gstbt_compressor_set_caps);
+  gstbasetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gstbt_compressor_transform_ip);
+  gstbasetransform_class->query = GST_DEBUG_FUNCPTR (gstbt_compressor_query);
+  gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gstbt_compressor_stop);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Compressor",
+      "Filter/Effect/Audio",
+      "Lookahead compressor and limiter", "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtCompressor.html");
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "compressor",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "compressor and limiter");
+
+  return gst_element_register (plugin, "compressor", GST_RANK_NONE,
+      GSTBT_TYPE_COMPRESSOR);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    compressor,
+    "Compressor and limiter",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
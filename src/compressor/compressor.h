@@ -0,0 +1,78 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * compressor.h: lookahead compressor and limiter
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_COMPRESSOR_H__
+#define __GSTBT_COMPRESSOR_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+#include <libgstbuzztrax/delay.h>
+#include <libgstbuzztrax/smoother.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_COMPRESSOR            (gstbt_compressor_get_type())
+#define GSTBT_COMPRESSOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_COMPRESSOR,GstBtCompressor))
+#define GSTBT_IS_COMPRESSOR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_COMPRESSOR))
+#define GSTBT_COMPRESSOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_COMPRESSOR,GstBtCompressorClass))
+#define GSTBT_IS_COMPRESSOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_COMPRESSOR))
+#define GSTBT_COMPRESSOR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_COMPRESSOR,GstBtCompressorClass))
+
+typedef struct _GstBtCompressor      GstBtCompressor;
+typedef struct _GstBtCompressorClass GstBtCompressorClass;
+
+/**
+ * GstBtCompressor:
+ *
+ * Class instance data.
+ */
+struct _GstBtCompressor {
+  GstBaseTransform parent;
+
+  /* < private > */
+  /* properties */
+  gdouble threshold, ratio, knee;
+  gdouble attack, release;
+  gdouble makeup_gain;
+  gdouble lookahead;
+  guint sidechain_channels;
+  GstBtSmoother makeup_smoother;
+
+  GstAudioInfo info;
+  gint samplerate;
+  guint channels;
+  GstBtDelay **delays;          /* lookahead delay line per channel */
+  guint lookahead_samples;
+  gfloat *buf;                  /* input/output of the current block per channel */
+
+  /* envelope */
+  gfloat attack_coeff, release_coeff;
+  gfloat env;                   /* gain reduction in dB, <= 0 */
+};
+
+struct _GstBtCompressorClass {
+  GstBaseTransformClass parent_class;
+};
+
+GType gstbt_compressor_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GSTBT_COMPRESSOR_H__ */
@@ -0,0 +1,1027 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * convreverb.c: partitioned convolution reverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:convreverb
+ * @title: GstBtConvReverb
+ * @short_description: partitioned convolution reverb
+ *
+ * <refsect2>
+ * Convolves the audio with an impulse response from the wave-table. The wave
+ * is selected like for #GstBtWaveReplay using the #GstBtConvReverb:wave and
+ * #GstBtConvReverb:wave-level properties. It is not resampled and should
+ * use the sampling rate of the stream. Mono and stereo impulse responses are
+ * supported.
+ *
+ * The impulse response is split into partitions that are convolved in the
+ * frequency domain (non-uniformly partitioned overlap-save). The head of the
+ * impulse response uses partitions of #GstBtConvReverb:partition-size frames,
+ * thus the latency is one partition. Only the first partition is calculated
+ * when a block is complete, the other head partitions only depend on older
+ * input and are calculated ahead of time by a pool of worker threads. The
+ * tail of the impulse response uses partitions that are 8 times larger. They
+ * are calculated by a worker thread while the next large block is collected.
+ * This allows impulse responses of several seconds at low latencies.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include <libgstbuzztrax/denormal.h>
+#include <libgstbuzztrax/propertymeta.h>
+
+#include "convreverb.h"
+
+#define GST_CAT_DEFAULT conv_reverb_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* level changes are spread over this time (in seconds) */
+#define LEVEL_SMOOTHING 0.01
+#define MIN_PARTITION_SIZE 64
+#define MAX_PARTITION_SIZE 4096
+/* number of jobs the head partitions are split into */
+#define NUM_JOBS 4
+/* size of the tail partitions in head partitions, the head covers two tail
+ * partitions, so that the tail job has a whole tail partition of time */
+#define TAIL_RATIO 8
+
+enum
+{
+  // static class properties
+  PROP_WAVE_CALLBACKS = 1,
+  PROP_PARTITION_SIZE,
+  // dynamic class properties
+  PROP_WAVE,
+  PROP_WAVE_LEVEL,
+  PROP_DRYWET
+};
+
+struct _GstBtConvReverbJob
+{
+  GstBtConvReverb *self;
+  GstBtConvReverbTail *tail;    /* the tail or NULL for head partitions */
+  guint first, last;            /* range of partitions */
+  guint base;                   /* fdl slot of the newest input block */
+  GstFFTF32Complex *acc;        /* accumulated spectrum per channel */
+};
+
+struct _GstBtConvReverbTail
+{
+  guint size, bins;             /* partition size and spectrum size */
+  GstFFTF32 *fft, *ifft;
+  guint num_parts;
+  GstFFTF32Complex *ir;         /* spectra of the ir partitions per channel */
+  GstFFTF32Complex *fdl;        /* spectra of the past input blocks per channel */
+  guint fdl_pos;                /* slot of the newest input block */
+  gfloat *in;                   /* previous and current input block per channel */
+  gfloat *next;                 /* input block being collected per channel */
+  gfloat *out;                  /* two output blocks per channel */
+  gfloat *time;
+  GstFFTF32Complex *spec;
+  guint cur;                    /* output block being played */
+  guint pos;                    /* head blocks collected in next */
+  GstBtConvReverbJob job;
+};
+
+#define CONV_REVERB_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CONV_REVERB_CAPS)
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CONV_REVERB_CAPS)
+    );
+
+//-- the class
+
+G_DEFINE_TYPE (GstBtConvReverb, gstbt_conv_reverb, GST_TYPE_BASE_TRANSFORM);
+
+//-- private methods
+
+/* acc += x * h */
+static inline void
+gstbt_conv_reverb_cmac (GstFFTF32Complex * acc, const GstFFTF32Complex * x,
+    const GstFFTF32Complex * h, guint n)
+{
+  guint k;
+
+  for (k = 0; k < n; k++) {
+    acc[k].r += x[k].r * h[k].r - x[k].i * h[k].i;
+    acc[k].i += x[k].r * h[k].i + x[k].i * h[k].r;
+  }
+}
+
+/* sum up the head partitions of a job for the next block */
+static void
+gstbt_conv_reverb_run_head (GstBtConvReverb * self, GstBtConvReverbJob * job)
+{
+  const guint bins = self->num_bins, num_parts = self->num_parts;
+  GstFFTF32Complex *acc;
+  guint c, p, slot, ir_c;
+
+  for (c = 0; c < self->channels; c++) {
+    acc = &job->acc[c * bins];
+    ir_c = c % self->ir_channels;
+    memset (acc, 0, bins * sizeof (GstFFTF32Complex));
+    for (p = job->first; p < job->last; p++) {
+      /* partition p is applied to the input block p blocks ago, the job is
+       * run for the next block, thus the newest block is partition 1 */
+      slot = (job->base + num_parts + 1 - p) % num_parts;
+      gstbt_conv_reverb_cmac (acc, &self->fdl[(c * num_parts + slot) * bins],
+          &self->ir[(ir_c * num_parts + p) * bins], bins);
+    }
+  }
+}
+
+/* convolve the complete tail input block into the output block that is not
+ * played */
+static void
+gstbt_conv_reverb_run_tail (GstBtConvReverb * self, GstBtConvReverbTail * tail)
+{
+  const guint size = tail->size, bins = tail->bins;
+  const guint num_parts = tail->num_parts;
+  const gfloat scale = 1.0 / (2 * size);
+  GstFFTF32Complex *spec = tail->spec;
+  gfloat *out;
+  guint c, i, p, slot, ir_c;
+
+  tail->fdl_pos = (tail->fdl_pos + 1) % num_parts;
+  for (c = 0; c < self->channels; c++) {
+    ir_c = c % self->ir_channels;
+    gst_fft_f32_fft (tail->fft, &tail->in[c * 2 * size],
+        &tail->fdl[(c * num_parts + tail->fdl_pos) * bins]);
+    memset (spec, 0, bins * sizeof (GstFFTF32Complex));
+    for (p = 0; p < num_parts; p++) {
+      slot = (tail->fdl_pos + num_parts - p) % num_parts;
+      gstbt_conv_reverb_cmac (spec, &tail->fdl[(c * num_parts + slot) * bins],
+          &tail->ir[(ir_c * num_parts + p) * bins], bins);
+    }
+    gst_fft_f32_inverse_fft (tail->ifft, spec, tail->time);
+    out = &tail->out[(2 * c + 1 - tail->cur) * size];
+    for (i = 0; i < size; i++) {
+      out[i] = scale * tail->time[size + i];
+    }
+  }
+}
+
+static void
+gstbt_conv_reverb_job_run (gpointer data, gpointer user_data)
+{
+  GstBtConvReverbJob *job = (GstBtConvReverbJob *) data;
+  GstBtConvReverb *self = job->self;
+  guint fpu_state;
+
+  fpu_state = gstbt_denormal_enter ();
+  if (job->tail)
+    gstbt_conv_reverb_run_tail (self, job->tail);
+  else
+    gstbt_conv_reverb_run_head (self, job);
+  gstbt_denormal_leave (fpu_state);
+
+  /* the jobs use their own lock, the element lock is held while processing */
+  g_mutex_lock (&self->jobs_lock);
+  if (job->tail)
+    self->tail_pending = FALSE;
+  else
+    self->pending--;
+  g_cond_broadcast (&self->done);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* wait for the head jobs */
+static void
+gstbt_conv_reverb_wait_jobs (GstBtConvReverb * self)
+{
+  g_mutex_lock (&self->jobs_lock);
+  while (self->pending)
+    g_cond_wait (&self->done, &self->jobs_lock);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* wait for the tail job */
+static void
+gstbt_conv_reverb_wait_tail (GstBtConvReverb * self)
+{
+  g_mutex_lock (&self->jobs_lock);
+  while (self->tail_pending)
+    g_cond_wait (&self->done, &self->jobs_lock);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* wait for all jobs, needs to be called with the lock held, so that no new
+ * jobs are started */
+static void
+gstbt_conv_reverb_wait_all (GstBtConvReverb * self)
+{
+  gstbt_conv_reverb_wait_jobs (self);
+  gstbt_conv_reverb_wait_tail (self);
+}
+
+/* needs to be called with the lock held */
+static void
+gstbt_conv_reverb_start_jobs (GstBtConvReverb * self)
+{
+  guint j;
+
+  g_mutex_lock (&self->jobs_lock);
+  self->pending = self->num_jobs;
+  g_mutex_unlock (&self->jobs_lock);
+  for (j = 0; j < self->num_jobs; j++) {
+    self->jobs[j].base = self->fdl_pos;
+    g_thread_pool_push (self->pool, &self->jobs[j], NULL);
+  }
+}
+
+/* needs to be called with the lock held */
+static void
+gstbt_conv_reverb_start_tail (GstBtConvReverb * self)
+{
+  g_mutex_lock (&self->jobs_lock);
+  self->tail_pending = TRUE;
+  g_mutex_unlock (&self->jobs_lock);
+  g_thread_pool_push (self->pool, &self->tail->job, NULL);
+}
+
+static GstBtConvReverbTail *
+gstbt_conv_reverb_new_tail (GstBtConvReverb * self, guint size,
+    guint num_parts, guint ir_channels, guint channels)
+{
+  GstBtConvReverbTail *tail = g_new0 (GstBtConvReverbTail, 1);
+
+  tail->size = size;
+  tail->bins = size + 1;
+  tail->fft = gst_fft_f32_new (2 * size, FALSE);
+  tail->ifft = gst_fft_f32_new (2 * size, TRUE);
+  tail->num_parts = num_parts;
+  tail->ir = g_new (GstFFTF32Complex, ir_channels * num_parts * tail->bins);
+  tail->fdl = g_new0 (GstFFTF32Complex, channels * num_parts * tail->bins);
+  tail->in = g_new0 (gfloat, channels * 2 * size);
+  tail->next = g_new0 (gfloat, channels * size);
+  tail->out = g_new0 (gfloat, channels * 2 * size);
+  tail->time = g_new0 (gfloat, 2 * size);
+  tail->spec = g_new0 (GstFFTF32Complex, tail->bins);
+  tail->job.self = self;
+  tail->job.tail = tail;
+  return tail;
+}
+
+static void
+gstbt_conv_reverb_free_tail (GstBtConvReverbTail * tail)
+{
+  if (!tail)
+    return;
+
+  gst_fft_f32_free (tail->fft);
+  gst_fft_f32_free (tail->ifft);
+  g_free (tail->ir);
+  g_free (tail->fdl);
+  g_free (tail->in);
+  g_free (tail->next);
+  g_free (tail->out);
+  g_free (tail->time);
+  g_free (tail->spec);
+  g_free (tail);
+}
+
+static void
+gstbt_conv_reverb_free_ir (GstBtConvReverb * self)
+{
+  guint j;
+
+  g_free (self->ir);
+  self->ir = NULL;
+  g_free (self->fdl);
+  self->fdl = NULL;
+  for (j = 0; j < self->num_jobs; j++) {
+    g_free (self->jobs[j].acc);
+  }
+  g_free (self->jobs);
+  self->jobs = NULL;
+  self->num_jobs = 0;
+  self->num_parts = 0;
+  gstbt_conv_reverb_free_tail (self->tail);
+  self->tail = NULL;
+}
+
+static void
+gstbt_conv_reverb_free_state (GstBtConvReverb * self)
+{
+  g_mutex_lock (&self->lock);
+  gstbt_conv_reverb_wait_all (self);
+  gstbt_conv_reverb_free_ir (self);
+  if (self->fft) {
+    gst_fft_f32_free (self->fft);
+    self->fft = NULL;
+  }
+  if (self->ifft) {
+    gst_fft_f32_free (self->ifft);
+    self->ifft = NULL;
+  }
+  g_free (self->in);
+  self->in = NULL;
+  g_free (self->out);
+  self->out = NULL;
+  g_free (self->time);
+  self->time = NULL;
+  g_free (self->spec);
+  self->spec = NULL;
+  g_free (self->wet);
+  self->wet = NULL;
+  self->block_size = 0;
+  g_mutex_unlock (&self->lock);
+}
+
+/* drop the past input and the results of the jobs, needs to be called with
+ * the lock held */
+static void
+gstbt_conv_reverb_flush (GstBtConvReverb * self)
+{
+  GstBtConvReverbTail *tail = self->tail;
+  const guint channels = self->channels;
+  guint j;
+
+  /* running jobs still use the old input, their results are discarded */
+  gstbt_conv_reverb_wait_all (self);
+  if (self->fdl) {
+    memset (self->fdl, 0, channels * self->num_parts * self->num_bins *
+        sizeof (GstFFTF32Complex));
+  }
+  for (j = 0; j < self->num_jobs; j++) {
+    memset (self->jobs[j].acc, 0,
+        channels * self->num_bins * sizeof (GstFFTF32Complex));
+  }
+  if (tail) {
+    memset (tail->fdl, 0, channels * tail->num_parts * tail->bins *
+        sizeof (GstFFTF32Complex));
+    memset (tail->in, 0, channels * 2 * tail->size * sizeof (gfloat));
+    memset (tail->out, 0, channels * 2 * tail->size * sizeof (gfloat));
+    tail->pos = 0;
+  }
+  memset (self->in, 0, channels * 2 * self->block_size * sizeof (gfloat));
+  memset (self->out, 0, channels * self->block_size * sizeof (gfloat));
+}
+
+/* fetch the impulse response from the wave-table, split it into partitions
+ * and transform them, this is done outside of the lock and the result is
+ * swapped in afterwards, unless the format has changed meanwhile */
+static void
+gstbt_conv_reverb_load_ir (GstBtConvReverb * self)
+{
+  gpointer *cb = self->wave_callbacks;
+  GstStructure *(*get_wave_buffer) (gpointer, guint, guint);
+  GstStructure *s;
+  GstBuffer *buffer = NULL;
+  GstMapInfo map_info;
+  GstFFTF32 *fft;
+  GstFFTF32Complex *ir, *fdl;
+  GstBtConvReverbJob *jobs;
+  GstBtConvReverbTail *tail = NULL;
+  const gchar *format;
+  gfloat *time;
+  gint16 *data;
+  gdouble energy = 0.0, scale;
+  guint block_size, bins, out_channels, tail_size, head_frames;
+  guint c, i, j, p, ir_channels, num_frames, num_parts, num_jobs, first;
+  gint channels = 0, rate;
+
+  g_mutex_lock (&self->lock);
+  block_size = self->block_size;
+  bins = self->num_bins;
+  out_channels = self->channels;
+  g_mutex_unlock (&self->lock);
+  if (!cb || !block_size)
+    return;
+  tail_size = block_size * TAIL_RATIO;
+
+  get_wave_buffer = cb[1];
+  if (!(s = get_wave_buffer (cb[0], self->wave, self->wave_level))) {
+    GST_INFO_OBJECT (self, "no wave for %u/%u", self->wave, self->wave_level);
+    goto no_ir;
+  }
+  if ((format = gst_structure_get_string (s, "format")) &&
+      strcmp (format, GST_AUDIO_NE (S16))) {
+    GST_WARNING_OBJECT (self, "unsupported ir format %s", format);
+    goto no_ir;
+  }
+  if (gst_structure_get_int (s, "rate", &rate) && rate != self->samplerate) {
+    GST_WARNING_OBJECT (self, "ir rate %d does not match the stream rate %d",
+        rate, self->samplerate);
+  }
+  gst_structure_get (s,
+      "channels", G_TYPE_INT, &channels,
+      "buffer", GST_TYPE_BUFFER, &buffer, NULL);
+  if (!buffer || channels < 1)
+    goto no_ir;
+  if (!gst_buffer_map (buffer, &map_info, GST_MAP_READ)) {
+    GST_WARNING_OBJECT (self, "unable to map buffer for read");
+    gst_buffer_unref (buffer);
+    goto no_ir;
+  }
+
+  ir_channels = (guint) channels;
+  data = (gint16 *) map_info.data;
+  num_frames = map_info.size / (ir_channels * sizeof (gint16));
+  /* the head covers two tail partitions, the rest goes to the tail */
+  head_frames = MIN (num_frames, 2 * tail_size);
+  num_parts = MAX ((head_frames + block_size - 1) / block_size, 1);
+  for (i = 0; i < num_frames * ir_channels; i++) {
+    energy += (gdouble) data[i] * (gdouble) data[i];
+  }
+  /* normalize to unit energy per channel */
+  scale = (energy > 0.0) ? sqrt (ir_channels / energy) : 0.0;
+
+  /* zero-padded partitions, the second half stays 0 */
+  fft = gst_fft_f32_new (2 * block_size, FALSE);
+  time = g_new0 (gfloat, 2 * block_size);
+  ir = g_new (GstFFTF32Complex, ir_channels * num_parts * bins);
+  for (c = 0; c < ir_channels; c++) {
+    for (p = 0; p < num_parts; p++) {
+      for (i = 0, j = p * block_size; i < block_size; i++, j++) {
+        time[i] = (j < head_frames) ?
+            (gfloat) (scale * data[j * ir_channels + c]) : 0.0;
+      }
+      gst_fft_f32_fft (fft, time, &ir[(c * num_parts + p) * bins]);
+    }
+  }
+  g_free (time);
+  gst_fft_f32_free (fft);
+
+  if (num_frames > head_frames) {
+    tail = gstbt_conv_reverb_new_tail (self, tail_size,
+        (num_frames - head_frames + tail_size - 1) / tail_size, ir_channels,
+        out_channels);
+    for (c = 0; c < ir_channels; c++) {
+      for (p = 0; p < tail->num_parts; p++) {
+        for (i = 0, j = head_frames + p * tail_size; i < tail_size; i++, j++) {
+          tail->time[i] = (j < num_frames) ?
+              (gfloat) (scale * data[j * ir_channels + c]) : 0.0;
+        }
+        gst_fft_f32_fft (tail->fft, tail->time,
+            &tail->ir[(c * tail->num_parts + p) * tail->bins]);
+      }
+    }
+  }
+  gst_buffer_unmap (buffer, &map_info);
+  gst_buffer_unref (buffer);
+
+  fdl = g_new0 (GstFFTF32Complex, out_channels * num_parts * bins);
+  /* split the head partitions (1 ... num_parts-1) into jobs */
+  num_jobs = MIN (NUM_JOBS, num_parts - 1);
+  jobs = g_new0 (GstBtConvReverbJob, num_jobs);
+  for (j = 0, first = 1; j < num_jobs; j++) {
+    jobs[j].self = self;
+    jobs[j].first = first;
+    jobs[j].last = first = 1 + ((num_parts - 1) * (j + 1)) / num_jobs;
+    jobs[j].acc = g_new0 (GstFFTF32Complex, out_channels * bins);
+  }
+  GST_INFO_OBJECT (self, "loaded ir with %u channels, %u frames, %u + %u "
+      "partitions", ir_channels, num_frames, num_parts,
+      tail ? tail->num_parts : 0);
+
+  g_mutex_lock (&self->lock);
+  if (block_size != self->block_size || bins != self->num_bins ||
+      out_channels != self->channels) {
+    /* the caps have changed meanwhile and the ir has been loaded again */
+    g_mutex_unlock (&self->lock);
+    GST_INFO_OBJECT (self, "format changed, discarding the ir");
+    g_free (ir);
+    g_free (fdl);
+    for (j = 0; j < num_jobs; j++) {
+      g_free (jobs[j].acc);
+    }
+    g_free (jobs);
+    gstbt_conv_reverb_free_tail (tail);
+    return;
+  }
+  gstbt_conv_reverb_wait_all (self);
+  gstbt_conv_reverb_free_ir (self);
+  self->ir = ir;
+  self->fdl = fdl;
+  self->ir_channels = ir_channels;
+  self->num_parts = num_parts;
+  self->fdl_pos = 0;
+  self->jobs = jobs;
+  self->num_jobs = num_jobs;
+  self->tail = tail;
+  g_mutex_unlock (&self->lock);
+  return;
+no_ir:
+  g_mutex_lock (&self->lock);
+  gstbt_conv_reverb_wait_all (self);
+  gstbt_conv_reverb_free_ir (self);
+  g_mutex_unlock (&self->lock);
+}
+
+/* add the tail to the output block and collect the input block for the
+ * tail, needs to be called with the lock held */
+static void
+gstbt_conv_reverb_process_tail (GstBtConvReverb * self)
+{
+  GstBtConvReverbTail *tail = self->tail;
+  const guint block_size = self->block_size, size = tail->size;
+  const guint offset = tail->pos * block_size;
+  gfloat *in, *out, *wet;
+  guint c, i;
+
+  for (c = 0; c < self->channels; c++) {
+    out = &self->out[c * block_size];
+    wet = &tail->out[(2 * c + tail->cur) * size + offset];
+    for (i = 0; i < block_size; i++) {
+      out[i] += wet[i];
+    }
+    /* the current input block has been moved to the first half already */
+    memcpy (&tail->next[c * size + offset], &self->in[c * 2 * block_size],
+        block_size * sizeof (gfloat));
+  }
+  if (++tail->pos < TAIL_RATIO)
+    return;
+
+  /* the tail job for the previous block has had a whole block of time, its
+   * output is played next */
+  gstbt_conv_reverb_wait_tail (self);
+  tail->cur = 1 - tail->cur;
+  tail->pos = 0;
+  for (c = 0; c < self->channels; c++) {
+    in = &tail->in[c * 2 * size];
+    memcpy (in, &in[size], size * sizeof (gfloat));
+    memcpy (&in[size], &tail->next[c * size], size * sizeof (gfloat));
+  }
+  gstbt_conv_reverb_start_tail (self);
+}
+
+/* a block of input is complete, calculate the next block of output, needs to
+ * be called with the lock held */
+static void
+gstbt_conv_reverb_process_block (GstBtConvReverb * self)
+{
+  const guint block_size = self->block_size, bins = self->num_bins;
+  const guint num_parts = self->num_parts;
+  const gfloat scale = 1.0 / (2 * block_size);
+  GstFFTF32Complex *x, *spec = self->spec;
+  gfloat *in, *out;
+  guint c, i, j;
+
+  if (!self->ir) {
+    memset (self->out, 0, self->channels * block_size * sizeof (gfloat));
+    for (c = 0; c < self->channels; c++) {
+      in = &self->in[c * 2 * block_size];
+      memcpy (in, &in[block_size], block_size * sizeof (gfloat));
+    }
+    return;
+  }
+
+  self->fdl_pos = (self->fdl_pos + 1) % num_parts;
+  for (c = 0; c < self->channels; c++) {
+    in = &self->in[c * 2 * block_size];
+    x = &self->fdl[(c * num_parts + self->fdl_pos) * bins];
+    gst_fft_f32_fft (self->fft, in, x);
+    /* overlap-save: the current block becomes the previous one */
+    memcpy (in, &in[block_size], block_size * sizeof (gfloat));
+  }
+
+  /* the other head partitions have been started after the previous block */
+  gstbt_conv_reverb_wait_jobs (self);
+
+  for (c = 0; c < self->channels; c++) {
+    out = &self->out[c * block_size];
+    x = &self->fdl[(c * num_parts + self->fdl_pos) * bins];
+    memset (spec, 0, bins * sizeof (GstFFTF32Complex));
+    gstbt_conv_reverb_cmac (spec, x,
+        &self->ir[((c % self->ir_channels) * num_parts) * bins], bins);
+    for (j = 0; j < self->num_jobs; j++) {
+      x = &self->jobs[j].acc[c * bins];
+      for (i = 0; i < bins; i++) {
+        spec[i].r += x[i].r;
+        spec[i].i += x[i].i;
+      }
+    }
+    gst_fft_f32_inverse_fft (self->ifft, spec, self->time);
+    /* overlap-save: the first half is the circular convolution garbage */
+    for (i = 0; i < block_size; i++) {
+      out[i] = scale * self->time[block_size + i];
+    }
+  }
+
+  gstbt_conv_reverb_start_jobs (self);
+
+  if (self->tail)
+    gstbt_conv_reverb_process_tail (self);
+}
+
+/* Process @num_frames interleaved frames in place. If @silent is %TRUE, the
+ * input is ignored and only the tail is rendered. The dry signal is delayed
+ * by one block like the convolution.
+ * Returns %TRUE if the output is not silent.
+ */
+static gboolean
+gstbt_conv_reverb_process (GstBtConvReverb * self, gpointer data,
+    guint num_frames, gboolean silent)
+{
+  const guint channels = self->channels;
+  const guint block_size = self->block_size;
+  const gboolean is_float =
+      (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32);
+  gint16 *d16 = (gint16 *) data;
+  gfloat *d32 = (gfloat *) data;
+  gdouble *wet = self->wet;
+  gfloat *in, *out, val;
+  guint c, i, s, ct, pos;
+  gboolean audible = FALSE;
+
+  while (num_frames) {
+    pos = self->pos;
+    ct = MIN (num_frames, block_size - pos);
+    gstbt_smoother_get_block (&self->drywet_smoother, ct, wet);
+
+    for (c = 0; c < channels; c++) {
+      in = &self->in[c * 2 * block_size];
+      out = &self->out[c * block_size + pos];
+      if (silent) {
+        memset (&in[block_size + pos], 0, ct * sizeof (gfloat));
+      } else if (is_float) {
+        for (i = 0, s = c; i < ct; i++, s += channels) {
+          in[block_size + pos + i] = d32[s];
+        }
+      } else {
+        for (i = 0, s = c; i < ct; i++, s += channels) {
+          in[block_size + pos + i] = (gfloat) d16[s];
+        }
+      }
+      in = &in[pos];
+      if (is_float) {
+        for (i = 0, s = c; i < ct; i++, s += channels) {
+          val = in[i] + (gfloat) wet[i] * (out[i] - in[i]);
+          d32[s] = val;
+          audible |= (val != 0.0);
+        }
+      } else {
+        for (i = 0, s = c; i < ct; i++, s += channels) {
+          val = in[i] + (gfloat) wet[i] * (out[i] - in[i]);
+          d16[s] = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
+          audible |= (d16[s] != 0);
+        }
+      }
+    }
+    d16 += ct * channels;
+    d32 += ct * channels;
+    num_frames -= ct;
+
+    self->pos += ct;
+    if (self->pos == block_size) {
+      gstbt_conv_reverb_process_block (self);
+      self->pos = 0;
+    }
+  }
+  return audible;
+}
+
+static GstClockTime
+gstbt_conv_reverb_get_latency (GstBtConvReverb * self)
+{
+  guint block_size = self->block_size ? self->block_size :
+      self->partition_size;
+
+  return gst_util_uint64_scale_int (block_size, GST_SECOND, self->samplerate);
+}
+
+//-- basetransform vmethods
+
+static gboolean
+gstbt_conv_reverb_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (base);
+  guint block_size, old_block_size = self->block_size;
+  gint old_samplerate = self->samplerate;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  gstbt_conv_reverb_free_state (self);
+
+  self->samplerate = GST_AUDIO_INFO_RATE (&self->info);
+  gstbt_smoother_set_length (&self->drywet_smoother,
+      (guint) (self->samplerate * LEVEL_SMOOTHING));
+
+  g_mutex_lock (&self->lock);
+  self->channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  self->block_size = block_size = 1 << g_bit_storage (self->partition_size - 1);
+  self->num_bins = block_size + 1;
+  self->fft = gst_fft_f32_new (2 * block_size, FALSE);
+  self->ifft = gst_fft_f32_new (2 * block_size, TRUE);
+  self->in = g_new0 (gfloat, self->channels * 2 * block_size);
+  self->out = g_new0 (gfloat, self->channels * block_size);
+  self->time = g_new0 (gfloat, 2 * block_size);
+  self->spec = g_new0 (GstFFTF32Complex, self->num_bins);
+  self->wet = g_new (gdouble, block_size);
+  self->pos = 0;
+  g_mutex_unlock (&self->lock);
+
+  gstbt_conv_reverb_load_ir (self);
+
+  if (block_size != old_block_size || self->samplerate != old_samplerate) {
+    gst_element_post_message (GST_ELEMENT (self),
+        gst_message_new_latency (GST_OBJECT (self)));
+  }
+  return TRUE;
+}
+
+static GstFlowReturn
+gstbt_conv_reverb_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (base);
+  GstMapInfo info;
+  GstClockTime timestamp;
+  gboolean silent, audible;
+  guint num_frames;
+  guint fpu_state;
+
+  if (G_UNLIKELY (!self->block_size))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
+  }
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
+
+  timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    gst_object_sync_values (GST_OBJECT (self), timestamp);
+
+  /* input is silence */
+  silent = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
+      gst_base_transform_is_passthrough (base);
+
+  g_mutex_lock (&self->lock);
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
+    gstbt_conv_reverb_flush (self);
+    gstbt_smoother_reset (&self->drywet_smoother, self->drywet / 100.0);
+  }
+  fpu_state = gstbt_denormal_enter ();
+  audible = gstbt_conv_reverb_process (self, info.data, num_frames, silent);
+  gstbt_denormal_leave (fpu_state);
+  g_mutex_unlock (&self->lock);
+
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && audible) {
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+  }
+
+  gst_buffer_unmap (outbuf, &info);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gstbt_conv_reverb_query (GstBaseTransform * base, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (base);
+  gboolean res;
+
+  res = GST_BASE_TRANSFORM_CLASS (gstbt_conv_reverb_parent_class)->query (base,
+      direction, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_LATENCY &&
+      direction == GST_PAD_SRC) {
+    GstClockTime min, max, latency = gstbt_conv_reverb_get_latency (self);
+    gboolean live;
+
+    gst_query_parse_latency (query, &live, &min, &max);
+    GST_DEBUG_OBJECT (self, "adding latency %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (latency));
+    min += latency;
+    if (GST_CLOCK_TIME_IS_VALID (max))
+      max += latency;
+    gst_query_set_latency (query, live, min, max);
+  }
+  return res;
+}
+
+static gboolean
+gstbt_conv_reverb_stop (GstBaseTransform * base)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (base);
+
+  gstbt_conv_reverb_free_state (self);
+
+  return TRUE;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_conv_reverb_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (object);
+
+  switch (prop_id) {
+    case PROP_WAVE_CALLBACKS:
+      self->wave_callbacks = g_value_get_pointer (value);
+      gstbt_conv_reverb_load_ir (self);
+      break;
+    case PROP_PARTITION_SIZE:
+      self->partition_size = g_value_get_uint (value);
+      break;
+    case PROP_WAVE:
+      self->wave = g_value_get_uint (value);
+      gstbt_conv_reverb_load_ir (self);
+      break;
+    case PROP_WAVE_LEVEL:
+      self->wave_level = g_value_get_uint (value);
+      gstbt_conv_reverb_load_ir (self);
+      break;
+    case PROP_DRYWET:
+      self->drywet = g_value_get_uint (value);
+      gstbt_smoother_set_target (&self->drywet_smoother, self->drywet / 100.0);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_conv_reverb_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (object);
+
+  switch (prop_id) {
+    case PROP_WAVE_CALLBACKS:
+      g_value_set_pointer (value, self->wave_callbacks);
+      break;
+    case PROP_PARTITION_SIZE:
+      g_value_set_uint (value, self->partition_size);
+      break;
+    case PROP_WAVE:
+      g_value_set_uint (value, self->wave);
+      break;
+    case PROP_WAVE_LEVEL:
+      g_value_set_uint (value, self->wave_level);
+      break;
+    case PROP_DRYWET:
+      g_value_set_uint (value, self->drywet);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_conv_reverb_finalize (GObject * object)
+{
+  GstBtConvReverb *self = GSTBT_CONV_REVERB (object);
+
+  gstbt_conv_reverb_free_state (self);
+  g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_cond_clear (&self->done);
+  g_mutex_clear (&self->jobs_lock);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (gstbt_conv_reverb_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_conv_reverb_init (GstBtConvReverb * self)
+{
+  self->wave = 1;
+  self->drywet = 30;
+  self->partition_size = 256;
+
+  self->samplerate = GST_AUDIO_DEF_RATE;
+  gstbt_smoother_init (&self->drywet_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->drywet / 100.0);
+  gst_audio_info_init (&self->info);
+
+  g_mutex_init (&self->lock);
+  g_mutex_init (&self->jobs_lock);
+  g_cond_init (&self->done);
+  /* one more thread, so that the tail job does not hold up the head jobs */
+  self->pool = g_thread_pool_new (gstbt_conv_reverb_job_run, NULL,
+      NUM_JOBS + 1, FALSE, NULL);
+
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
+}
+
+static void
+gstbt_conv_reverb_class_init (GstBtConvReverbClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+  GParamSpec *pspec;
+
+  gobject_class->set_property = gstbt_conv_reverb_set_property;
+  gobject_class->get_property = gstbt_conv_reverb_get_property;
+  gobject_class->finalize = gstbt_conv_reverb_finalize;
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_WAVE_CALLBACKS,
+      g_param_spec_pointer ("wave-callbacks", "Wavetable Callbacks",
+          "The wave-table access callbacks",
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_SIZE,
+      g_param_spec_uint ("partition-size", "Partition size",
+          "Size of the partitions in frames, rounded up to a power of 2 and "
+          "used when the format is negotiated", MIN_PARTITION_SIZE,
+          MAX_PARTITION_SIZE, 256, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /* not controllable, loading the impulse response takes too long for the
+   * streaming thread */
+  pspec = g_param_spec_uint ("wave", "Wave", "Wave index", 1, 200, 1,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_param_spec_set_qdata (pspec, gstbt_property_meta_quark,
+      GUINT_TO_POINTER (1));
+  g_param_spec_set_qdata (pspec, gstbt_property_meta_quark_flags,
+      GUINT_TO_POINTER (GSTBT_PROPERTY_META_WAVE));
+  g_object_class_install_property (gobject_class, PROP_WAVE, pspec);
+
+  g_object_class_install_property (gobject_class, PROP_WAVE_LEVEL,
+      g_param_spec_uint ("wave-level", "Wavelevel", "Wave level index",
+          0, 100, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DRYWET,
+      g_param_spec_uint ("drywet", "Dry-Wet",
+          "Intensity of effect (0 none -> 100 full)", 0, 100, 30,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  gstbasetransform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gstbt_conv_reverb_set_caps);
+  gstbasetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gstbt_conv_reverb_transform_ip);
+  gstbasetransform_class->query = GST_DEBUG_FUNCPTR (gstbt_conv_reverb_query);
+  gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gstbt_conv_reverb_stop);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "ConvReverb",
+      "Filter/Effect/Audio",
+      "Convolution reverb using impulse responses from the wave-table",
+      "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtConvReverb.html");
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "convreverb",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "convolution reverb");
+
+  return gst_element_register (plugin, "convreverb", GST_RANK_NONE,
+      GSTBT_TYPE_CONV_REVERB);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    convreverb,
+    "Convolution reverb",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
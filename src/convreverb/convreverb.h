@@ -0,0 +1,99 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * convreverb.h: partitioned convolution reverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_CONV_REVERB_H__
+#define __GSTBT_CONV_REVERB_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+#include <gst/fft/gstfftf32.h>
+#include <libgstbuzztrax/smoother.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_CONV_REVERB            (gstbt_conv_reverb_get_type())
+#define GSTBT_CONV_REVERB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_CONV_REVERB,GstBtConvReverb))
+#define GSTBT_IS_CONV_REVERB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_CONV_REVERB))
+#define GSTBT_CONV_REVERB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_CONV_REVERB,GstBtConvReverbClass))
+#define GSTBT_IS_CONV_REVERB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_CONV_REVERB))
+#define GSTBT_CONV_REVERB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_CONV_REVERB,GstBtConvReverbClass))
+
+typedef struct _GstBtConvReverb      GstBtConvReverb;
+typedef struct _GstBtConvReverbClass GstBtConvReverbClass;
+typedef struct _GstBtConvReverbJob   GstBtConvReverbJob;
+typedef struct _GstBtConvReverbTail  GstBtConvReverbTail;
+
+/**
+ * GstBtConvReverb:
+ *
+ * Class instance data.
+ */
+struct _GstBtConvReverb {
+  GstBaseTransform parent;
+
+  /* < private > */
+  /* properties */
+  gpointer *wave_callbacks;
+  guint wave, wave_level;
+  guint drywet;
+  guint partition_size;
+  GstBtSmoother drywet_smoother;
+
+  GstAudioInfo info;
+  gint samplerate;
+  guint channels;
+
+  /* convolution state, protected by the lock */
+  GMutex lock;
+  guint block_size;             /* partition size in use, a power of 2 */
+  guint num_bins;               /* spectrum size of a partition */
+  GstFFTF32 *fft, *ifft;
+  guint ir_channels, num_parts;
+  GstFFTF32Complex *ir;         /* spectra of the ir partitions per channel */
+  GstFFTF32Complex *fdl;        /* spectra of the past input blocks per channel */
+  guint fdl_pos;                /* slot of the newest input block */
+  gfloat *in;                   /* previous and current input block per channel */
+  gfloat *out;                  /* wet output block per channel */
+  gfloat *time;
+  GstFFTF32Complex *spec;
+  gdouble *wet;                 /* dry-wet levels for a block */
+  guint pos;                    /* frame position in the current block */
+  GstBtConvReverbTail *tail;    /* larger partitions for the end of the ir */
+
+  /* the head partitions but the first one and the tail are calculated ahead
+   * of time in a thread pool */
+  GThreadPool *pool;
+  GstBtConvReverbJob *jobs;
+  guint num_jobs;
+  GMutex jobs_lock;
+  guint pending;
+  gboolean tail_pending;
+  GCond done;
+};
+
+struct _GstBtConvReverbClass {
+  GstBaseTransformClass parent_class;
+};
+
+GType gstbt_conv_reverb_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GSTBT_CONV_REVERB_H__ */
@@ -0,0 +1,463 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * eq.c: parametric equalizer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:eq
+ * @title: GstBtEq
+ * @short_description: parametric equalizer
+ *
+ * <refsect2>
+ * Equalizer made from a cascade of biquad filters. Each band is a
+ * #GstBtEqBand child with its own type, frequency, gain and q. The number of
+ * bands is set with the #GstBtChildBin:children property. Bands can also be
+ * added and removed while playing using gstbt_child_bin_add_child() and
+ * gstbt_child_bin_remove_child().
+ * <title>Example launch line</title>
+ * <para>
+ * <programlisting>
+ * gst-launch filesrc location="melo1.ogg" ! decodebin ! audioconvert ! eq children=2 band0::type=low-shelf band0::gain=6 band1::frequency=3000 band1::gain=-4 ! autoaudiosink
+ * </programlisting>
+ * </para>
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include <libgstbuzztrax/childbin.h>
+#include <libgstbuzztrax/denormal.h>
+
+#include "eq.h"
+
+#define GST_CAT_DEFAULT eq_debug
+GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
+
+/* frames per conversion block for integer formats */
+#define BLOCK_SIZE 256
+
+enum
+{
+  // static class properties
+  PROP_CHILDREN = 1
+};
+
+#define EQ_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (EQ_CAPS)
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (EQ_CAPS)
+    );
+
+//-- the class
+
+static void gstbt_eq_child_proxy_interface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gstbt_eq_child_bin_interface_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstBtEq, gstbt_eq, GST_TYPE_BASE_TRANSFORM,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY,
+        gstbt_eq_child_proxy_interface_init)
+    G_IMPLEMENT_INTERFACE (GSTBT_TYPE_CHILD_BIN,
+        gstbt_eq_child_bin_interface_init));
+
+//-- helper
+
+static void
+gstbt_eq_process_f32 (GstBtEq * self, guint n, gfloat * data)
+{
+  GList *node;
+
+  for (node = self->bands; node; node = g_list_next (node)) {
+    gstbt_eq_band_process ((GstBtEqBand *) node->data, n, data);
+  }
+}
+
+static void
+gstbt_eq_process_s16 (GstBtEq * self, guint n, gint16 * data)
+{
+  const gint channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  gfloat *scratch = self->scratch;
+  guint i, ct, ns;
+  glong val;
+
+  while (n) {
+    ct = MIN (n, BLOCK_SIZE);
+    ns = ct * channels;
+    for (i = 0; i < ns; i++) {
+      scratch[i] = (gfloat) data[i];
+    }
+    gstbt_eq_process_f32 (self, ct, scratch);
+    for (i = 0; i < ns; i++) {
+      val = (glong) scratch[i];
+      data[i] = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
+    }
+    data += ns;
+    n -= ct;
+  }
+}
+
+static GstBtEqBand *
+gstbt_eq_new_band (GstBtEq * self)
+{
+  gchar name[20];
+
+  sprintf (name, "band%u", self->band_id++);
+  return (GstBtEqBand *) g_object_new (GSTBT_TYPE_EQ_BAND, "name", name, NULL);
+}
+
+//-- basetransform vmethods
+
+static gboolean
+gstbt_eq_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtEq *self = GSTBT_EQ (base);
+  GList *node;
+  gint rate, channels;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  rate = GST_AUDIO_INFO_RATE (&self->info);
+  channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  self->scratch = g_renew (gfloat, self->scratch, BLOCK_SIZE * channels);
+
+  GST_OBJECT_LOCK (self);
+  for (node = self->bands; node; node = g_list_next (node)) {
+    gstbt_eq_band_setup ((GstBtEqBand *) node->data, rate, channels);
+  }
+  GST_OBJECT_UNLOCK (self);
+  return TRUE;
+}
+
+static GstFlowReturn
+gstbt_eq_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
+{
+  GstBtEq *self = GSTBT_EQ (base);
+  GstMapInfo info;
+  GstClockTime timestamp;
+  GList *node, *bands;
+  guint num_frames, fpu_state;
+
+  timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    gst_object_sync_values (GST_OBJECT (self), timestamp);
+    /* setting the band parameters takes the lock */
+    GST_OBJECT_LOCK (self);
+    bands = g_list_copy_deep (self->bands, (GCopyFunc) gst_object_ref, NULL);
+    GST_OBJECT_UNLOCK (self);
+    for (node = bands; node; node = g_list_next (node)) {
+      gst_object_sync_values ((GstObject *) node->data, timestamp);
+    }
+    g_list_free_full (bands, (GDestroyNotify) gst_object_unref);
+  }
+
+  if (G_UNLIKELY (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP))) {
+    /* the filter tails are short, don't render them into silence */
+    GST_OBJECT_LOCK (self);
+    for (node = self->bands; node; node = g_list_next (node)) {
+      gstbt_eq_band_reset ((GstBtEqBand *) node->data);
+    }
+    GST_OBJECT_UNLOCK (self);
+    return GST_FLOW_OK;
+  }
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
+  }
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
+
+  GST_OBJECT_LOCK (self);
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
+    for (node = self->bands; node; node = g_list_next (node)) {
+      gstbt_eq_band_reset ((GstBtEqBand *) node->data);
+    }
+  }
+  if (self->bands) {
+    fpu_state = gstbt_denormal_enter ();
+    if (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32) {
+      gstbt_eq_process_f32 (self, num_frames, (gfloat *) info.data);
+    } else {
+      gstbt_eq_process_s16 (self, num_frames, (gint16 *) info.data);
+    }
+    gstbt_denormal_leave (fpu_state);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  gst_buffer_unmap (outbuf, &info);
+
+  return GST_FLOW_OK;
+}
+
+//-- child proxy interface
+
+static GObject *
+gstbt_eq_child_proxy_get_child_by_index (GstChildProxy * child_proxy,
+    guint index)
+{
+  GstBtEq *self = GSTBT_EQ (child_proxy);
+  GObject *res = NULL;
+
+  GST_OBJECT_LOCK (self);
+  if (index < self->num_bands)
+    res = gst_object_ref (g_list_nth_data (self->bands, index));
+  GST_OBJECT_UNLOCK (self);
+  return res;
+}
+
+static guint
+gstbt_eq_child_proxy_get_children_count (GstChildProxy * child_proxy)
+{
+  GstBtEq *self = GSTBT_EQ (child_proxy);
+
+  return self->num_bands;
+}
+
+static void
+gstbt_eq_child_proxy_interface_init (gpointer g_iface, gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  GST_INFO ("initializing iface");
+
+  iface->get_child_by_index = gstbt_eq_child_proxy_get_child_by_index;
+  iface->get_children_count = gstbt_eq_child_proxy_get_children_count;
+}
+
+//-- child bin interface
+
+static gboolean
+gstbt_eq_child_bin_add_child (GstBtChildBin * child_bin, GstObject * child)
+{
+  GstBtEq *self = GSTBT_EQ (child_bin);
+  GstBtEqBand *band;
+
+  g_return_val_if_fail (GSTBT_IS_EQ_BAND (child), FALSE);
+  band = (GstBtEqBand *) child;
+
+  if (!gst_object_set_parent (child, (GstObject *) self)) {
+    GST_WARNING_OBJECT (self, "band %" GST_PTR_FORMAT " already has a parent",
+        child);
+    return FALSE;
+  }
+  if (GST_AUDIO_INFO_IS_VALID (&self->info)) {
+    gstbt_eq_band_setup (band, GST_AUDIO_INFO_RATE (&self->info),
+        GST_AUDIO_INFO_CHANNELS (&self->info));
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->bands = g_list_append (self->bands, band);
+  self->num_bands++;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_child_proxy_child_added ((GstChildProxy *) self, (GObject *) child,
+      GST_OBJECT_NAME (child));
+  g_object_notify ((GObject *) self, "children");
+  return TRUE;
+}
+
+static gboolean
+gstbt_eq_child_bin_remove_child (GstBtChildBin * child_bin, GstObject * child)
+{
+  GstBtEq *self = GSTBT_EQ (child_bin);
+  GList *node;
+
+  GST_OBJECT_LOCK (self);
+  if (!(node = g_list_find (self->bands, child))) {
+    GST_OBJECT_UNLOCK (self);
+    return FALSE;
+  }
+  self->bands = g_list_delete_link (self->bands, node);
+  self->num_bands--;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_child_proxy_child_removed ((GstChildProxy *) self, (GObject *) child,
+      GST_OBJECT_NAME (child));
+  gst_object_unparent (child);
+  g_object_notify ((GObject *) self, "children");
+  return TRUE;
+}
+
+static void
+gstbt_eq_child_bin_interface_init (gpointer g_iface, gpointer iface_data)
+{
+  GstBtChildBinInterface *iface = g_iface;
+
+  GST_INFO ("initializing iface");
+
+  iface->add_child = gstbt_eq_child_bin_add_child;
+  iface->remove_child = gstbt_eq_child_bin_remove_child;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_eq_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtEq *self = GSTBT_EQ (object);
+
+  switch (prop_id) {
+    case PROP_CHILDREN:{
+      gulong children = g_value_get_ulong (value);
+
+      while (self->num_bands < children) {
+        gstbt_child_bin_add_child ((GstBtChildBin *) self,
+            (GstObject *) gstbt_eq_new_band (self));
+      }
+      while (self->num_bands > children) {
+        gstbt_child_bin_remove_child ((GstBtChildBin *) self,
+            (GstObject *) g_list_last (self->bands)->data);
+      }
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_eq_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtEq *self = GSTBT_EQ (object);
+
+  switch (prop_id) {
+    case PROP_CHILDREN:
+      g_value_set_ulong (value, self->num_bands);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_eq_dispose (GObject * object)
+{
+  GstBtEq *self = GSTBT_EQ (object);
+  GList *node;
+
+  if (self->dispose_has_run)
+    return;
+  self->dispose_has_run = TRUE;
+
+  for (node = self->bands; node; node = g_list_next (node)) {
+    gst_object_unparent ((GstObject *) node->data);
+  }
+  g_list_free (self->bands);
+  self->bands = NULL;
+  self->num_bands = 0;
+
+  G_OBJECT_CLASS (gstbt_eq_parent_class)->dispose (object);
+}
+
+static void
+gstbt_eq_finalize (GObject * object)
+{
+  GstBtEq *self = GSTBT_EQ (object);
+
+  g_free (self->scratch);
+
+  G_OBJECT_CLASS (gstbt_eq_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_eq_init (GstBtEq * self)
+{
+  gst_audio_info_init (&self->info);
+
+  gstbt_child_bin_add_child ((GstBtChildBin *) self,
+      (GstObject *) gstbt_eq_new_band (self));
+}
+
+static void
+gstbt_eq_class_init (GstBtEqClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+
+  gobject_class->set_property = gstbt_eq_set_property;
+  gobject_class->get_property = gstbt_eq_get_property;
+  gobject_class->dispose = gstbt_eq_dispose;
+  gobject_class->finalize = gstbt_eq_finalize;
+
+  // override interface properties
+  g_object_class_override_property (gobject_class, PROP_CHILDREN, "children");
+
+  gstbasetransform_class->set_caps = GST_DEBUG_FUNCPTR (gstbt_eq_set_caps);
+  gstbasetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gstbt_eq_transform_ip);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Equalizer",
+      "Filter/Effect/Audio",
+      "Parametric equalizer with a variable number of bands",
+      "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtEq.html");
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "eq",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "parametric equalizer");
+
+  return gst_element_register (plugin, "eq", GST_RANK_NONE, GSTBT_TYPE_EQ);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    eq,
+    "Parametric equalizer",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
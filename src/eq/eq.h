@@ -0,0 +1,69 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * eq.h: parametric equalizer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_EQ_H__
+#define __GSTBT_EQ_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include "eqband.h"
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_EQ            (gstbt_eq_get_type())
+#define GSTBT_EQ(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_EQ,GstBtEq))
+#define GSTBT_IS_EQ(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_EQ))
+#define GSTBT_EQ_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_EQ,GstBtEqClass))
+#define GSTBT_IS_EQ_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_EQ))
+#define GSTBT_EQ_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_EQ,GstBtEqClass))
+
+typedef struct _GstBtEq      GstBtEq;
+typedef struct _GstBtEqClass GstBtEqClass;
+
+/**
+ * GstBtEq:
+ *
+ * Class instance data.
+ */
+struct _GstBtEq {
+  GstBaseTransform parent;
+
+  /* < private > */
+  gboolean dispose_has_run;		/* validate if dispose has run */
+
+  /* bands, protected by the object lock */
+  GList *bands;
+  guint num_bands;
+  guint band_id;
+
+  GstAudioInfo info;
+  gfloat *scratch;              /* conversion buffer for integer formats */
+};
+
+struct _GstBtEqClass {
+  GstBaseTransformClass parent_class;
+};
+
+GType gstbt_eq_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GSTBT_EQ_H__ */
@@ -0,0 +1,429 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * eqband.c: biquad equalizer band
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:eqband
+ * @title: GstBtEqBand
+ * @short_description: equalizer band
+ *
+ * A single biquad section of #GstBtEq. The coefficients follow the
+ * "Cookbook formulae for audio EQ biquad filter coefficients" by Robert
+ * Bristow-Johnson.
+ *
+ * Parameter changes are smoothed and the coefficients are only recalculated
+ * while a parameter is moving. Bands without effect (0 dB peak or shelf) are
+ * skipped.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <libgstbuzztrax/denormal.h>
+
+#include "eqband.h"
+
+#define GST_CAT_DEFAULT eq_debug
+GST_DEBUG_CATEGORY_EXTERN (GST_CAT_DEFAULT);
+
+#define M_PI_M2 ( M_PI + M_PI )
+
+/* while parameters change, coefficients are updated every COEFF_BLOCK frames */
+#define COEFF_BLOCK 32
+/* parameter changes are spread over this time (in seconds) */
+#define PARAM_SMOOTHING 0.02
+
+enum
+{
+  PROP_TYPE = 1,
+  PROP_FREQUENCY,
+  PROP_GAIN,
+  PROP_Q
+};
+
+//-- the class
+
+G_DEFINE_TYPE (GstBtEqBand, gstbt_eq_band, GST_TYPE_OBJECT);
+
+//-- enums
+
+GType
+gstbt_eq_band_type_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_EQ_BAND_PEAK, "Peak", "peak"},
+    {GSTBT_EQ_BAND_LOW_SHELF, "LowShelf", "low-shelf"},
+    {GSTBT_EQ_BAND_HIGH_SHELF, "HighShelf", "high-shelf"},
+    {GSTBT_EQ_BAND_LOW_PASS, "LowPass", "low-pass"},
+    {GSTBT_EQ_BAND_HIGH_PASS, "HighPass", "high-pass"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtEqBandType", enums);
+  }
+  return type;
+}
+
+//-- private methods
+
+static void
+gstbt_eq_band_calculate_coeffs (GstBtEqBand * self, gdouble freq,
+    gdouble gain, gdouble q)
+{
+  gdouble A, w0, cw, alpha, sa;
+  gdouble a0, a1, a2, b0, b1, b2;
+
+  /* stay below nyquist */
+  freq = MIN (freq, self->samplerate * 0.49);
+
+  A = pow (10.0, gain / 40.0);
+  w0 = M_PI_M2 * freq / self->samplerate;
+  cw = cos (w0);
+  alpha = sin (w0) / (2.0 * q);
+  sa = 2.0 * sqrt (A) * alpha;
+
+  switch (self->type) {
+    case GSTBT_EQ_BAND_PEAK:
+      b0 = 1.0 + alpha * A;
+      b1 = -2.0 * cw;
+      b2 = 1.0 - alpha * A;
+      a0 = 1.0 + alpha / A;
+      a1 = -2.0 * cw;
+      a2 = 1.0 - alpha / A;
+      break;
+    case GSTBT_EQ_BAND_LOW_SHELF:
+      b0 = A * ((A + 1.0) - (A - 1.0) * cw + sa);
+      b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+      b2 = A * ((A + 1.0) - (A - 1.0) * cw - sa);
+      a0 = (A + 1.0) + (A - 1.0) * cw + sa;
+      a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+      a2 = (A + 1.0) + (A - 1.0) * cw - sa;
+      break;
+    case GSTBT_EQ_BAND_HIGH_SHELF:
+      b0 = A * ((A + 1.0) + (A - 1.0) * cw + sa);
+      b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+      b2 = A * ((A + 1.0) + (A - 1.0) * cw - sa);
+      a0 = (A + 1.0) - (A - 1.0) * cw + sa;
+      a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+      a2 = (A + 1.0) - (A - 1.0) * cw - sa;
+      break;
+    case GSTBT_EQ_BAND_LOW_PASS:
+      b0 = (1.0 - cw) * 0.5;
+      b1 = 1.0 - cw;
+      b2 = b0;
+      a0 = 1.0 + alpha;
+      a1 = -2.0 * cw;
+      a2 = 1.0 - alpha;
+      break;
+    case GSTBT_EQ_BAND_HIGH_PASS:
+      b0 = (1.0 + cw) * 0.5;
+      b1 = -(1.0 + cw);
+      b2 = b0;
+      a0 = 1.0 + alpha;
+      a1 = -2.0 * cw;
+      a2 = 1.0 - alpha;
+      break;
+    default:
+      GST_ERROR ("invalid band-type: %d", self->type);
+      return;
+  }
+  self->b0 = b0 / a0;
+  self->b1 = b1 / a0;
+  self->b2 = b2 / a0;
+  self->a1 = a1 / a0;
+  self->a2 = a2 / a0;
+
+  /* a 0 dB peak or shelf does not change the signal */
+  if (gain == 0.0 && self->type <= GSTBT_EQ_BAND_HIGH_SHELF) {
+    if (!self->flat) {
+      self->flat = TRUE;
+      gstbt_eq_band_reset (self);
+    }
+  } else {
+    self->flat = FALSE;
+  }
+}
+
+/* the channel loop is innermost, the channels don't depend on each other and
+ * thus can be computed in parallel */
+static void
+gstbt_eq_band_filter (GstBtEqBand * self, guint n, gfloat * data)
+{
+  const gint channels = self->channels;
+  const gdouble b0 = self->b0, b1 = self->b1, b2 = self->b2;
+  const gdouble a1 = self->a1, a2 = self->a2;
+  gdouble *z1 = self->z1, *z2 = self->z2;
+  gdouble x, y;
+  guint i;
+  gint c;
+
+  if (channels == 1) {
+    gdouble s1 = z1[0], s2 = z2[0];
+
+    for (i = 0; i < n; i++) {
+      x = data[i] + GSTBT_DENORMAL_DC;
+      y = b0 * x + s1;
+      s1 = b1 * x - a1 * y + s2;
+      s2 = b2 * x - a2 * y;
+      data[i] = (gfloat) y;
+    }
+    z1[0] = s1;
+    z2[0] = s2;
+  } else if (channels == 2) {
+    gdouble s1l = z1[0], s2l = z2[0], s1r = z1[1], s2r = z2[1];
+    gdouble xr, yr;
+
+    for (i = 0; i < n; i++) {
+      x = data[(i << 1)] + GSTBT_DENORMAL_DC;
+      xr = data[(i << 1) + 1] + GSTBT_DENORMAL_DC;
+      y = b0 * x + s1l;
+      yr = b0 * xr + s1r;
+      s1l = b1 * x - a1 * y + s2l;
+      s1r = b1 * xr - a1 * yr + s2r;
+      s2l = b2 * x - a2 * y;
+      s2r = b2 * xr - a2 * yr;
+      data[(i << 1)] = (gfloat) y;
+      data[(i << 1) + 1] = (gfloat) yr;
+    }
+    z1[0] = s1l;
+    z2[0] = s2l;
+    z1[1] = s1r;
+    z2[1] = s2r;
+  } else {
+    for (i = 0; i < n; i++) {
+      for (c = 0; c < channels; c++) {
+        x = data[c] + GSTBT_DENORMAL_DC;
+        y = b0 * x + z1[c];
+        z1[c] = b1 * x - a1 * y + z2[c];
+        z2[c] = b2 * x - a2 * y;
+        data[c] = (gfloat) y;
+      }
+      data += channels;
+    }
+  }
+}
+
+//-- public methods
+
+/**
+ * gstbt_eq_band_setup:
+ * @self: the band
+ * @samplerate: the sampling rate
+ * @channels: the number of interleaved channels
+ *
+ * Prepare the band for the given audio format. This clears the filter state.
+ */
+void
+gstbt_eq_band_setup (GstBtEqBand * self, gint samplerate, gint channels)
+{
+  guint length = (guint) (samplerate * PARAM_SMOOTHING);
+
+  self->samplerate = samplerate;
+  if (self->channels != channels) {
+    self->channels = channels;
+    self->z1 = g_renew (gdouble, self->z1, channels);
+    self->z2 = g_renew (gdouble, self->z2, channels);
+  }
+  gstbt_smoother_set_length (&self->freq_smoother, length);
+  gstbt_smoother_set_length (&self->gain_smoother, length);
+  gstbt_smoother_set_length (&self->q_smoother, length);
+  gstbt_eq_band_reset (self);
+  self->dirty = TRUE;
+}
+
+/**
+ * gstbt_eq_band_reset:
+ * @self: the band
+ *
+ * Clear the filter state, e.g. after a discontinuity.
+ */
+void
+gstbt_eq_band_reset (GstBtEqBand * self)
+{
+  if (self->channels) {
+    memset (self->z1, 0, self->channels * sizeof (gdouble));
+    memset (self->z2, 0, self->channels * sizeof (gdouble));
+  }
+}
+
+/**
+ * gstbt_eq_band_process:
+ * @self: the band
+ * @n: the number of frames in @data
+ * @data: interleaved audio samples
+ *
+ * Run the filter over the audio in place.
+ */
+void
+gstbt_eq_band_process (GstBtEqBand * self, guint n, gfloat * data)
+{
+  gdouble freq[COEFF_BLOCK], gain[COEFF_BLOCK], q[COEFF_BLOCK];
+  guint ct;
+
+  if (!self->dirty && !gstbt_smoother_is_active (&self->freq_smoother) &&
+      !gstbt_smoother_is_active (&self->gain_smoother) &&
+      !gstbt_smoother_is_active (&self->q_smoother)) {
+    if (!self->flat)
+      gstbt_eq_band_filter (self, n, data);
+    return;
+  }
+
+  while (n) {
+    ct = MIN (n, COEFF_BLOCK);
+    gstbt_smoother_get_block (&self->freq_smoother, ct, freq);
+    gstbt_smoother_get_block (&self->gain_smoother, ct, gain);
+    gstbt_smoother_get_block (&self->q_smoother, ct, q);
+    /* the frequency is smoothed on a logarithmic scale */
+    gstbt_eq_band_calculate_coeffs (self, exp (freq[ct - 1]), gain[ct - 1],
+        q[ct - 1]);
+    if (!self->flat)
+      gstbt_eq_band_filter (self, ct, data);
+    data += ct * self->channels;
+    n -= ct;
+  }
+  self->dirty = FALSE;
+}
+
+//-- virtual methods
+
+static void
+gstbt_eq_band_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtEqBand *self = GSTBT_EQ_BAND (object);
+  GstObject *parent;
+
+  /* the eq processes the bands with its object lock held */
+  if ((parent = gst_object_get_parent ((GstObject *) self)))
+    GST_OBJECT_LOCK (parent);
+
+  switch (prop_id) {
+    case PROP_TYPE:
+      self->type = g_value_get_enum (value);
+      self->dirty = TRUE;
+      break;
+    case PROP_FREQUENCY:
+      self->freq = g_value_get_double (value);
+      gstbt_smoother_set_target (&self->freq_smoother, log (self->freq));
+      break;
+    case PROP_GAIN:
+      self->gain = g_value_get_double (value);
+      gstbt_smoother_set_target (&self->gain_smoother, self->gain);
+      break;
+    case PROP_Q:
+      self->q = g_value_get_double (value);
+      gstbt_smoother_set_target (&self->q_smoother, self->q);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  if (parent) {
+    GST_OBJECT_UNLOCK (parent);
+    gst_object_unref (parent);
+  }
+}
+
+static void
+gstbt_eq_band_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtEqBand *self = GSTBT_EQ_BAND (object);
+
+  switch (prop_id) {
+    case PROP_TYPE:
+      g_value_set_enum (value, self->type);
+      break;
+    case PROP_FREQUENCY:
+      g_value_set_double (value, self->freq);
+      break;
+    case PROP_GAIN:
+      g_value_set_double (value, self->gain);
+      break;
+    case PROP_Q:
+      g_value_set_double (value, self->q);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_eq_band_finalize (GObject * object)
+{
+  GstBtEqBand *self = GSTBT_EQ_BAND (object);
+
+  g_free (self->z1);
+  g_free (self->z2);
+
+  G_OBJECT_CLASS (gstbt_eq_band_parent_class)->finalize (object);
+}
+
+static void
+gstbt_eq_band_init (GstBtEqBand * self)
+{
+  self->type = GSTBT_EQ_BAND_PEAK;
+  self->freq = 1000.0;
+  self->gain = 0.0;
+  self->q = M_SQRT1_2;
+  self->flat = TRUE;
+  self->dirty = TRUE;
+  gstbt_smoother_init (&self->freq_smoother, GSTBT_SMOOTHER_LINEAR, 0,
+      log (self->freq));
+  gstbt_smoother_init (&self->gain_smoother, GSTBT_SMOOTHER_LINEAR, 0,
+      self->gain);
+  gstbt_smoother_init (&self->q_smoother, GSTBT_SMOOTHER_LINEAR, 0, self->q);
+}
+
+static void
+gstbt_eq_band_class_init (GstBtEqBandClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  const GParamFlags pflags =
+      G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS;
+
+  gobject_class->set_property = gstbt_eq_band_set_property;
+  gobject_class->get_property = gstbt_eq_band_get_property;
+  gobject_class->finalize = gstbt_eq_band_finalize;
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_TYPE,
+      g_param_spec_enum ("type", "Type", "Type of the filter",
+          GSTBT_TYPE_EQ_BAND_TYPE, GSTBT_EQ_BAND_PEAK, pflags));
+
+  g_object_class_install_property (gobject_class, PROP_FREQUENCY,
+      g_param_spec_double ("frequency", "Frequency",
+          "Center or corner frequency in Hz", 20.0, 20000.0, 1000.0, pflags));
+
+  g_object_class_install_property (gobject_class, PROP_GAIN,
+      g_param_spec_double ("gain", "Gain",
+          "Boost or cut in dB (peak and shelf filters)", -24.0, 24.0, 0.0,
+          pflags));
+
+  g_object_class_install_property (gobject_class, PROP_Q,
+      g_param_spec_double ("q", "Q", "Quality factor, higher is narrower",
+          0.1, 20.0, M_SQRT1_2, pflags));
+}
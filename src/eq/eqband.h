@@ -0,0 +1,97 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * eqband.h: biquad equalizer band
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_EQ_BAND_H__
+#define __GSTBT_EQ_BAND_H__
+
+#include <gst/gst.h>
+#include <libgstbuzztrax/smoother.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_EQ_BAND_TYPE (gstbt_eq_band_type_get_type())
+
+/**
+ * GstBtEqBandType:
+ * @GSTBT_EQ_BAND_PEAK: bell shaped boost or cut around the frequency
+ * @GSTBT_EQ_BAND_LOW_SHELF: boost or cut below the frequency
+ * @GSTBT_EQ_BAND_HIGH_SHELF: boost or cut above the frequency
+ * @GSTBT_EQ_BAND_LOW_PASS: remove frequencies above the frequency
+ * @GSTBT_EQ_BAND_HIGH_PASS: remove frequencies below the frequency
+ *
+ * Filter types of an equalizer band.
+ */
+typedef enum
+{
+  GSTBT_EQ_BAND_PEAK,
+  GSTBT_EQ_BAND_LOW_SHELF,
+  GSTBT_EQ_BAND_HIGH_SHELF,
+  GSTBT_EQ_BAND_LOW_PASS,
+  GSTBT_EQ_BAND_HIGH_PASS
+} GstBtEqBandType;
+
+GType gstbt_eq_band_type_get_type(void);
+
+#define GSTBT_TYPE_EQ_BAND            (gstbt_eq_band_get_type())
+#define GSTBT_EQ_BAND(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_EQ_BAND,GstBtEqBand))
+#define GSTBT_IS_EQ_BAND(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_EQ_BAND))
+#define GSTBT_EQ_BAND_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_EQ_BAND,GstBtEqBandClass))
+#define GSTBT_IS_EQ_BAND_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_EQ_BAND))
+#define GSTBT_EQ_BAND_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_EQ_BAND,GstBtEqBandClass))
+
+typedef struct _GstBtEqBand GstBtEqBand;
+typedef struct _GstBtEqBandClass GstBtEqBandClass;
+
+/**
+ * GstBtEqBand:
+ *
+ * Class instance data.
+ */
+struct _GstBtEqBand
+{
+  GstObject parent;
+
+  /* < private > */
+  /* parameters */
+  GstBtEqBandType type;
+  gdouble freq, gain, q;
+
+  gint samplerate, channels;
+  GstBtSmoother freq_smoother, gain_smoother, q_smoother;
+
+  /* cached coefficients, a0 is normalized to 1.0 */
+  gboolean dirty, flat;
+  gdouble b0, b1, b2, a1, a2;
+  /* filter state (transposed direct form II), one entry per channel */
+  gdouble *z1, *z2;
+};
+
+struct _GstBtEqBandClass
+{
+  GstObjectClass parent_class;
+};
+
+GType gstbt_eq_band_get_type (void);
+
+void gstbt_eq_band_setup (GstBtEqBand *self, gint samplerate, gint channels);
+void gstbt_eq_band_reset (GstBtEqBand *self);
+void gstbt_eq_band_process (GstBtEqBand *self, guint n, gfloat *data);
+
+G_END_DECLS
+#endif /* __GSTBT_EQ_BAND_H__ */
@@ -0,0 +1,612 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * fdnreverb.c: feedback delay network reverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:fdnreverb
+ * @title: GstBtFdnReverb
+ * @short_description: feedback delay network reverb
+ *
+ * <refsect2>
+ * Reverb made from a network of #GstBtDelay lines. The outputs of all lines
+ * are mixed through a householder matrix and fed back into the lines. A
+ * lowpass filter in each line damps the high frequencies of the tail.
+ *
+ * The lengths of the lines are mutually prime and scale with
+ * #GstBtFdnReverb:room-size. The feedback gains are calculated from the
+ * lengths so that the tail decays by 60 dB within
+ * #GstBtFdnReverb:decay-time.
+ * <title>Example launch line</title>
+ * <para>
+ * <programlisting>
+ * gst-launch filesrc location="melo1.ogg" ! decodebin ! audioconvert ! fdnreverb drywet=30 room-size=80 decay-time=3.0 ! autoaudiosink
+ * </programlisting>
+ * </para>
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include <libgstbuzztrax/denormal.h>
+
+#include "fdnreverb.h"
+
+#define GST_CAT_DEFAULT fdn_reverb_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define BLOCK_SIZE 256
+/* level changes are spread over this time (in seconds) */
+#define LEVEL_SMOOTHING 0.01
+#define MIN_LINES 8
+#define MAX_LINES 16
+
+/* line lengths for the largest room (in seconds), the lines in use are spread
+ * over the table */
+static const gdouble line_times[MAX_LINES] = {
+  0.0297, 0.0371, 0.0411, 0.0437, 0.0479, 0.0533, 0.0571, 0.0617,
+  0.0673, 0.0719, 0.0757, 0.0797, 0.0839, 0.0887, 0.0929, 0.0997
+};
+
+enum
+{
+  // static class properties
+  PROP_LINES = 1,
+  // dynamic class properties
+  PROP_DRYWET,
+  PROP_ROOM_SIZE,
+  PROP_DECAY_TIME,
+  PROP_DAMPING
+};
+
+#define FDN_REVERB_CAPS \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (FDN_REVERB_CAPS)
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (FDN_REVERB_CAPS)
+    );
+
+//-- the class
+
+G_DEFINE_TYPE (GstBtFdnReverb, gstbt_fdn_reverb, GST_TYPE_BASE_TRANSFORM);
+
+//-- private methods
+
+static gboolean
+gstbt_fdn_reverb_is_prime (guint n)
+{
+  guint i;
+
+  if (n < 2)
+    return FALSE;
+  if (!(n & 1))
+    return (n == 2);
+  for (i = 3; i * i <= n; i += 2) {
+    if (!(n % i))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* calculate the line lengths in samples, the lengths are increasing primes,
+ * thus the echo patterns of the lines don't line up */
+static void
+gstbt_fdn_reverb_calc_lengths (GstBtFdnReverb * self, guint room_size,
+    guint * lengths)
+{
+  const gdouble scale = 0.2 + 0.8 * (room_size / 100.0);
+  guint k, len, prev = 1;
+
+  for (k = 0; k < self->num_lines; k++) {
+    len = (guint) (line_times[(k * MAX_LINES) / self->num_lines] * scale *
+        self->samplerate);
+    len = MAX (len, prev + 1);
+    while (!gstbt_fdn_reverb_is_prime (len))
+      len++;
+    lengths[k] = prev = len;
+  }
+}
+
+/* Must be called with the object lock held, the lines are replaced from the
+ * streaming thread when the caps change. */
+static void
+gstbt_fdn_reverb_update_lines (GstBtFdnReverb * self)
+{
+  guint lengths[MAX_LINES];
+  guint k;
+
+  if (!self->delays)
+    return;
+
+  gstbt_fdn_reverb_calc_lengths (self, self->room_size, lengths);
+  for (k = 0; k < self->num_lines; k++) {
+    gstbt_delay_set_delay (self->delays[k], lengths[k]);
+    /* -60 dB after decay_time */
+    self->gains[k] = (gfloat) pow (10.0, -3.0 * lengths[k] /
+        (self->samplerate * self->decay_time));
+    GST_DEBUG_OBJECT (self, "line %u: %u samples, gain %f", k, lengths[k],
+        self->gains[k]);
+  }
+}
+
+/* Must be called with the object lock held. */
+static void
+gstbt_fdn_reverb_free_lines (GstBtFdnReverb * self)
+{
+  guint k;
+
+  if (self->delays) {
+    for (k = 0; k < self->num_lines; k++) {
+      g_object_unref (self->delays[k]);
+    }
+    g_free (self->delays);
+    self->delays = NULL;
+  }
+  self->num_lines = 0;
+  g_free (self->gains);
+  self->gains = NULL;
+  g_free (self->damp);
+  self->damp = NULL;
+  g_free (self->taps);
+  self->taps = NULL;
+  g_free (self->dry);
+  self->dry = NULL;
+  g_free (self->mono);
+  self->mono = NULL;
+  g_free (self->sum);
+  self->sum = NULL;
+  g_free (self->mix);
+  self->mix = NULL;
+}
+
+static void
+gstbt_fdn_reverb_flush (GstBtFdnReverb * self)
+{
+  guint k;
+
+  for (k = 0; k < self->num_lines; k++) {
+    gstbt_delay_flush (self->delays[k]);
+    self->damp[k] = 0.0;
+  }
+  gstbt_smoother_reset (&self->drywet_smoother, self->drywet / 100.0);
+}
+
+/* Process @num_frames interleaved frames in place. If @silent is %TRUE, the
+ * input is ignored and only the tail is rendered.
+ * Returns %TRUE if the output is not silent.
+ */
+static gboolean
+gstbt_fdn_reverb_process (GstBtFdnReverb * self, gpointer data,
+    guint num_frames, gboolean silent)
+{
+  const guint channels = self->channels;
+  const guint num_lines = self->num_lines;
+  const gboolean is_float =
+      (GST_AUDIO_INFO_FORMAT (&self->info) == GST_AUDIO_FORMAT_F32);
+  const gfloat in_gain = 1.0 / (sqrt (num_lines) * channels);
+  const gfloat fb_gain = 2.0 / num_lines;
+  const gfloat damping = self->damping / 125.0;
+  gint16 *d16 = (gint16 *) data;
+  gfloat *d32 = (gfloat *) data;
+  gfloat *mono = self->mono, *sum = self->sum, *mix = self->mix;
+  gdouble wet[BLOCK_SIZE];
+  GstBtDelay *delay;
+  gfloat *dry, *tap;
+  gfloat gain, state, sign, out_gain;
+  guint c, i, k, s, n, cnt, max_block = BLOCK_SIZE;
+  gboolean audible = FALSE;
+
+  /* all lines are read before they are written, thus a block must not be
+   * longer than the shortest line, see audiodelay */
+  for (k = 0; k < num_lines; k++) {
+    delay = self->delays[k];
+    max_block = MIN (max_block, MIN (MIN (delay->delay, delay->read_delay),
+            delay->old_delay));
+  }
+  max_block = MAX (max_block, 1);
+
+  while (num_frames) {
+    n = MIN (num_frames, max_block);
+    gstbt_smoother_get_block (&self->drywet_smoother, n, wet);
+
+    /* deinterleave and downmix */
+    memset (mono, 0, n * sizeof (gfloat));
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      if (silent) {
+        memset (dry, 0, n * sizeof (gfloat));
+        continue;
+      }
+      if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = d32[s];
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          dry[i] = (gfloat) d16[s];
+        }
+      }
+      for (i = 0; i < n; i++) {
+        mono[i] += in_gain * dry[i];
+      }
+    }
+
+    /* read, damp and attenuate the lines */
+    memset (sum, 0, n * sizeof (gfloat));
+    for (k = 0; k < num_lines; k++) {
+      tap = &self->taps[k * BLOCK_SIZE];
+      gstbt_delay_read_block (self->delays[k], n, tap);
+      gain = self->gains[k];
+      state = self->damp[k];
+      for (i = 0; i < n; i++) {
+        state = tap[i] + damping * (state - tap[i]);
+        tap[i] = gain * state;
+      }
+      self->damp[k] = state;
+      for (i = 0; i < n; i++) {
+        sum[i] += tap[i];
+      }
+    }
+
+    /* the householder matrix (I - 2/N * 1 * 1^T) only needs the sum of all
+     * lines, this is O(N) instead of O(N^2) and runs over whole blocks, so
+     * that the loops vectorize, alternate the input polarity per line */
+    for (k = 0; k < num_lines; k++) {
+      tap = &self->taps[k * BLOCK_SIZE];
+      sign = (k & 1) ? -1.0 : 1.0;
+      for (i = 0; i < n; i++) {
+        mix[i] = tap[i] - fb_gain * sum[i] + sign * mono[i];
+      }
+      gstbt_delay_write_block (self->delays[k], n, mix);
+    }
+
+    /* distribute the lines over the channels and mix */
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      memset (mix, 0, n * sizeof (gfloat));
+      for (k = c % num_lines, cnt = 0; k < num_lines; k += channels, cnt++) {
+        tap = &self->taps[k * BLOCK_SIZE];
+        for (i = 0; i < n; i++) {
+          mix[i] += tap[i];
+        }
+      }
+      out_gain = 1.0 / sqrt (cnt);
+      for (i = 0; i < n; i++) {
+        dry[i] += (gfloat) wet[i] * (out_gain * mix[i] - dry[i]);
+      }
+    }
+
+    /* interleave */
+    for (c = 0; c < channels; c++) {
+      dry = &self->dry[c * BLOCK_SIZE];
+      if (is_float) {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d32[s] = dry[i];
+          audible |= (dry[i] != 0.0);
+        }
+      } else {
+        for (i = 0, s = c; i < n; i++, s += channels) {
+          d16[s] = (gint16) CLAMP (dry[i], G_MININT16, G_MAXINT16);
+          audible |= (d16[s] != 0);
+        }
+      }
+    }
+    d16 += n * channels;
+    d32 += n * channels;
+    num_frames -= n;
+  }
+  return audible;
+}
+
+//-- basetransform vmethods
+
+static gboolean
+gstbt_fdn_reverb_set_caps (GstBaseTransform * base, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (base);
+  guint lengths[MAX_LINES];
+  guint k;
+
+  if (!gst_audio_info_from_caps (&self->info, incaps))
+    return FALSE;
+
+  self->samplerate = GST_AUDIO_INFO_RATE (&self->info);
+  self->channels = GST_AUDIO_INFO_CHANNELS (&self->info);
+  gstbt_smoother_set_length (&self->drywet_smoother,
+      (guint) (self->samplerate * LEVEL_SMOOTHING));
+
+  /* the lines are allocated for the largest room, so that changing the room
+   * size never needs to reallocate */
+  GST_OBJECT_LOCK (self);
+  gstbt_fdn_reverb_free_lines (self);
+  self->num_lines = self->lines;
+  gstbt_fdn_reverb_calc_lengths (self, 100, lengths);
+  self->delays = g_new (GstBtDelay *, self->num_lines);
+  for (k = 0; k < self->num_lines; k++) {
+    self->delays[k] = gstbt_delay_new ();
+    gstbt_delay_start (self->delays[k], self->samplerate, lengths[k]);
+  }
+  self->gains = g_new0 (gfloat, self->num_lines);
+  self->damp = g_new0 (gfloat, self->num_lines);
+  self->taps = g_new0 (gfloat, self->num_lines * BLOCK_SIZE);
+  self->dry = g_new0 (gfloat, self->channels * BLOCK_SIZE);
+  self->mono = g_new0 (gfloat, BLOCK_SIZE);
+  self->sum = g_new0 (gfloat, BLOCK_SIZE);
+  self->mix = g_new0 (gfloat, BLOCK_SIZE);
+  gstbt_fdn_reverb_update_lines (self);
+  GST_OBJECT_UNLOCK (self);
+  return TRUE;
+}
+
+static GstFlowReturn
+gstbt_fdn_reverb_transform_ip (GstBaseTransform * base, GstBuffer * outbuf)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (base);
+  GstMapInfo info;
+  GstClockTime timestamp;
+  gboolean silent, audible;
+  guint num_frames;
+  guint fpu_state;
+
+  if (!gst_buffer_map (outbuf, &info, GST_MAP_READ | GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (base, "unable to map buffer for read & write");
+    return GST_FLOW_ERROR;
+  }
+  num_frames = info.size / GST_AUDIO_INFO_BPF (&self->info);
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (!self->delays)) {
+    GST_OBJECT_UNLOCK (self);
+    gst_buffer_unmap (outbuf, &info);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_DISCONT)) {
+    gstbt_fdn_reverb_flush (self);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  timestamp = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    gst_object_sync_values (GST_OBJECT (self), timestamp);
+
+  /* input is silence */
+  silent = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) ||
+      gst_base_transform_is_passthrough (base);
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (!self->delays)) {
+    GST_OBJECT_UNLOCK (self);
+    gst_buffer_unmap (outbuf, &info);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+  fpu_state = gstbt_denormal_enter ();
+  audible = gstbt_fdn_reverb_process (self, info.data, num_frames, silent);
+  gstbt_denormal_leave (fpu_state);
+  GST_OBJECT_UNLOCK (self);
+
+  if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP) && audible) {
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+  }
+
+  gst_buffer_unmap (outbuf, &info);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gstbt_fdn_reverb_stop (GstBaseTransform * base)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (base);
+
+  GST_OBJECT_LOCK (self);
+  gstbt_fdn_reverb_free_lines (self);
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_fdn_reverb_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (object);
+
+  switch (prop_id) {
+    case PROP_LINES:
+      self->lines = g_value_get_uint (value);
+      break;
+    case PROP_DRYWET:
+      self->drywet = g_value_get_uint (value);
+      gstbt_smoother_set_target (&self->drywet_smoother, self->drywet / 100.0);
+      break;
+    case PROP_ROOM_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->room_size = g_value_get_uint (value);
+      gstbt_fdn_reverb_update_lines (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_DECAY_TIME:
+      GST_OBJECT_LOCK (self);
+      self->decay_time = g_value_get_double (value);
+      gstbt_fdn_reverb_update_lines (self);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_DAMPING:
+      self->damping = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_fdn_reverb_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (object);
+
+  switch (prop_id) {
+    case PROP_LINES:
+      g_value_set_uint (value, self->lines);
+      break;
+    case PROP_DRYWET:
+      g_value_set_uint (value, self->drywet);
+      break;
+    case PROP_ROOM_SIZE:
+      g_value_set_uint (value, self->room_size);
+      break;
+    case PROP_DECAY_TIME:
+      g_value_set_double (value, self->decay_time);
+      break;
+    case PROP_DAMPING:
+      g_value_set_uint (value, self->damping);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_fdn_reverb_finalize (GObject * object)
+{
+  GstBtFdnReverb *self = GSTBT_FDN_REVERB (object);
+
+  gstbt_fdn_reverb_free_lines (self);
+
+  G_OBJECT_CLASS (gstbt_fdn_reverb_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_fdn_reverb_init (GstBtFdnReverb * self)
+{
+  self->lines = MIN_LINES;
+  self->drywet = 30;
+  self->room_size = 50;
+  self->decay_time = 2.0;
+  self->damping = 50;
+
+  self->samplerate = GST_AUDIO_DEF_RATE;
+  gstbt_smoother_init (&self->drywet_smoother, GSTBT_SMOOTHER_LINEAR,
+      (guint) (self->samplerate * LEVEL_SMOOTHING), self->drywet / 100.0);
+  gst_audio_info_init (&self->info);
+
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
+}
+
+static void
+gstbt_fdn_reverb_class_init (GstBtFdnReverbClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseTransformClass *gstbasetransform_class =
+      (GstBaseTransformClass *) klass;
+
+  gobject_class->set_property = gstbt_fdn_reverb_set_property;
+  gobject_class->get_property = gstbt_fdn_reverb_get_property;
+  gobject_class->finalize = gstbt_fdn_reverb_finalize;
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_LINES,
+      g_param_spec_uint ("lines", "Lines",
+          "Number of delay lines, used when the format is negotiated",
+          MIN_LINES, MAX_LINES, MIN_LINES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DRYWET,
+      g_param_spec_uint ("drywet", "Dry-Wet",
+          "Intensity of effect (0 none -> 100 full)", 0, 100, 30,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_ROOM_SIZE,
+      g_param_spec_uint ("room-size", "Room size",
+          "Size of the room in percent", 1, 100, 50,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_DECAY_TIME,
+      g_param_spec_double ("decay-time", "Decay time",
+          "Time in seconds until the reverb tail has decayed by 60 dB", 0.1,
+          30.0, 2.0, G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  g_object_class_install_property (gobject_class, PROP_DAMPING,
+      g_param_spec_uint ("damping", "Damping",
+          "Damping of high frequencies in the tail in percent", 0, 100, 50,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+
+  gstbasetransform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gstbt_fdn_reverb_set_caps);
+  gstbasetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gstbt_fdn_reverb_transform_ip);
+  gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gstbt_fdn_reverb_stop);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "FdnReverb",
+      "Filter/Effect/Audio",
+      "Feedback delay network reverb", "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtFdnReverb.html");
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "fdnreverb",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "feedback delay network reverb");
+
+  return gst_element_register (plugin, "fdnreverb", GST_RANK_NONE,
+      GSTBT_TYPE_FDN_REVERB);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    fdnreverb,
+    "Feedback delay network reverb",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
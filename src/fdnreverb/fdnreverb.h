@@ -0,0 +1,78 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * fdnreverb.h: feedback delay network reverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_FDN_REVERB_H__
+#define __GSTBT_FDN_REVERB_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+#include <libgstbuzztrax/delay.h>
+#include <libgstbuzztrax/smoother.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_FDN_REVERB            (gstbt_fdn_reverb_get_type())
+#define GSTBT_FDN_REVERB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_FDN_REVERB,GstBtFdnReverb))
+#define GSTBT_IS_FDN_REVERB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_FDN_REVERB))
+#define GSTBT_FDN_REVERB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_FDN_REVERB,GstBtFdnReverbClass))
+#define GSTBT_IS_FDN_REVERB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_FDN_REVERB))
+#define GSTBT_FDN_REVERB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_FDN_REVERB,GstBtFdnReverbClass))
+
+typedef struct _GstBtFdnReverb      GstBtFdnReverb;
+typedef struct _GstBtFdnReverbClass GstBtFdnReverbClass;
+
+/**
+ * GstBtFdnReverb:
+ *
+ * Class instance data.
+ */
+struct _GstBtFdnReverb {
+  GstBaseTransform parent;
+
+  /* < private > */
+  /* properties */
+  guint drywet;
+  guint room_size;
+  gdouble decay_time;
+  guint damping;
+  guint lines;
+  GstBtSmoother drywet_smoother;
+
+  GstAudioInfo info;
+  gint samplerate;
+  guint channels;
+  guint num_lines;              /* number of lines in use */
+  GstBtDelay **delays;
+  gfloat *gains;                /* feedback gain per line */
+  gfloat *damp;                 /* damping filter state per line */
+  gfloat *taps;                 /* outputs of the lines for the current block */
+  gfloat *dry;                  /* input/output of the current block per channel */
+  gfloat *mono, *sum, *mix;     /* scratch buffers for the current block */
+};
+
+struct _GstBtFdnReverbClass {
+  GstBaseTransformClass parent_class;
+};
+
+GType gstbt_fdn_reverb_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GSTBT_FDN_REVERB_H__ */
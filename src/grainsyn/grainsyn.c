@@ -0,0 +1,593 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * grainsyn.c: granular synthesizer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:grainsyn
+ * @title: GstBtGrainSyn
+ * @short_description: granular synthesizer
+ *
+ * A synth that takes short snippets (grains) from one wavetable entry, applies
+ * a window to them and mixes the overlapping grains into the output. While a
+ * note plays, the grains move through the wave, so that the whole wave is
+ * stretched or squeezed to the note length.
+ *
+ * The number of grains per second is set by #GstBtGrainSyn:density and their
+ * length by #GstBtGrainSyn:grain-size. Each grain can be accompanied by
+ * #GstBtGrainSyn:extra-grains quieter grains taken from up to
+ * #GstBtGrainSyn:spread milliseconds before or after it in the wave.
+ *
+ * At most 256 grains play at the same time, further grains are dropped.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+#include <libgstbuzztrax/propertymeta.h>
+#include "grainsyn.h"
+#include "gstgrainsynorc.h"
+
+#define GST_CAT_DEFAULT grain_syn_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* frames per mixing block */
+#define BLOCK_SIZE 256
+
+/* size of the window tables, the top bits of the grain phase are the index */
+#define WINDOW_BITS 12
+#define WINDOW_SIZE (1 << WINDOW_BITS)
+
+enum
+{
+  // static class properties
+  PROP_WAVE_CALLBACKS = 1,
+  PROP_TUNING,
+  PROP_INTERPOLATION,
+  PROP_MIPMAPS,
+  PROP_MIP_CROSSFADE,
+  // dynamic class properties
+  PROP_NOTE,
+  PROP_NOTE_LENGTH,
+  PROP_WAVE,
+  PROP_WINDOW,
+  PROP_GRAIN_SIZE,
+  PROP_DENSITY,
+  PROP_VOLUME,
+  PROP_EXTRA_GRAINS,
+  PROP_EXTRA_VOLUME,
+  PROP_SPREAD
+};
+
+static gfloat windows[GSTBT_GRAIN_SYN_NUM_WINDOWS][WINDOW_SIZE];
+
+//-- the class
+
+G_DEFINE_TYPE_WITH_CODE (GstBtGrainSyn, gstbt_grain_syn,
+    GSTBT_TYPE_AUDIO_SYNTH, G_IMPLEMENT_INTERFACE (GSTBT_TYPE_PROPERTY_META,
+        NULL));
+
+//-- enums
+
+GType
+gstbt_grain_syn_window_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_GRAIN_SYN_WINDOW_TRIANGLE, "Triangle", "triangle"},
+    {GSTBT_GRAIN_SYN_WINDOW_HANN, "Hann", "hann"},
+    {GSTBT_GRAIN_SYN_WINDOW_BLACKMAN, "Blackman", "blackman"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtGrainSynWindow", enums);
+  }
+  return type;
+}
+
+//-- helper
+
+static void
+gstbt_grain_syn_init_windows (void)
+{
+  gdouble x;
+  guint i;
+
+  for (i = 0; i < WINDOW_SIZE; i++) {
+    x = (gdouble) i / WINDOW_SIZE;
+    windows[GSTBT_GRAIN_SYN_WINDOW_TRIANGLE][i] = 1.0 - fabs (2.0 * x - 1.0);
+    windows[GSTBT_GRAIN_SYN_WINDOW_HANN][i] = 0.5 - 0.5 * cos (2.0 * G_PI * x);
+    windows[GSTBT_GRAIN_SYN_WINDOW_BLACKMAN][i] =
+        0.42 - 0.5 * cos (2.0 * G_PI * x) + 0.08 * cos (4.0 * G_PI * x);
+  }
+}
+
+/* uniform random number in [0,1), the generator is reseeded for each note so
+ * that rendering a song twice gives the same result */
+static gdouble
+gstbt_grain_syn_random (GstBtGrainSyn * src)
+{
+  src->seed = src->seed * 1664525 + 1013904223;
+  return (gdouble) (src->seed >> 8) / (gdouble) (1 << 24);
+}
+
+static void
+gstbt_grain_syn_add_grain (GstBtGrainSyn * src, guint delay, gint64 pos,
+    guint length, gfloat volume)
+{
+  GstBtGrainSynGrain *g;
+
+  if (src->num_grains == GSTBT_GRAIN_SYN_MAX_GRAINS) {
+    GST_LOG_OBJECT (src, "too many grains, dropping one");
+    return;
+  }
+  g = &src->grains[src->num_grains++];
+  g->pos = MAX (pos, 0);
+  g->length = length;
+  g->done = 0;
+  g->delay = delay;
+  g->phase = 0;
+  g->step = (guint32) (G_GUINT64_CONSTANT (0x100000000) / length);
+  g->volume = volume;
+}
+
+/* start the grains that begin within the next @ct frames */
+static void
+gstbt_grain_syn_schedule (GstBtGrainSyn * src, guint ct)
+{
+  const gint samplerate = ((GstBtAudioSynth *) src)->samplerate;
+  const gdouble interval = samplerate / src->density;
+  const guint length = MAX (1, (guint) (src->grain_size * samplerate / 1000.0));
+  const gdouble spread = src->spread * samplerate / 1000.0;
+  const gfloat volume = src->volume;
+  const gfloat extra_volume = src->volume * src->extra_volume;
+  guint64 note_pos;
+  gint64 pos, offset;
+  guint i, delay;
+
+  if (!src->playing)
+    return;
+
+  while (src->next_grain < ct) {
+    delay = (guint) src->next_grain;
+    note_pos = src->note_pos + delay;
+    if (note_pos >= src->note_frames) {
+      src->playing = FALSE;
+      return;
+    }
+    // move through the wave over the length of the note
+    pos = (gint64) gst_util_uint64_scale (note_pos, src->duration,
+        src->note_frames);
+    gstbt_grain_syn_add_grain (src, delay, pos, length, volume);
+    for (i = 0; i < src->extra_grains; i++) {
+      offset = (gint64) (spread * gstbt_grain_syn_random (src));
+      gstbt_grain_syn_add_grain (src, delay, (i & 1) ? pos + offset :
+          pos - offset, length, extra_volume);
+    }
+    src->next_grain += interval;
+  }
+  src->next_grain -= ct;
+  src->note_pos += ct;
+}
+
+/* render and mix one block of all grains into @mix */
+static void
+gstbt_grain_syn_mix (GstBtGrainSyn * src, guint ct, gint ch, gfloat * mix)
+{
+  GstBtOscWave *osc = src->osc;
+  const gfloat *win = windows[src->window];
+  gint16 *scratch = src->scratch;
+  gfloat *gain = src->gain;
+  GstBtGrainSynGrain *g;
+  guint i = 0, f, m, c, k;
+  guint32 phase, step;
+  gfloat w;
+
+  while (i < src->num_grains) {
+    g = &src->grains[i];
+    m = MIN (ct - g->delay, g->length - g->done);
+
+    if (osc->process (osc, g->pos, m, scratch)) {
+      phase = g->phase;
+      step = g->step;
+      for (f = 0, k = 0; f < m; f++) {
+        w = win[phase >> (32 - WINDOW_BITS)] * g->volume;
+        for (c = 0; c < ch; c++) {
+          gain[k++] = w;
+        }
+        phase += step;
+      }
+      orc_grain_syn_mac_s16 (&mix[g->delay * ch], scratch, gain, m * ch);
+      g->phase = phase;
+      g->pos += m;
+      g->done += m;
+      g->delay = 0;
+    } else {
+      // the grain has run past the end of the wave
+      g->done = g->length;
+    }
+
+    if (g->done >= g->length) {
+      src->grains[i] = src->grains[--src->num_grains];
+    } else {
+      i++;
+    }
+  }
+}
+
+//-- audiosynth vmethods
+
+static gboolean
+gstbt_grain_syn_setup (GstBtAudioSynth * base, GstPad * pad, GstCaps * caps)
+{
+  GstBtGrainSyn *src = ((GstBtGrainSyn *) base);
+  GstStructure *structure;
+  gint i, n = gst_caps_get_size (caps), c = src->osc->channels;
+
+  gstbt_osc_wave_setup (src->osc);
+
+  for (i = 0; i < n; i++) {
+    structure = gst_caps_get_structure (caps, i);
+    gst_structure_fixate_field_nearest_int (structure, "channels", c);
+  }
+  return TRUE;
+}
+
+static gboolean
+gstbt_grain_syn_process (GstBtAudioSynth * base, GstBuffer * data,
+    GstMapInfo * info)
+{
+  GstBtGrainSyn *src = ((GstBtGrainSyn *) base);
+  gint16 *d = (gint16 *) info->data;
+  guint n = base->generate_samples_per_buffer;
+  gint ch = base->channels;
+  gfloat *mix;
+  guint i, ct, ns;
+  glong val;
+
+  if (!src->osc->process || (!src->playing && !src->num_grains))
+    return FALSE;
+
+  if (src->mix_channels != ch) {
+    src->mix = g_renew (gfloat, src->mix, BLOCK_SIZE * ch);
+    src->gain = g_renew (gfloat, src->gain, BLOCK_SIZE * ch);
+    src->scratch = g_renew (gint16, src->scratch, BLOCK_SIZE * ch);
+    src->mix_channels = ch;
+  }
+  mix = src->mix;
+
+  while (n) {
+    ct = MIN (n, BLOCK_SIZE);
+    ns = ct * ch;
+    memset (mix, 0, ns * sizeof (gfloat));
+    gstbt_grain_syn_schedule (src, ct);
+    gstbt_grain_syn_mix (src, ct, ch, mix);
+    for (i = 0; i < ns; i++) {
+      val = (glong) mix[i];
+      d[i] = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
+    }
+    d += ns;
+    n -= ct;
+  }
+  return TRUE;
+}
+
+//-- gobject vmethods
+
+static void
+gstbt_grain_syn_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtGrainSyn *src = GSTBT_GRAIN_SYN (object);
+
+  if (src->dispose_has_run)
+    return;
+
+  switch (prop_id) {
+    case PROP_WAVE_CALLBACKS:
+    case PROP_INTERPOLATION:
+    case PROP_MIPMAPS:
+    case PROP_MIP_CROSSFADE:
+    case PROP_WAVE:
+      g_object_set_property ((GObject *) (src->osc), pspec->name, value);
+      break;
+    case PROP_TUNING:
+      g_object_set_property ((GObject *) (src->n2f), "tuning", value);
+      break;
+    case PROP_NOTE:
+      if ((src->note = g_value_get_enum (value))) {
+        GstBtAudioSynth *base = (GstBtAudioSynth *) src;
+        gdouble freq =
+            gstbt_tone_conversion_translate_from_number (src->n2f, src->note);
+
+        GST_DEBUG ("new note -> '%d'", src->note);
+        if (freq > 0.0) {
+          g_object_set (src->osc, "frequency", freq, NULL);
+          g_object_get (src->osc, "duration", &src->duration, NULL);
+
+          src->note_frames = gst_util_uint64_scale (src->note_length *
+              base->ticktime, base->samplerate, GST_SECOND);
+          src->note_pos = 0;
+          src->next_grain = 0.0;
+          src->seed = 1;
+          src->playing = (src->note_frames > 0);
+        } else {
+          // note-off: let the running grains fade out
+          src->playing = FALSE;
+        }
+      }
+      break;
+    case PROP_NOTE_LENGTH:
+      src->note_length = g_value_get_uint (value);
+      break;
+    case PROP_WINDOW:
+      src->window = g_value_get_enum (value);
+      break;
+    case PROP_GRAIN_SIZE:
+      src->grain_size = g_value_get_double (value);
+      break;
+    case PROP_DENSITY:
+      src->density = g_value_get_double (value);
+      break;
+    case PROP_VOLUME:
+      src->volume = g_value_get_double (value);
+      break;
+    case PROP_EXTRA_GRAINS:
+      src->extra_grains = g_value_get_uint (value);
+      break;
+    case PROP_EXTRA_VOLUME:
+      src->extra_volume = g_value_get_double (value);
+      break;
+    case PROP_SPREAD:
+      src->spread = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_grain_syn_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBtGrainSyn *src = GSTBT_GRAIN_SYN (object);
+
+  if (src->dispose_has_run)
+    return;
+
+  switch (prop_id) {
+    case PROP_WAVE_CALLBACKS:
+    case PROP_INTERPOLATION:
+    case PROP_MIPMAPS:
+    case PROP_MIP_CROSSFADE:
+    case PROP_WAVE:
+      g_object_get_property ((GObject *) (src->osc), pspec->name, value);
+      break;
+    case PROP_TUNING:
+      g_object_get_property ((GObject *) (src->n2f), "tuning", value);
+      break;
+    case PROP_NOTE_LENGTH:
+      g_value_set_uint (value, src->note_length);
+      break;
+    case PROP_WINDOW:
+      g_value_set_enum (value, src->window);
+      break;
+    case PROP_GRAIN_SIZE:
+      g_value_set_double (value, src->grain_size);
+      break;
+    case PROP_DENSITY:
+      g_value_set_double (value, src->density);
+      break;
+    case PROP_VOLUME:
+      g_value_set_double (value, src->volume);
+      break;
+    case PROP_EXTRA_GRAINS:
+      g_value_set_uint (value, src->extra_grains);
+      break;
+    case PROP_EXTRA_VOLUME:
+      g_value_set_double (value, src->extra_volume);
+      break;
+    case PROP_SPREAD:
+      g_value_set_double (value, src->spread);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_grain_syn_dispose (GObject * object)
+{
+  GstBtGrainSyn *src = GSTBT_GRAIN_SYN (object);
+
+  if (src->dispose_has_run)
+    return;
+  src->dispose_has_run = TRUE;
+
+  if (src->n2f)
+    g_object_unref (src->n2f);
+  if (src->osc)
+    g_object_unref (src->osc);
+
+  G_OBJECT_CLASS (gstbt_grain_syn_parent_class)->dispose (object);
+}
+
+static void
+gstbt_grain_syn_finalize (GObject * object)
+{
+  GstBtGrainSyn *src = GSTBT_GRAIN_SYN (object);
+
+  g_free (src->mix);
+  g_free (src->gain);
+  g_free (src->scratch);
+
+  G_OBJECT_CLASS (gstbt_grain_syn_parent_class)->finalize (object);
+}
+
+//-- gobject type methods
+
+static void
+gstbt_grain_syn_init (GstBtGrainSyn * src)
+{
+  /* set base parameters */
+  src->note_length = 1;
+  src->window = GSTBT_GRAIN_SYN_WINDOW_TRIANGLE;
+  src->grain_size = 50.0;
+  src->density = 40.0;
+  src->volume = 0.8;
+  src->extra_volume = 0.5;
+  src->spread = 20.0;
+
+  src->n2f =
+      gstbt_tone_conversion_new (GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
+
+  /* synth components */
+  src->osc = gstbt_osc_wave_new ();
+}
+
+static void
+gstbt_grain_syn_class_init (GstBtGrainSynClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBtAudioSynthClass *audio_synth_class = (GstBtAudioSynthClass *) klass;
+  GParamSpec *pspec;
+
+  gstbt_grain_syn_init_windows ();
+
+  audio_synth_class->process = gstbt_grain_syn_process;
+  audio_synth_class->setup = gstbt_grain_syn_setup;
+
+  gobject_class->set_property = gstbt_grain_syn_set_property;
+  gobject_class->get_property = gstbt_grain_syn_get_property;
+  gobject_class->dispose = gstbt_grain_syn_dispose;
+  gobject_class->finalize = gstbt_grain_syn_finalize;
+
+  // describe us
+  gst_element_class_set_static_metadata (element_class,
+      "GrainSyn",
+      "Source/Audio",
+      "Granular synthesizer", "Stefan Sauer <ensonic@users.sf.net>");
+  gst_element_class_add_metadata (element_class, GST_ELEMENT_METADATA_DOC_URI,
+      "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
+      G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtGrainSyn.html");
+
+  // register own properties
+  g_object_class_install_property (gobject_class, PROP_WAVE_CALLBACKS,
+      g_param_spec_pointer ("wave-callbacks", "Wavetable Callbacks",
+          "The wave-table access callbacks",
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TUNING,
+      g_param_spec_enum ("tuning", "Tuning", "Harmonic tuning",
+          GSTBT_TYPE_TONE_CONVERSION_TUNING,
+          GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation mode for playing the wave at a different pitch",
+          GSTBT_TYPE_OSC_WAVE_INTERPOLATION,
+          GSTBT_OSC_WAVE_INTERPOLATION_LINEAR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIPMAPS,
+      g_param_spec_boolean ("mipmaps", "Mipmaps",
+          "Use band-limited copies of the wave when playing at a higher pitch",
+          TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIP_CROSSFADE,
+      g_param_spec_boolean ("mip-crossfade", "Mip crossfade",
+          "Crossfade between the two closest band-limited copies", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NOTE,
+      g_param_spec_enum ("note", "Musical note",
+          "Musical note (e.g. 'c-3', 'd#4')", GSTBT_TYPE_NOTE, GSTBT_NOTE_NONE,
+          G_PARAM_WRITABLE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NOTE_LENGTH,
+      g_param_spec_uint ("length", "Note length", "Note length in ticks",
+          1, 255, 1,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  pspec = g_param_spec_uint ("wave", "Wave", "Wave index", 1, 200, 1,
+      G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS);
+  g_param_spec_set_qdata (pspec, gstbt_property_meta_quark,
+      GUINT_TO_POINTER (1));
+  g_param_spec_set_qdata (pspec, gstbt_property_meta_quark_flags,
+      GUINT_TO_POINTER (GSTBT_PROPERTY_META_WAVE));
+  g_object_class_install_property (gobject_class, PROP_WAVE, pspec);
+
+  g_object_class_install_property (gobject_class, PROP_WINDOW,
+      g_param_spec_enum ("window", "Window", "Window shape of the grains",
+          GSTBT_TYPE_GRAIN_SYN_WINDOW, GSTBT_GRAIN_SYN_WINDOW_TRIANGLE,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GRAIN_SIZE,
+      g_param_spec_double ("grain-size", "Grain size",
+          "Length of the grains in ms", 1.0, 1000.0, 50.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DENSITY,
+      g_param_spec_double ("density", "Density",
+          "Number of grains started per second", 1.0, 1000.0, 40.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOLUME,
+      g_param_spec_double ("volume", "Volume", "Volume of the grains",
+          0.0, 1.0, 0.8,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_EXTRA_GRAINS,
+      g_param_spec_uint ("extra-grains", "Extra grains",
+          "Number of extra grains around each grain", 0, 8, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_EXTRA_VOLUME,
+      g_param_spec_double ("extra-volume", "Extra volume",
+          "Volume of the extra grains relative to the grain", 0.0, 1.0, 0.5,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SPREAD,
+      g_param_spec_double ("spread", "Spread",
+          "Maximum distance of the extra grains in ms", 0.0, 1000.0, 20.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+}
+
+//-- plugin
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "grainsyn",
+      GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK, "granular synthesizer");
+
+  return gst_element_register (plugin, "grainsyn", GST_RANK_NONE,
+      GSTBT_TYPE_GRAIN_SYN);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    grainsyn,
+    "Granular synthesizer",
+    plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN);
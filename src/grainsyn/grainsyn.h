@@ -0,0 +1,121 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * grainsyn.h: granular synthesizer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_GRAIN_SYN_H__
+#define __GSTBT_GRAIN_SYN_H__
+
+#include <gst/gst.h>
+#include <libgstbuzztrax/audiosynth.h>
+#include <libgstbuzztrax/osc-wave.h>
+#include <libgstbuzztrax/toneconversion.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_GRAIN_SYN            (gstbt_grain_syn_get_type())
+#define GSTBT_GRAIN_SYN(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_GRAIN_SYN,GstBtGrainSyn))
+#define GSTBT_IS_GRAIN_SYN(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_GRAIN_SYN))
+#define GSTBT_GRAIN_SYN_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_GRAIN_SYN,GstBtGrainSynClass))
+#define GSTBT_IS_GRAIN_SYN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_GRAIN_SYN))
+#define GSTBT_GRAIN_SYN_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_GRAIN_SYN,GstBtGrainSynClass))
+
+#define GSTBT_TYPE_GRAIN_SYN_WINDOW (gstbt_grain_syn_window_get_type())
+
+/**
+ * GstBtGrainSynWindow:
+ * @GSTBT_GRAIN_SYN_WINDOW_TRIANGLE: triangle window
+ * @GSTBT_GRAIN_SYN_WINDOW_HANN: hann window
+ * @GSTBT_GRAIN_SYN_WINDOW_BLACKMAN: blackman window
+ *
+ * Window shapes for the grains.
+ */
+typedef enum
+{
+  GSTBT_GRAIN_SYN_WINDOW_TRIANGLE = 0,
+  GSTBT_GRAIN_SYN_WINDOW_HANN,
+  GSTBT_GRAIN_SYN_WINDOW_BLACKMAN
+} GstBtGrainSynWindow;
+
+#define GSTBT_GRAIN_SYN_NUM_WINDOWS 3
+
+/* maximum number of grains that play at the same time */
+#define GSTBT_GRAIN_SYN_MAX_GRAINS 256
+
+typedef struct _GstBtGrainSyn GstBtGrainSyn;
+typedef struct _GstBtGrainSynClass GstBtGrainSynClass;
+typedef struct _GstBtGrainSynGrain GstBtGrainSynGrain;
+
+struct _GstBtGrainSynGrain
+{
+  guint64 pos;                  /* next frame to read from the wave */
+  guint length, done;           /* grain length and frames played, in frames */
+  guint delay;                  /* frames to skip in the current block */
+  guint32 phase, step;          /* window position as 0.32 fixed point */
+  gfloat volume;
+};
+
+/**
+ * GstBtGrainSyn:
+ *
+ * Class instance data.
+ */
+struct _GstBtGrainSyn
+{
+  GstBtAudioSynth parent;
+
+  /* < private > */
+  gboolean dispose_has_run;     /* validate if dispose has run */
+
+  /* parameters */
+  GstBtNote note;
+  guint note_length;
+  gdouble grain_size, density, spread;
+  guint extra_grains;
+  gdouble volume, extra_volume;
+  GstBtGrainSynWindow window;
+
+  GstBtToneConversion *n2f;
+  GstBtOscWave *osc;
+
+  /* note state */
+  gboolean playing;
+  guint64 duration;             /* wave length in frames at the note pitch */
+  guint64 note_pos, note_frames;
+  gdouble next_grain;           /* frames until the next grain starts */
+  guint32 seed;
+
+  /* grain pool, the active grains are at the front */
+  GstBtGrainSynGrain grains[GSTBT_GRAIN_SYN_MAX_GRAINS];
+  guint num_grains;
+
+  /* mix buffers for one block */
+  gfloat *mix, *gain;
+  gint16 *scratch;
+  gint mix_channels;
+};
+
+struct _GstBtGrainSynClass
+{
+  GstBtAudioSynthClass parent_class;
+};
+
+GType gstbt_grain_syn_get_type (void);
+GType gstbt_grain_syn_window_get_type (void);
+
+G_END_DECLS
+#endif /* __GSTBT_GRAIN_SYN_H__ */
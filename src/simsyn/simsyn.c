@@ -50,6 +50,7 @@ enum
 {
   // static class properties
   PROP_TUNING = 1,
+  PROP_CURVE,
   // dynamic class properties
   PROP_NOTE,
   PROP_WAVE,
@@ -113,14 +114,18 @@ gstbt_sim_syn_set_property (GObject * object, guint prop_id,
     case PROP_TUNING:
       g_object_set_property ((GObject *) (src->n2f), "tuning", value);
       break;
+    case PROP_CURVE:
+      g_object_set_property ((GObject *) (src->volenv), "curve", value);
+      break;
     case PROP_NOTE:
       if ((src->note = g_value_get_enum (value))) {
         GST_DEBUG ("new note -> '%d'", src->note);
         gdouble freq =
             gstbt_tone_conversion_translate_from_number (src->n2f, src->note);
+        // set the frequency first, the osc only glides if a note is sounding
+        g_object_set (src->osc, "frequency", freq, NULL);
         gstbt_envelope_d_setup (src->volenv,
             ((GstBtAudioSynth *) src)->samplerate, src->decay, src->volume);
-        g_object_set (src->osc, "frequency", freq, NULL);
       }
       break;
     case PROP_WAVE:
@@ -156,6 +161,9 @@ gstbt_sim_syn_get_property (GObject * object, guint prop_id,
     case PROP_TUNING:
       g_object_get_property ((GObject *) (src->n2f), "tuning", value);
       break;
+    case PROP_CURVE:
+      g_object_get_property ((GObject *) (src->volenv), "curve", value);
+      break;
     case PROP_WAVE:
       g_object_get_property ((GObject *) (src->osc), "wave", value);
       break;
@@ -246,6 +254,12 @@ gstbt_sim_syn_class_init (GstBtSimSynClass * klass)
           GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_CURVE,
+      g_param_spec_double ("curve", "Curve",
+          "Curvature of the volume decay (0.0 for linear, > 0.0 for "
+          "exponential, < 0.0 for logarithmic)", -10.0, 10.0, 0.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_NOTE,
       g_param_spec_enum ("note", "Musical note",
           "Musical note (e.g. 'c-3', 'd#4')", GSTBT_TYPE_NOTE, GSTBT_NOTE_NONE,
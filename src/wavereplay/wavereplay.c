@@ -24,6 +24,12 @@
  * Plays wavetable assets pre-loaded by the application. Unlike in tracker
  * machines, the wave is implicitly triggered at the start and one can seek in
  * the song without loosing the audio.
+ *
+ * Long waves such as complete stems can be streamed from the wave cache by
+ * enabling #GstBtWaveReplay:streaming. The read position follows the buffer
+ * timestamps, after a seek the audio starts as soon as the prefetch has caught
+ * up. The element is silent until the stream has been opened. If reading the
+ * stream fails, a warning is posted on the bus and the rest stays silent.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -41,6 +47,7 @@ enum
 {
   // static class properties
   PROP_WAVE_CALLBACKS = 1,
+  PROP_STREAMING,
   // dynamic class properties
   PROP_WAVE,
   PROP_WAVE_LEVEL
@@ -82,7 +89,15 @@ gstbt_wave_replay_process (GstBtAudioSynth * base, GstBuffer * data,
     guint64 off = gst_util_uint64_scale_round (GST_BUFFER_TIMESTAMP (data),
         base->samplerate, GST_SECOND);
 
-    return src->osc->process (src->osc, off, ct, d);
+    gboolean res;
+    gint err;
+
+    res = src->osc->process (src->osc, off, ct, d);
+    if (G_UNLIKELY ((err = gstbt_osc_wave_take_stream_error (src->osc)))) {
+      GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+          ("reading the streamed wave failed: %s", g_strerror (err)));
+    }
+    return res;
   }
   return FALSE;
 }
@@ -102,6 +117,7 @@ gstbt_wave_replay_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_WAVE_CALLBACKS:
+    case PROP_STREAMING:
     case PROP_WAVE:
     case PROP_WAVE_LEVEL:
       g_object_set_property ((GObject *) (src->osc), pspec->name, value);
@@ -123,6 +139,7 @@ gstbt_wave_replay_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_WAVE_CALLBACKS:
+    case PROP_STREAMING:
     case PROP_WAVE:
     case PROP_WAVE_LEVEL:
       g_object_get_property ((GObject *) (src->osc), pspec->name, value);
@@ -187,6 +204,11 @@ gstbt_wave_replay_class_init (GstBtWaveReplayClass * klass)
           "The wave-table access callbacks",
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_STREAMING,
+      g_param_spec_boolean ("streaming", "Streaming",
+          "Read the wave from the wave cache while playing instead of keeping "
+          "it in memory", FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   pspec = g_param_spec_uint ("wave", "Wave", "Wave index", 1, 200, 1,
       G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS);
   g_param_spec_set_qdata (pspec, gstbt_property_meta_quark,
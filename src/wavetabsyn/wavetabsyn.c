@@ -24,24 +24,45 @@
  * A synth that uses the wavetable osc. I picks a cycle from the selected
  * wavetable entry and repeats it as a osc. The offset parameter allows scanning
  * though the waveform.
+ *
+ * The synth is polyphonic. Each voice is a #GstBtWaveTabSynV child and the
+ * number of voices is set with the #GstBtChildBin:children property. A note
+ * set on the synth is played on a free voice. If all voices are playing, the
+ * #GstBtWaveTabSyn:voice-stealing property selects the voice that is
+ * restarted. Notes can also be set on a voice directly (e.g. "voice0::note").
+ * All voices are mixed into the same output buffer. Each voice is scaled by
+ * #GstBtWaveTabSyn:volume, thus a note is equally loud no matter how many
+ * voices there are. When several voices play at once, lower the volume to
+ * leave headroom, as the mix is clipped.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <stdio.h>
 #include <string.h>
+#include <libgstbuzztrax/childbin.h>
 #include <libgstbuzztrax/propertymeta.h>
 #include "wavetabsyn.h"
 
 #define GST_CAT_DEFAULT wave_tab_syn_debug
-GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
+
+/* frames per mixing block */
+#define BLOCK_SIZE 256
 
 enum
 {
   // static class properties
-  PROP_WAVE_CALLBACKS = 1,
+  PROP_CHILDREN = 1,
+  PROP_WAVE_CALLBACKS,
   PROP_TUNING,
+  PROP_INTERPOLATION,
+  PROP_MIPMAPS,
+  PROP_MIP_CROSSFADE,
+  PROP_VOICE_STEALING,
+  PROP_CURVE,
   // dynamic class properties
   PROP_NOTE,
   PROP_NOTE_LENGTH,
@@ -51,16 +72,161 @@ enum
   PROP_PEAK_VOLUME,
   PROP_DECAY,
   PROP_SUSTAIN_VOLUME,
-  PROP_RELEASE
+  PROP_RELEASE,
+  PROP_VOLUME
 };
 
-#define INNER_LOOP 64
-
 //-- the class
 
+static void gstbt_wave_tab_syn_child_proxy_interface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gstbt_wave_tab_syn_child_bin_interface_init (gpointer g_iface,
+    gpointer iface_data);
+
 G_DEFINE_TYPE_WITH_CODE (GstBtWaveTabSyn, gstbt_wave_tab_syn,
     GSTBT_TYPE_AUDIO_SYNTH, G_IMPLEMENT_INTERFACE (GSTBT_TYPE_PROPERTY_META,
-        NULL));
+        NULL)
+    G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY,
+        gstbt_wave_tab_syn_child_proxy_interface_init)
+    G_IMPLEMENT_INTERFACE (GSTBT_TYPE_CHILD_BIN,
+        gstbt_wave_tab_syn_child_bin_interface_init));
+
+//-- enums
+
+GType
+gstbt_wave_tab_syn_voice_stealing_get_type (void)
+{
+  static GType type = 0;
+  static const GEnumValue enums[] = {
+    {GSTBT_WAVE_TAB_SYN_STEAL_OLDEST, "Oldest", "oldest"},
+    {GSTBT_WAVE_TAB_SYN_STEAL_QUIETEST, "Quietest", "quietest"},
+    {0, NULL, NULL},
+  };
+
+  if (G_UNLIKELY (!type)) {
+    type = g_enum_register_static ("GstBtWaveTabSynVoiceStealing", enums);
+  }
+  return type;
+}
+
+//-- helper
+
+static GstBtWaveTabSynV *
+gstbt_wave_tab_syn_new_voice (GstBtWaveTabSyn * src)
+{
+  gchar name[20];
+
+  // voices are always removed from the end, the index is unique
+  sprintf (name, "voice%u", src->num_voices);
+  return (GstBtWaveTabSynV *) g_object_new (GSTBT_TYPE_WAVE_TAB_SYN_V, "name",
+      name, NULL);
+}
+
+/* pick a free voice, or steal one if all are playing */
+static GstBtWaveTabSynV *
+gstbt_wave_tab_syn_alloc_voice (GstBtWaveTabSyn * src)
+{
+  GstBtWaveTabSynV *v, *res = NULL;
+  GList *node;
+
+  for (node = src->voices; node; node = g_list_next (node)) {
+    v = (GstBtWaveTabSynV *) node->data;
+    if (!gstbt_wave_tab_syn_v_is_active (v)) {
+      return v;
+    }
+    if (!res) {
+      res = v;
+    } else if (src->stealing == GSTBT_WAVE_TAB_SYN_STEAL_QUIETEST) {
+      if (((GstBtEnvelope *) v->volenv)->value <
+          ((GstBtEnvelope *) res->volenv)->value)
+        res = v;
+    } else {
+      if (v->age < res->age)
+        res = v;
+    }
+  }
+  GST_DEBUG_OBJECT (src, "stealing %" GST_PTR_FORMAT, res);
+  return res;
+}
+
+/* take a reference to all voices, so that their oscillators can be used
+ * without the object lock */
+static GList *
+gstbt_wave_tab_syn_ref_voices (GstBtWaveTabSyn * src)
+{
+  GList *voices;
+
+  GST_OBJECT_LOCK (src);
+  voices = g_list_copy_deep (src->voices, (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (src);
+  return voices;
+}
+
+/* start the note that has been queued on @voice, the oscillator is tuned
+ * when the cycle is rendered, must be called with the object lock held */
+static void
+gstbt_wave_tab_syn_begin_note (GstBtWaveTabSyn * src, GstBtWaveTabSynV * voice)
+{
+  GstBtAudioSynth *base = (GstBtAudioSynth *) src;
+  gdouble note_time =
+      (gdouble) (src->note_length * base->ticktime) / (gdouble) GST_SECOND;
+
+  GST_DEBUG_OBJECT (voice, "new note -> '%d'", voice->pending);
+  voice->pending = GSTBT_NOTE_NONE;
+  voice->retune = TRUE;
+
+  // this is the chunk that we need to repeat for the selected tone
+  voice->cycle_size = base->samplerate / voice->freq;
+  voice->cycle_pos = 0;
+  voice->cycle_valid = FALSE;
+
+  gstbt_envelope_adsr_setup (voice->volenv, base->samplerate, src->attack,
+      src->decay, note_time, src->release, src->peak_volume,
+      src->sustain_volume);
+}
+
+/* apply the parameters of @from to the oscillator of a new voice */
+static void
+gstbt_wave_tab_syn_copy_osc (GstBtOscWave * from, GstBtOscWave * to)
+{
+  gpointer wave_callbacks;
+  GstBtOscWaveInterpolation interpolation;
+  gboolean mipmaps, mip_crossfade;
+  guint wave;
+
+  g_object_get (from, "wave-callbacks", &wave_callbacks, "interpolation",
+      &interpolation, "mipmaps", &mipmaps, "mip-crossfade", &mip_crossfade,
+      "wave", &wave, NULL);
+  g_object_set (to, "wave-callbacks", wave_callbacks, "interpolation",
+      interpolation, "mipmaps", mipmaps, "mip-crossfade", mip_crossfade,
+      "wave", wave, NULL);
+}
+
+//-- public methods
+
+/**
+ * gstbt_wave_tab_syn_start_voice:
+ * @src: the synth
+ * @voice: one of the voices of @src
+ * @note: the note to play
+ *
+ * Queue @note on @voice. The note starts with the next buffer, using the
+ * envelope and note length parameters of the synth at that time. Must be
+ * called with the object lock of @src held.
+ */
+void
+gstbt_wave_tab_syn_start_voice (GstBtWaveTabSyn * src, GstBtWaveTabSynV * voice,
+    GstBtNote note)
+{
+  gdouble freq = gstbt_tone_conversion_translate_from_number (src->n2f, note);
+
+  if (freq <= 0.0)
+    return;
+
+  voice->pending = note;
+  voice->freq = freq;
+  voice->age = ++src->voice_age;
+}
 
 //-- audiosynth vmethods
 
@@ -69,9 +235,18 @@ gstbt_wave_tab_syn_setup (GstBtAudioSynth * base, GstPad * pad, GstCaps * caps)
 {
   GstBtWaveTabSyn *src = ((GstBtWaveTabSyn *) base);
   GstStructure *structure;
-  gint i, n = gst_caps_get_size (caps), c = src->osc->channels;
+  GList *node, *voices;
+  gint i, n = gst_caps_get_size (caps), c = 1;
 
-  gstbt_osc_wave_setup (src->osc);
+  // binding the wave calls into the application, don't hold the lock
+  voices = gstbt_wave_tab_syn_ref_voices (src);
+  for (node = voices; node; node = g_list_next (node)) {
+    gstbt_osc_wave_setup (((GstBtWaveTabSynV *) node->data)->osc);
+  }
+  if (voices) {
+    c = ((GstBtWaveTabSynV *) voices->data)->osc->channels;
+  }
+  g_list_free_full (voices, (GDestroyNotify) gst_object_unref);
 
   for (i = 0; i < n; i++) {
     structure = gst_caps_get_structure (caps, i);
@@ -85,74 +260,191 @@ gstbt_wave_tab_syn_process (GstBtAudioSynth * base, GstBuffer * data,
     GstMapInfo * info)
 {
   GstBtWaveTabSyn *src = ((GstBtWaveTabSyn *) base);
+  gint16 *d = (gint16 *) info->data;
+  guint n = base->generate_samples_per_buffer;
+  gint ch = base->channels;
+  GstBtWaveTabSynV *v;
+  GList *node, *voices = NULL;
+  gint32 *mix;
+  guint i, ct, ns, offset;
+  gdouble gain;
+  gboolean has_wave = FALSE;
+
+  if (src->mix_channels != ch) {
+    src->mix = g_renew (gint32, src->mix, BLOCK_SIZE * ch);
+    src->mix_channels = ch;
+  }
+  mix = src->mix;
+
+  // setting the note of a voice takes the lock
+  for (i = 0; i < src->num_voices; i++) {
+    if ((v = (GstBtWaveTabSynV *)
+            gst_child_proxy_get_child_by_index ((GstChildProxy *) src, i))) {
+      gst_object_sync_values ((GstObject *) v, GST_BUFFER_TIMESTAMP (data));
+      gst_object_unref (v);
+    }
+  }
 
-  if (src->osc->process) {
-    gint16 *d = (gint16 *) info->data;
-    guint ct = ((GstBtAudioSynth *) src)->generate_samples_per_buffer;
-    gint ch = ((GstBtAudioSynth *) src)->channels;
-    guint sz = src->cycle_size;
-    guint pos = src->cycle_pos;
-    guint p = 0;
-    guint64 off = src->offset * (src->duration - src->cycle_size) / 0xFFFF;
-
-    // do we have a unfinished cycle?
-    if (pos > 0) {
-      guint new_pos;
-      p = sz - pos;
-      if (p > ct) {
-        p = ct;
-        new_pos = pos + ct;
-      } else {
-        new_pos = 0;
+  // start the queued notes
+  GST_OBJECT_LOCK (src);
+  for (node = src->voices; node; node = g_list_next (node)) {
+    v = (GstBtWaveTabSynV *) node->data;
+    if (v->pending)
+      gstbt_wave_tab_syn_begin_note (src, v);
+    // the wave could have changed, render the cycle again
+    v->cycle_valid = FALSE;
+    voices = g_list_prepend (voices, gst_object_ref (v));
+  }
+  offset = src->offset;
+  GST_OBJECT_UNLOCK (src);
+
+  // the oscillators might fetch the wave from the application, thus the
+  // cycles are rendered without the lock
+  for (node = voices; node; node = g_list_next (node)) {
+    v = (GstBtWaveTabSynV *) node->data;
+    if (gstbt_wave_tab_syn_v_is_active (v))
+      gstbt_wave_tab_syn_v_render_cycle (v, offset, ch);
+    if (v->osc->process)
+      has_wave = TRUE;
+  }
+  g_list_free_full (voices, (GDestroyNotify) gst_object_unref);
+  if (!has_wave)
+    return FALSE;
+
+  GST_OBJECT_LOCK (src);
+  gain = src->volume;
+  while (n) {
+    ct = MIN (n, BLOCK_SIZE);
+    ns = ct * ch;
+    memset (mix, 0, ns * sizeof (gint32));
+    for (node = src->voices; node; node = g_list_next (node)) {
+      v = (GstBtWaveTabSynV *) node->data;
+      if (gstbt_wave_tab_syn_v_is_active (v)) {
+        gstbt_wave_tab_syn_v_process (v, ct, ch, mix);
       }
-      src->osc->process (src->osc, off + pos, p, &d[0]);
-      ct -= p;
-      pos = new_pos;
-    }
-    // do full cycles
-    while (ct >= sz) {
-      src->osc->process (src->osc, off, sz, &d[p * ch]);
-      ct -= sz;
-      p += sz;
     }
-    // fill buffer with partial cycle
-    if (ct > 0) {
-      src->osc->process (src->osc, off, ct, &d[p * ch]);
-      pos += ct;
+    for (i = 0; i < ns; i++) {
+      d[i] = (gint16) CLAMP ((gint32) (mix[i] * gain), G_MININT16,
+          G_MAXINT16);
     }
-    src->cycle_pos = pos;
-    // apply volume envelope
-    ct = ((GstBtAudioSynth *) src)->generate_samples_per_buffer;
-    if (ch == 1) {
-      gdouble amp;
-      guint i = 0, j;
-      while (i < ct) {
-        j = ct - i;
-        amp = gstbt_envelope_get ((GstBtEnvelope *) src->volenv,
-            MIN (INNER_LOOP, j));
-        for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-          d[i] *= amp;
-        }
-      }
-    } else if (ch == 2) {
-      gdouble amp;
-      guint i = 0, j;
-      while (i < ct) {
-        j = ct - i;
-        amp = gstbt_envelope_get ((GstBtEnvelope *) src->volenv,
-            MIN (INNER_LOOP, j));
-        for (j = 0; ((j < INNER_LOOP) && (i < ct)); j++, i++) {
-          d[(i << 1)] *= amp;
-          d[(i << 1) + 1] *= amp;
-        }
-      }
-    }
-    return TRUE;
+    d += ns;
+    n -= ct;
   }
-  return FALSE;
+  GST_OBJECT_UNLOCK (src);
+  return TRUE;
 }
 
-//-- interfaces
+//-- child proxy interface
+
+static GObject *
+gstbt_wave_tab_syn_child_proxy_get_child_by_index (GstChildProxy * child_proxy,
+    guint index)
+{
+  GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (child_proxy);
+  GObject *res = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (index < src->num_voices)
+    res = gst_object_ref (g_list_nth_data (src->voices, index));
+  GST_OBJECT_UNLOCK (src);
+  return res;
+}
+
+static guint
+gstbt_wave_tab_syn_child_proxy_get_children_count (GstChildProxy * child_proxy)
+{
+  GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (child_proxy);
+
+  return src->num_voices;
+}
+
+static void
+gstbt_wave_tab_syn_child_proxy_interface_init (gpointer g_iface,
+    gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  GST_INFO ("initializing iface");
+
+  iface->get_child_by_index = gstbt_wave_tab_syn_child_proxy_get_child_by_index;
+  iface->get_children_count = gstbt_wave_tab_syn_child_proxy_get_children_count;
+}
+
+//-- child bin interface
+
+static gboolean
+gstbt_wave_tab_syn_child_bin_add_child (GstBtChildBin * child_bin,
+    GstObject * child)
+{
+  GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (child_bin);
+  GstBtWaveTabSynV *voice;
+  GstBtOscWave *osc = NULL;
+
+  g_return_val_if_fail (GSTBT_IS_WAVE_TAB_SYN_V (child), FALSE);
+  voice = (GstBtWaveTabSynV *) child;
+
+  if (!gst_object_set_parent (child, (GstObject *) src)) {
+    GST_WARNING_OBJECT (src, "voice %" GST_PTR_FORMAT " already has a parent",
+        child);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  if (src->voices) {
+    osc = g_object_ref (((GstBtWaveTabSynV *) src->voices->data)->osc);
+  }
+  GST_OBJECT_UNLOCK (src);
+  if (osc) {
+    gstbt_wave_tab_syn_copy_osc (osc, voice->osc);
+    g_object_unref (osc);
+  }
+  g_object_set (voice->volenv, "curve", src->curve, NULL);
+
+  GST_OBJECT_LOCK (src);
+  src->voices = g_list_append (src->voices, voice);
+  src->num_voices++;
+  GST_OBJECT_UNLOCK (src);
+
+  gst_child_proxy_child_added ((GstChildProxy *) src, (GObject *) child,
+      GST_OBJECT_NAME (child));
+  g_object_notify ((GObject *) src, "children");
+  return TRUE;
+}
+
+static gboolean
+gstbt_wave_tab_syn_child_bin_remove_child (GstBtChildBin * child_bin,
+    GstObject * child)
+{
+  GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (child_bin);
+  GList *node;
+
+  GST_OBJECT_LOCK (src);
+  if (!(node = g_list_find (src->voices, child))) {
+    GST_OBJECT_UNLOCK (src);
+    return FALSE;
+  }
+  src->voices = g_list_delete_link (src->voices, node);
+  src->num_voices--;
+  GST_OBJECT_UNLOCK (src);
+
+  gst_child_proxy_child_removed ((GstChildProxy *) src, (GObject *) child,
+      GST_OBJECT_NAME (child));
+  gst_object_unparent (child);
+  g_object_notify ((GObject *) src, "children");
+  return TRUE;
+}
+
+static void
+gstbt_wave_tab_syn_child_bin_interface_init (gpointer g_iface,
+    gpointer iface_data)
+{
+  GstBtChildBinInterface *iface = g_iface;
+
+  GST_INFO ("initializing iface");
+
+  iface->add_child = gstbt_wave_tab_syn_child_bin_add_child;
+  iface->remove_child = gstbt_wave_tab_syn_child_bin_remove_child;
+}
 
 //-- gobject vmethods
 
@@ -166,32 +458,64 @@ gstbt_wave_tab_syn_set_property (GObject * object, guint prop_id,
     return;
 
   switch (prop_id) {
+    case PROP_CHILDREN:{
+      gulong children = g_value_get_ulong (value);
+
+      while (src->num_voices < children) {
+        gstbt_child_bin_add_child ((GstBtChildBin *) src,
+            (GstObject *) gstbt_wave_tab_syn_new_voice (src));
+      }
+      while (src->num_voices > children) {
+        GstObject *voice;
+
+        GST_OBJECT_LOCK (src);
+        voice = gst_object_ref (g_list_last (src->voices)->data);
+        GST_OBJECT_UNLOCK (src);
+        gstbt_child_bin_remove_child ((GstBtChildBin *) src, voice);
+        gst_object_unref (voice);
+      }
+      break;
+    }
     case PROP_WAVE_CALLBACKS:
-    case PROP_WAVE:
-      g_object_set_property ((GObject *) (src->osc), pspec->name, value);
+    case PROP_INTERPOLATION:
+    case PROP_MIPMAPS:
+    case PROP_MIP_CROSSFADE:
+    case PROP_WAVE:{
+      GList *node, *voices = gstbt_wave_tab_syn_ref_voices (src);
+
+      for (node = voices; node; node = g_list_next (node)) {
+        g_object_set_property ((GObject *) ((GstBtWaveTabSynV *) node->
+                data)->osc, pspec->name, value);
+      }
+      g_list_free_full (voices, (GDestroyNotify) gst_object_unref);
       break;
+    }
     case PROP_TUNING:
       g_object_set_property ((GObject *) (src->n2f), "tuning", value);
       break;
+    case PROP_VOICE_STEALING:
+      src->stealing = g_value_get_enum (value);
+      break;
+    case PROP_CURVE:{
+      GList *node, *voices = gstbt_wave_tab_syn_ref_voices (src);
+
+      src->curve = g_value_get_double (value);
+      for (node = voices; node; node = g_list_next (node)) {
+        g_object_set_property ((GObject *) ((GstBtWaveTabSynV *) node->
+                data)->volenv, "curve", value);
+      }
+      g_list_free_full (voices, (GDestroyNotify) gst_object_unref);
+      break;
+    }
     case PROP_NOTE:
       if ((src->note = g_value_get_enum (value))) {
-        GST_DEBUG ("new note -> '%d'", src->note);
-        gdouble freq =
-            gstbt_tone_conversion_translate_from_number (src->n2f, src->note);
-        gdouble note_time =
-            (gdouble) (src->note_length * ((GstBtAudioSynth *) src)->ticktime) /
-            (gdouble) GST_SECOND;
-
-        g_object_set (src->osc, "frequency", freq, NULL);
-        g_object_get (src->osc, "duration", &src->duration, NULL);
-
-        // this is the chunk that we need to repeat for the selected tone
-        src->cycle_size = ((GstBtAudioSynth *) src)->samplerate / freq;
-        src->cycle_pos = 0;
-
-        gstbt_envelope_adsr_setup (src->volenv,
-            ((GstBtAudioSynth *) src)->samplerate, src->attack, src->decay,
-            note_time, src->release, src->peak_volume, src->sustain_volume);
+        GstBtWaveTabSynV *voice;
+
+        GST_OBJECT_LOCK (src);
+        if ((voice = gstbt_wave_tab_syn_alloc_voice (src))) {
+          gstbt_wave_tab_syn_start_voice (src, voice, src->note);
+        }
+        GST_OBJECT_UNLOCK (src);
       }
       break;
     case PROP_NOTE_LENGTH:
@@ -215,6 +539,9 @@ gstbt_wave_tab_syn_set_property (GObject * object, guint prop_id,
     case PROP_RELEASE:
       src->release = g_value_get_double (value);
       break;
+    case PROP_VOLUME:
+      src->volume = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -231,13 +558,36 @@ gstbt_wave_tab_syn_get_property (GObject * object, guint prop_id,
     return;
 
   switch (prop_id) {
+    case PROP_CHILDREN:
+      g_value_set_ulong (value, src->num_voices);
+      break;
     case PROP_WAVE_CALLBACKS:
-    case PROP_WAVE:
-      g_object_get_property ((GObject *) (src->osc), pspec->name, value);
+    case PROP_INTERPOLATION:
+    case PROP_MIPMAPS:
+    case PROP_MIP_CROSSFADE:
+    case PROP_WAVE:{
+      GstBtWaveTabSynV *voice = NULL;
+
+      GST_OBJECT_LOCK (src);
+      if (src->voices) {
+        voice = gst_object_ref (src->voices->data);
+      }
+      GST_OBJECT_UNLOCK (src);
+      if (voice) {
+        g_object_get_property ((GObject *) voice->osc, pspec->name, value);
+        gst_object_unref (voice);
+      }
       break;
+    }
     case PROP_TUNING:
       g_object_get_property ((GObject *) (src->n2f), "tuning", value);
       break;
+    case PROP_VOICE_STEALING:
+      g_value_set_enum (value, src->stealing);
+      break;
+    case PROP_CURVE:
+      g_value_set_double (value, src->curve);
+      break;
     case PROP_NOTE_LENGTH:
       g_value_set_uint (value, src->note_length);
       break;
@@ -259,6 +609,9 @@ gstbt_wave_tab_syn_get_property (GObject * object, guint prop_id,
     case PROP_RELEASE:
       g_value_set_double (value, src->release);
       break;
+    case PROP_VOLUME:
+      g_value_set_double (value, src->volume);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -269,6 +622,7 @@ static void
 gstbt_wave_tab_syn_dispose (GObject * object)
 {
   GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (object);
+  GList *node;
 
   if (src->dispose_has_run)
     return;
@@ -276,14 +630,26 @@ gstbt_wave_tab_syn_dispose (GObject * object)
 
   if (src->n2f)
     g_object_unref (src->n2f);
-  if (src->osc)
-    g_object_unref (src->osc);
-  if (src->volenv)
-    g_object_unref (src->volenv);
+  for (node = src->voices; node; node = g_list_next (node)) {
+    gst_object_unparent ((GstObject *) node->data);
+  }
+  g_list_free (src->voices);
+  src->voices = NULL;
+  src->num_voices = 0;
 
   G_OBJECT_CLASS (gstbt_wave_tab_syn_parent_class)->dispose (object);
 }
 
+static void
+gstbt_wave_tab_syn_finalize (GObject * object)
+{
+  GstBtWaveTabSyn *src = GSTBT_WAVE_TAB_SYN (object);
+
+  g_free (src->mix);
+
+  G_OBJECT_CLASS (gstbt_wave_tab_syn_parent_class)->finalize (object);
+}
+
 //-- gobject type methods
 
 static void
@@ -296,13 +662,14 @@ gstbt_wave_tab_syn_init (GstBtWaveTabSyn * src)
   src->decay = 0.5;
   src->sustain_volume = 0.4;
   src->release = 0.5;
+  src->volume = 1.0;
 
   src->n2f =
       gstbt_tone_conversion_new (GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
 
   /* synth components */
-  src->osc = gstbt_osc_wave_new ();
-  src->volenv = gstbt_envelope_adsr_new ();
+  gstbt_child_bin_add_child ((GstBtChildBin *) src,
+      (GstObject *) gstbt_wave_tab_syn_new_voice (src));
 }
 
 static void
@@ -319,6 +686,7 @@ gstbt_wave_tab_syn_class_init (GstBtWaveTabSynClass * klass)
   gobject_class->set_property = gstbt_wave_tab_syn_set_property;
   gobject_class->get_property = gstbt_wave_tab_syn_get_property;
   gobject_class->dispose = gstbt_wave_tab_syn_dispose;
+  gobject_class->finalize = gstbt_wave_tab_syn_finalize;
 
   // describe us
   gst_element_class_set_static_metadata (element_class,
@@ -329,6 +697,9 @@ gstbt_wave_tab_syn_class_init (GstBtWaveTabSynClass * klass)
       "file://" DATADIR "" G_DIR_SEPARATOR_S "gtk-doc" G_DIR_SEPARATOR_S "html"
       G_DIR_SEPARATOR_S "" PACKAGE "" G_DIR_SEPARATOR_S "GstBtWaveTabSyn.html");
 
+  // override interface properties
+  g_object_class_override_property (gobject_class, PROP_CHILDREN, "children");
+
   // register own properties
   g_object_class_install_property (gobject_class, PROP_WAVE_CALLBACKS,
       g_param_spec_pointer ("wave-callbacks", "Wavetable Callbacks",
@@ -341,6 +712,36 @@ gstbt_wave_tab_syn_class_init (GstBtWaveTabSynClass * klass)
           GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation mode for playing the wave at a different pitch",
+          GSTBT_TYPE_OSC_WAVE_INTERPOLATION,
+          GSTBT_OSC_WAVE_INTERPOLATION_LINEAR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIPMAPS,
+      g_param_spec_boolean ("mipmaps", "Mipmaps",
+          "Use band-limited copies of the wave when playing at a higher pitch",
+          TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MIP_CROSSFADE,
+      g_param_spec_boolean ("mip-crossfade", "Mip crossfade",
+          "Crossfade between the two closest band-limited copies", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOICE_STEALING,
+      g_param_spec_enum ("voice-stealing", "Voice stealing",
+          "Which voice to restart when all voices are playing",
+          GSTBT_TYPE_WAVE_TAB_SYN_VOICE_STEALING,
+          GSTBT_WAVE_TAB_SYN_STEAL_OLDEST,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CURVE,
+      g_param_spec_double ("curve", "Curve",
+          "Curvature of the volume envelope segments (0.0 for linear, > 0.0 "
+          "for exponential, < 0.0 for logarithmic)", -10.0, 10.0, 0.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_NOTE,
       g_param_spec_enum ("note", "Musical note",
           "Musical note (e.g. 'c-3', 'd#4')", GSTBT_TYPE_NOTE, GSTBT_NOTE_NONE,
@@ -387,6 +788,11 @@ gstbt_wave_tab_syn_class_init (GstBtWaveTabSynClass * klass)
       g_param_spec_double ("release", "RELEASE",
           "Volume release of the tone in seconds", 0.001, 4.0, 0.5,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOLUME,
+      g_param_spec_double ("volume", "Volume", "Volume of each voice",
+          0.0, 1.0, 1.0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 }
 
 //-- plugin
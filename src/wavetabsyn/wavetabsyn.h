@@ -22,10 +22,10 @@
 
 #include <gst/gst.h>
 #include <libgstbuzztrax/audiosynth.h>
-#include <libgstbuzztrax/envelope-adsr.h>
-#include <libgstbuzztrax/osc-wave.h>
 #include <libgstbuzztrax/toneconversion.h>
 
+#include "wavetabsynv.h"
+
 G_BEGIN_DECLS
 
 #define GSTBT_TYPE_WAVE_TAB_SYN            (gstbt_wave_tab_syn_get_type())
@@ -35,6 +35,22 @@ G_BEGIN_DECLS
 #define GSTBT_IS_WAVE_TAB_SYN_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_WAVE_TAB_SYN))
 #define GSTBT_WAVE_TAB_SYN_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_WAVE_TAB_SYN,GstBtWaveTabSynClass))
 
+#define GSTBT_TYPE_WAVE_TAB_SYN_VOICE_STEALING (gstbt_wave_tab_syn_voice_stealing_get_type())
+
+/**
+ * GstBtWaveTabSynVoiceStealing:
+ * @GSTBT_WAVE_TAB_SYN_STEAL_OLDEST: restart the voice that was started first
+ * @GSTBT_WAVE_TAB_SYN_STEAL_QUIETEST: restart the voice with the lowest
+ *   envelope level
+ *
+ * Which voice to reuse for a new note when all voices are playing.
+ */
+typedef enum
+{
+  GSTBT_WAVE_TAB_SYN_STEAL_OLDEST = 0,
+  GSTBT_WAVE_TAB_SYN_STEAL_QUIETEST
+} GstBtWaveTabSynVoiceStealing;
+
 typedef struct _GstBtWaveTabSyn GstBtWaveTabSyn;
 typedef struct _GstBtWaveTabSynClass GstBtWaveTabSynClass;
 
@@ -54,12 +70,21 @@ struct _GstBtWaveTabSyn
   GstBtNote note;
   guint note_length, offset;
   gdouble attack, decay, release, peak_volume, sustain_volume;
+  gdouble volume;
+
+  GstBtWaveTabSynVoiceStealing stealing;
+  gdouble curve;
 
-  guint cycle_pos, cycle_size;
-  guint64 duration;
   GstBtToneConversion *n2f;
-  GstBtEnvelopeADSR *volenv;
-  GstBtOscWave *osc;
+
+  /* voices, protected by the object lock */
+  GList *voices;
+  guint num_voices;
+  guint64 voice_age;
+
+  /* mix buffer for one block */
+  gint32 *mix;
+  gint mix_channels;
 };
 
 struct _GstBtWaveTabSynClass
@@ -68,6 +93,9 @@ struct _GstBtWaveTabSynClass
 };
 
 GType gstbt_wave_tab_syn_get_type (void);
+GType gstbt_wave_tab_syn_voice_stealing_get_type (void);
+
+void gstbt_wave_tab_syn_start_voice (GstBtWaveTabSyn *src, GstBtWaveTabSynV *voice, GstBtNote note);
 
 G_END_DECLS
 #endif /* __GSTBT_WAVE_TAB_SYN_H__ */
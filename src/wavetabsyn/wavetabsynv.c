@@ -0,0 +1,265 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wavetabsynv.c: wavetable synthesizer voice
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * SECTION:wavetabsynv
+ * @title: GstBtWaveTabSynV
+ * @short_description: wavetable synthesizer voice
+ *
+ * A single voice of #GstBtWaveTabSyn with its own oscillator and volume
+ * envelope. Setting the note of a voice plays it on exactly this voice,
+ * bypassing the voice allocation of the synth.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "wavetabsyn.h"
+
+#define GST_CAT_DEFAULT wave_tab_syn_debug
+GST_DEBUG_CATEGORY_EXTERN (GST_CAT_DEFAULT);
+
+/* frames per envelope block */
+#define BLOCK_SIZE 256
+
+enum
+{
+  PROP_NOTE = 1
+};
+
+//-- the class
+
+G_DEFINE_TYPE (GstBtWaveTabSynV, gstbt_wave_tab_syn_v, GST_TYPE_OBJECT);
+
+//-- public methods
+
+/**
+ * gstbt_wave_tab_syn_v_is_active:
+ * @self: the voice
+ *
+ * Checks if the voice is playing a note or has one queued.
+ *
+ * Returns: %TRUE until the volume envelope has ended
+ */
+gboolean
+gstbt_wave_tab_syn_v_is_active (GstBtWaveTabSynV * self)
+{
+  return self->pending ||
+      gstbt_envelope_is_running ((GstBtEnvelope *) self->volenv);
+}
+
+/**
+ * gstbt_wave_tab_syn_v_render_cycle:
+ * @self: the voice
+ * @offset: the wave table offset (0 ... 0xFFFF)
+ * @channels: the number of channels
+ *
+ * Tune the oscillator to the started note and render the selected cycle of
+ * the wave. The cycle is only rendered again if the offset or the note has
+ * changed or the cycle has been invalidated.
+ *
+ * The oscillator might fetch the wave from the wave-table, thus this must be
+ * called without the object lock of the synth held.
+ *
+ * Returns: %FALSE if the oscillator has no wave
+ */
+gboolean
+gstbt_wave_tab_syn_v_render_cycle (GstBtWaveTabSynV * self, guint offset,
+    gint channels)
+{
+  GstBtOscWave *osc = self->osc;
+  const guint sz = self->cycle_size;
+  guint64 off;
+
+  if (self->retune) {
+    g_object_set (osc, "frequency", self->freq, NULL);
+    g_object_get (osc, "duration", &self->duration, NULL);
+    self->retune = FALSE;
+  }
+  if (!osc->process || !sz)
+    return FALSE;
+
+  off = (self->duration > sz) ? offset * (self->duration - sz) / 0xFFFF : 0;
+  if (self->cycle_valid && off == self->cycle_off)
+    return TRUE;
+
+  if (self->cycle_alloc < sz * channels) {
+    self->cycle_alloc = sz * channels;
+    self->cycle = g_renew (gint16, self->cycle, self->cycle_alloc);
+  }
+  if (!osc->process (osc, off, sz, self->cycle)) {
+    memset (self->cycle, 0, sz * channels * sizeof (gint16));
+  }
+  self->cycle_off = off;
+  self->cycle_valid = TRUE;
+  return TRUE;
+}
+
+/**
+ * gstbt_wave_tab_syn_v_process:
+ * @self: the voice
+ * @ct: the number of frames to render
+ * @channels: the number of channels
+ * @mix: interleaved samples to add the voice to
+ *
+ * Render the next @ct frames of the voice and add them to @mix. The cycle
+ * from gstbt_wave_tab_syn_v_render_cycle() is repeated and the volume
+ * envelope is applied.
+ *
+ * Returns: %FALSE if there is no rendered cycle
+ */
+gboolean
+gstbt_wave_tab_syn_v_process (GstBtWaveTabSynV * self, guint ct,
+    gint channels, gint32 * mix)
+{
+  const guint sz = self->cycle_size;
+  guint pos = self->cycle_pos;
+  gdouble amp[BLOCK_SIZE];
+  const gint16 *src;
+  guint i, j, n, run;
+  gint c;
+
+  if (!self->cycle_valid || !sz)
+    return FALSE;
+
+  // repeat the cycle and apply the volume envelope in one pass
+  while (ct) {
+    n = MIN (ct, BLOCK_SIZE);
+    gstbt_envelope_get_block ((GstBtEnvelope *) self->volenv, n, amp);
+    for (i = 0; i < n; i += run) {
+      run = MIN (n - i, sz - pos);
+      src = &self->cycle[pos * channels];
+      if (channels == 1) {
+        for (j = 0; j < run; j++) {
+          mix[j] += (gint32) (src[j] * amp[i + j]);
+        }
+      } else if (channels == 2) {
+        for (j = 0; j < run; j++) {
+          mix[(j << 1)] += (gint32) (src[(j << 1)] * amp[i + j]);
+          mix[(j << 1) + 1] += (gint32) (src[(j << 1) + 1] * amp[i + j]);
+        }
+      } else {
+        for (j = 0; j < run; j++) {
+          for (c = 0; c < channels; c++) {
+            mix[j * channels + c] +=
+                (gint32) (src[j * channels + c] * amp[i + j]);
+          }
+        }
+      }
+      mix += run * channels;
+      pos += run;
+      if (pos == sz)
+        pos = 0;
+    }
+    ct -= n;
+  }
+  self->cycle_pos = pos;
+  return TRUE;
+}
+
+//-- virtual methods
+
+static void
+gstbt_wave_tab_syn_v_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBtWaveTabSynV *self = GSTBT_WAVE_TAB_SYN_V (object);
+  GstObject *parent;
+
+  switch (prop_id) {
+    case PROP_NOTE:
+      if ((self->note = g_value_get_enum (value)) &&
+          (parent = gst_object_get_parent ((GstObject *) self))) {
+        GST_OBJECT_LOCK (parent);
+        gstbt_wave_tab_syn_start_voice ((GstBtWaveTabSyn *) parent, self,
+            self->note);
+        GST_OBJECT_UNLOCK (parent);
+        gst_object_unref (parent);
+      }
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_wave_tab_syn_v_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gstbt_wave_tab_syn_v_dispose (GObject * object)
+{
+  GstBtWaveTabSynV *self = GSTBT_WAVE_TAB_SYN_V (object);
+
+  if (self->osc) {
+    g_object_unref (self->osc);
+    self->osc = NULL;
+  }
+  if (self->volenv) {
+    g_object_unref (self->volenv);
+    self->volenv = NULL;
+  }
+
+  G_OBJECT_CLASS (gstbt_wave_tab_syn_v_parent_class)->dispose (object);
+}
+
+static void
+gstbt_wave_tab_syn_v_finalize (GObject * object)
+{
+  GstBtWaveTabSynV *self = GSTBT_WAVE_TAB_SYN_V (object);
+
+  g_free (self->cycle);
+
+  G_OBJECT_CLASS (gstbt_wave_tab_syn_v_parent_class)->finalize (object);
+}
+
+static void
+gstbt_wave_tab_syn_v_init (GstBtWaveTabSynV * self)
+{
+  self->osc = gstbt_osc_wave_new ();
+  self->volenv = gstbt_envelope_adsr_new ();
+}
+
+static void
+gstbt_wave_tab_syn_v_class_init (GstBtWaveTabSynVClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gstbt_wave_tab_syn_v_set_property;
+  gobject_class->get_property = gstbt_wave_tab_syn_v_get_property;
+  gobject_class->dispose = gstbt_wave_tab_syn_v_dispose;
+  gobject_class->finalize = gstbt_wave_tab_syn_v_finalize;
+
+  // register own properties
+
+  g_object_class_install_property (gobject_class, PROP_NOTE,
+      g_param_spec_enum ("note", "Musical note",
+          "Musical note (e.g. 'c-3', 'd#4')", GSTBT_TYPE_NOTE, GSTBT_NOTE_NONE,
+          G_PARAM_WRITABLE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+}
@@ -0,0 +1,80 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * wavetabsynv.h: wavetable synthesizer voice
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSTBT_WAVE_TAB_SYN_V_H__
+#define __GSTBT_WAVE_TAB_SYN_V_H__
+
+#include <gst/gst.h>
+#include <libgstbuzztrax/envelope-adsr.h>
+#include <libgstbuzztrax/musicenums.h>
+#include <libgstbuzztrax/osc-wave.h>
+
+G_BEGIN_DECLS
+
+#define GSTBT_TYPE_WAVE_TAB_SYN_V            (gstbt_wave_tab_syn_v_get_type())
+#define GSTBT_WAVE_TAB_SYN_V(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GSTBT_TYPE_WAVE_TAB_SYN_V,GstBtWaveTabSynV))
+#define GSTBT_IS_WAVE_TAB_SYN_V(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GSTBT_TYPE_WAVE_TAB_SYN_V))
+#define GSTBT_WAVE_TAB_SYN_V_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GSTBT_TYPE_WAVE_TAB_SYN_V,GstBtWaveTabSynVClass))
+#define GSTBT_IS_WAVE_TAB_SYN_V_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GSTBT_TYPE_WAVE_TAB_SYN_V))
+#define GSTBT_WAVE_TAB_SYN_V_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GSTBT_TYPE_WAVE_TAB_SYN_V,GstBtWaveTabSynVClass))
+
+typedef struct _GstBtWaveTabSynV GstBtWaveTabSynV;
+typedef struct _GstBtWaveTabSynVClass GstBtWaveTabSynVClass;
+
+/**
+ * GstBtWaveTabSynV:
+ *
+ * Class instance data.
+ */
+struct _GstBtWaveTabSynV
+{
+  GstObject parent;
+
+  /* < private > */
+  /* parameters */
+  GstBtNote note;
+
+  /* state */
+  GstBtNote pending;            /* note to start with the next buffer */
+  gdouble freq;                 /* frequency of the started note */
+  gboolean retune;              /* the oscillator needs the new frequency */
+  guint cycle_pos, cycle_size;
+  guint64 duration;
+  gint16 *cycle;                /* the rendered cycle */
+  guint cycle_alloc;            /* allocated samples in cycle */
+  guint64 cycle_off;            /* wave offset of the rendered cycle */
+  gboolean cycle_valid;
+  guint64 age;                  /* when the note was started */
+  GstBtEnvelopeADSR *volenv;
+  GstBtOscWave *osc;
+};
+
+struct _GstBtWaveTabSynVClass
+{
+  GstObjectClass parent_class;
+};
+
+GType gstbt_wave_tab_syn_v_get_type (void);
+
+gboolean gstbt_wave_tab_syn_v_is_active (GstBtWaveTabSynV *self);
+gboolean gstbt_wave_tab_syn_v_render_cycle (GstBtWaveTabSynV *self, guint offset, gint channels);
+gboolean gstbt_wave_tab_syn_v_process (GstBtWaveTabSynV *self, guint ct, gint channels, gint32 *mix);
+
+G_END_DECLS
+#endif /* __GSTBT_WAVE_TAB_SYN_V_H__ */
@@ -27,7 +27,18 @@
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 
 extern Suite *gst_buzztrax_note2frequency_suite (void);
+extern Suite *gst_buzztrax_envelope_suite (void);
 extern Suite *gst_buzztrax_elements_suite (void);
+extern Suite *gst_buzztrax_chorus_suite (void);
+extern Suite *gst_buzztrax_compressor_suite (void);
+extern Suite *gst_buzztrax_grain_syn_suite (void);
+extern Suite *gst_buzztrax_osc_wave_suite (void);
+extern Suite *gst_buzztrax_eq_suite (void);
+extern Suite *gst_buzztrax_fdn_reverb_suite (void);
+extern Suite *gst_buzztrax_conv_reverb_suite (void);
+extern Suite *gst_buzztrax_wave_cache_suite (void);
+extern Suite *gst_buzztrax_wave_stream_suite (void);
+extern Suite *gst_buzztrax_wave_tab_syn_suite (void);
 
 gint test_argc = 1;
 gchar test_arg0[] = "check_gst_buzzard";
@@ -84,6 +95,93 @@ gst_buzztrax_teardown (void)
 {
 }
 
+/* element testing helpers */
+
+static GstFlowReturn
+check_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GList **buffers = gst_pad_get_element_private (pad);
+
+  *buffers = g_list_append (*buffers, buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+check_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    gst_query_set_latency (query, FALSE, 0, GST_CLOCK_TIME_NONE);
+    return TRUE;
+  }
+  return gst_pad_query_default (pad, parent, query);
+}
+
+/* Link test pads to the filter @element, start it and send the stream events
+ * for the @caps string. The buffers that come out of the element are appended
+ * to @buffers. Returns the pad to push the buffers to the element from.
+ */
+GstPad *
+gst_buzztrax_setup_filter (GstElement * element, const gchar * caps,
+    GList ** buffers)
+{
+  GstPad *src, *sink, *pad;
+  GstCaps *c;
+  GstSegment segment;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_set_query_function (src, check_src_query);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, check_sink_chain);
+  gst_pad_set_element_private (sink, buffers);
+
+  pad = gst_element_get_static_pad (element, "sink");
+  fail_unless (gst_pad_link (src, pad) == GST_PAD_LINK_OK, NULL);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (element, "src");
+  fail_unless (gst_pad_link (pad, sink) == GST_PAD_LINK_OK, NULL);
+  gst_object_unref (pad);
+  gst_pad_set_active (src, TRUE);
+  gst_pad_set_active (sink, TRUE);
+  fail_unless (gst_element_set_state (element, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE, NULL);
+
+  fail_unless (gst_pad_push_event (src, gst_event_new_stream_start ("test")),
+      NULL);
+  c = gst_caps_from_string (caps);
+  fail_unless (gst_pad_push_event (src, gst_event_new_caps (c)), NULL);
+  gst_caps_unref (c);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (src, gst_event_new_segment (&segment)),
+      NULL);
+  return src;
+}
+
+/* Stop the filter @element and release the pads and buffers from
+ * gst_buzztrax_setup_filter(). */
+void
+gst_buzztrax_teardown_filter (GstElement * element, GstPad * src,
+    GList ** buffers)
+{
+  GstPad *pad, *sink;
+
+  gst_element_set_state (element, GST_STATE_NULL);
+  pad = gst_element_get_static_pad (element, "sink");
+  gst_pad_unlink (src, pad);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (element, "src");
+  sink = gst_pad_get_peer (pad);
+  gst_pad_unlink (pad, sink);
+  gst_object_unref (pad);
+  gst_pad_set_active (src, FALSE);
+  gst_pad_set_active (sink, FALSE);
+  /* the ref from gst_pad_get_peer() and the one from gst_pad_new() */
+  gst_object_unref (sink);
+  gst_object_unref (sink);
+  gst_object_unref (src);
+  g_list_free_full (*buffers, (GDestroyNotify) gst_buffer_unref);
+  *buffers = NULL;
+}
+
 /* start the test run */
 int
 main (int argc, char **argv)
@@ -102,7 +200,18 @@ main (int argc, char **argv)
   (void) g_log_set_default_handler (check_log_handler, NULL);
 
   sr = srunner_create (gst_buzztrax_note2frequency_suite ());
+  srunner_add_suite (sr, gst_buzztrax_envelope_suite ());
   srunner_add_suite (sr, gst_buzztrax_elements_suite ());
+  srunner_add_suite (sr, gst_buzztrax_chorus_suite ());
+  srunner_add_suite (sr, gst_buzztrax_compressor_suite ());
+  srunner_add_suite (sr, gst_buzztrax_grain_syn_suite ());
+  srunner_add_suite (sr, gst_buzztrax_osc_wave_suite ());
+  srunner_add_suite (sr, gst_buzztrax_eq_suite ());
+  srunner_add_suite (sr, gst_buzztrax_fdn_reverb_suite ());
+  srunner_add_suite (sr, gst_buzztrax_conv_reverb_suite ());
+  srunner_add_suite (sr, gst_buzztrax_wave_cache_suite ());
+  srunner_add_suite (sr, gst_buzztrax_wave_stream_suite ());
+  srunner_add_suite (sr, gst_buzztrax_wave_tab_syn_suite ());
   // this make tracing errors with gdb easier
   //srunner_set_fork_status(sr,CK_NOFORK);
   srunner_run_all (sr, CK_VERBOSE);
@@ -20,6 +20,9 @@
 #include "glib.h"
 #include "gst/gst.h"
 
+#include <math.h>
+
+#include "libgstbuzztrax/envelope-adsr.h"
 #include "libgstbuzztrax/toneconversion.h"
 
 //-- globals
@@ -31,6 +34,9 @@ GST_DEBUG_CATEGORY_EXTERN(gst_buzztrax_debug);
 extern void gst_buzztrax_setup(void);
 extern void gst_buzztrax_teardown(void);
 
+extern GstPad *gst_buzztrax_setup_filter(GstElement *element, const gchar *caps, GList **buffers);
+extern void gst_buzztrax_teardown_filter(GstElement *element, GstPad *src, GList **buffers);
+
 //-- testing helper methods
 
 #define g_object_checked_unref(obj) \
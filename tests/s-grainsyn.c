@@ -0,0 +1,30 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+extern TCase *gst_buzztrax_grain_syn_test_case (void);
+
+Suite *
+gst_buzztrax_grain_syn_suite (void)
+{
+  Suite *s = suite_create ("GstBtGrainSyn");
+
+  suite_add_tcase (s, gst_buzztrax_grain_syn_test_case ());
+  return (s);
+}
@@ -0,0 +1,194 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "m-gst-buzztrax.h"
+
+#include <string.h>
+#include <gst/audio/audio.h>
+
+//-- globals
+
+#define F32_MONO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (F32) \
+    ", layout=interleaved, rate=44100, channels=1"
+#define S16_STEREO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (S16) \
+    ", layout=interleaved, rate=44100, channels=2"
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static GstBuffer *
+make_f32_buffer (guint num_frames, gfloat dc, gfloat first)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, num_frames * 4, NULL);
+  GstMapInfo info;
+  gfloat *data;
+  guint i;
+
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gfloat *) info.data;
+  for (i = 0; i < num_frames; i++) {
+    data[i] = dc;
+  }
+  data[0] = first;
+  gst_buffer_unmap (buffer, &info);
+  return buffer;
+}
+
+//-- tests
+
+START_TEST (test_single_voice_delays_impulse)
+{
+  GstElement *chorus;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat *data;
+  guint i;
+
+  chorus = gst_element_factory_make ("chorus", NULL);
+  g_object_set (chorus, "voices", 1, "delay", 10.0, "depth", 0.0,
+      "drywet", 100, "feedback", 0, NULL);
+  src = gst_buzztrax_setup_filter (chorus, F32_MONO_CAPS, &buffers);
+
+  buffer = make_f32_buffer (1024, 0.0, 1.0);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == 1024 * 4, NULL);
+  data = (gfloat *) info.data;
+  /* 10 ms at 44100 Hz */
+  for (i = 0; i < 1024; i++) {
+    gfloat expected = (i == 441) ? 1.0 : 0.0;
+    fail_unless (fabs (data[i] - expected) < 1e-6, "at %u: %f != %f", i,
+        data[i], expected);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (chorus, src, &buffers);
+  gst_object_unref (chorus);
+}
+
+END_TEST;
+
+START_TEST (test_dry_signal_passes_unchanged)
+{
+  GstElement *chorus;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 in[2 * 512], *data;
+  guint i;
+
+  chorus = gst_element_factory_make ("chorus", NULL);
+  g_object_set (chorus, "drywet", 0, NULL);
+  src = gst_buzztrax_setup_filter (chorus, S16_STEREO_CAPS, &buffers);
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i] = (gint16) ((i * 997) % 20000 - 10000);
+  }
+  buffer = gst_buffer_new_allocate (NULL, sizeof (in), NULL);
+  gst_buffer_fill (buffer, 0, in, sizeof (in));
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == sizeof (in), NULL);
+  data = (gint16 *) info.data;
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    fail_unless (data[i] == in[i], "at %u: %d != %d", i, data[i], in[i]);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (chorus, src, &buffers);
+  gst_object_unref (chorus);
+}
+
+END_TEST;
+
+START_TEST (test_voice_change_keeps_level)
+{
+  GstElement *chorus;
+  GstPad *src;
+  GList *buffers = NULL, *node;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat *data;
+  guint i;
+
+  chorus = gst_element_factory_make ("chorus", NULL);
+  g_object_set (chorus, "voices", 1, "delay", 10.0, "depth", 0.0,
+      "drywet", 100, "feedback", 0, NULL);
+  src = gst_buzztrax_setup_filter (chorus, F32_MONO_CAPS, &buffers);
+
+  buffer = make_f32_buffer (1024, 0.5, 0.5);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+  /* the voices are read with the same delay, while they fade the sum of their
+   * gains has to stay at 1 */
+  g_object_set (chorus, "voices", 3, NULL);
+  fail_unless (gst_pad_push (src, make_f32_buffer (1024, 0.5,
+              0.5)) == GST_FLOW_OK, NULL);
+  g_object_set (chorus, "voices", 2, NULL);
+  fail_unless (gst_pad_push (src, make_f32_buffer (1024, 0.5,
+              0.5)) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 3, NULL);
+  for (node = buffers->next; node; node = node->next) {
+    gst_buffer_map (node->data, &info, GST_MAP_READ);
+    data = (gfloat *) info.data;
+    for (i = 0; i < 1024; i++) {
+      fail_unless (fabs (data[i] - 0.5) < 1e-5, "at %u: %f != 0.5", i,
+          data[i]);
+    }
+    gst_buffer_unmap (node->data, &info);
+  }
+
+  gst_buzztrax_teardown_filter (chorus, src, &buffers);
+  gst_object_unref (chorus);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_chorus_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtChorusTests");
+
+  tcase_add_test (tc, test_single_voice_delays_impulse);
+  tcase_add_test (tc, test_dry_signal_passes_unchanged);
+  tcase_add_test (tc, test_voice_change_keeps_level);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,160 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "m-gst-buzztrax.h"
+
+#include <gst/audio/audio.h>
+
+//-- globals
+
+#define F32_MONO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (F32) \
+    ", layout=interleaved, rate=44100, channels=1"
+
+#define NUM_FRAMES 4096
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+/* Feed a constant level of @dc through the compressor without lookahead and
+ * check that the output settles at @expected. */
+static void
+check_steady_level (gdouble threshold, gdouble ratio, gdouble knee, gfloat dc,
+    gdouble expected)
+{
+  GstElement *compressor;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat *data;
+  guint i;
+
+  compressor = gst_element_factory_make ("compressor", NULL);
+  g_object_set (compressor, "threshold", threshold, "ratio", ratio,
+      "knee", knee, "attack", 0.1, "release", 1.0, "lookahead", 0.0,
+      "makeup-gain", 0.0, NULL);
+  src = gst_buzztrax_setup_filter (compressor, F32_MONO_CAPS, &buffers);
+
+  buffer = gst_buffer_new_allocate (NULL, NUM_FRAMES * sizeof (gfloat), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gfloat *) info.data;
+  for (i = 0; i < NUM_FRAMES; i++) {
+    data[i] = dc;
+  }
+  gst_buffer_unmap (buffer, &info);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  data = (gfloat *) info.data;
+  /* the envelope has settled after a few ms */
+  for (i = NUM_FRAMES - 256; i < NUM_FRAMES; i++) {
+    fail_unless (fabs (data[i] - expected) < 1e-4, "at %u: %f != %f", i,
+        data[i], expected);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (compressor, src, &buffers);
+  gst_object_unref (compressor);
+}
+
+//-- tests
+
+START_TEST (test_level_above_threshold_is_reduced_by_ratio)
+{
+  gdouble over = 20.0 * log10 (0.5) + 20.0;
+
+  /* hard knee, 4:1 above -20 dB */
+  check_steady_level (-20.0, 4.0, 0.0, 0.5,
+      0.5 * pow (10.0, (1.0 / 4.0 - 1.0) * over / 20.0));
+}
+
+END_TEST;
+
+START_TEST (test_level_at_threshold_is_reduced_by_knee)
+{
+  /* in the middle of a 10 dB knee the reduction is a quarter of the half
+   * knee scaled by the slope: (1/4 - 1) * 10 / 8 */
+  check_steady_level (-20.0, 4.0, 10.0, 0.1,
+      0.1 * pow (10.0, -0.9375 / 20.0));
+}
+
+END_TEST;
+
+START_TEST (test_level_below_knee_is_unchanged)
+{
+  check_steady_level (-20.0, 4.0, 10.0, 0.01, 0.01);
+}
+
+END_TEST;
+
+START_TEST (test_latency_matches_lookahead)
+{
+  GstElement *compressor;
+  GstPad *src, *pad;
+  GList *buffers = NULL;
+  GstQuery *query;
+  GstClockTime min, max;
+  gboolean live;
+
+  compressor = gst_element_factory_make ("compressor", NULL);
+  g_object_set (compressor, "lookahead", 5.0, NULL);
+  src = gst_buzztrax_setup_filter (compressor, F32_MONO_CAPS, &buffers);
+
+  pad = gst_element_get_static_pad (compressor, "src");
+  query = gst_query_new_latency ();
+  fail_unless (gst_pad_query (pad, query), NULL);
+  gst_query_parse_latency (query, &live, &min, &max);
+  /* 5 ms at 44100 Hz are rounded to 221 samples */
+  fail_unless (min == gst_util_uint64_scale_int (221, GST_SECOND, 44100),
+      "min latency is %" GST_TIME_FORMAT, GST_TIME_ARGS (min));
+  fail_unless (max == GST_CLOCK_TIME_NONE, NULL);
+  gst_query_unref (query);
+  gst_object_unref (pad);
+
+  gst_buzztrax_teardown_filter (compressor, src, &buffers);
+  gst_object_unref (compressor);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_compressor_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtCompressorTests");
+
+  tcase_add_test (tc, test_level_above_threshold_is_reduced_by_ratio);
+  tcase_add_test (tc, test_level_at_threshold_is_reduced_by_knee);
+  tcase_add_test (tc, test_level_below_knee_is_unchanged);
+  tcase_add_test (tc, test_latency_matches_lookahead);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,168 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <string.h>
+#include <gst/audio/audio.h>
+
+//-- globals
+
+#define F32_MONO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (F32) \
+    ", layout=interleaved, rate=44100, channels=1"
+#define S16_STEREO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (S16) \
+    ", layout=interleaved, rate=44100, channels=2"
+
+static GstStructure *wave;
+static GstStructure *get_wave_buffer (gpointer user_data, guint wave_ix,
+    guint wave_level_ix);
+static gpointer wave_callbacks[] = { NULL, get_wave_buffer };
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+
+  gst_buzztrax_setup ();
+
+  /* a unit impulse, the ir is normalized to unit energy anyway */
+  buffer = gst_buffer_new_allocate (NULL, 64 * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  memset (info.data, 0, info.size);
+  ((gint16 *) info.data)[0] = 16384;
+  gst_buffer_unmap (buffer, &info);
+  wave = gst_structure_new ("audio/x-raw",
+      "format", G_TYPE_STRING, GST_AUDIO_NE (S16),
+      "rate", G_TYPE_INT, 44100,
+      "channels", G_TYPE_INT, 1,
+      "buffer", GST_TYPE_BUFFER, buffer, NULL);
+  gst_buffer_unref (buffer);
+}
+
+static void
+suite_teardown (void)
+{
+  gst_structure_free (wave);
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static GstStructure *
+get_wave_buffer (gpointer user_data, guint wave_ix, guint wave_level_ix)
+{
+  return wave;
+}
+
+//-- tests
+
+START_TEST (test_unit_ir_delays_by_one_block)
+{
+  GstElement *reverb;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat in[1024], *data;
+  guint i;
+
+  reverb = gst_element_factory_make ("convreverb", NULL);
+  g_object_set (reverb, "wave-callbacks", wave_callbacks, "partition-size",
+      256, "drywet", 100, NULL);
+  src = gst_buzztrax_setup_filter (reverb, F32_MONO_CAPS, &buffers);
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i] = (gfloat) ((i * 7919) % 2000) / 1000.0f - 1.0f;
+  }
+  buffer = gst_buffer_new_allocate (NULL, sizeof (in), NULL);
+  gst_buffer_fill (buffer, 0, in, sizeof (in));
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == sizeof (in), NULL);
+  data = (gfloat *) info.data;
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    gfloat expected = (i < 256) ? 0.0 : in[i - 256];
+    fail_unless (fabs (data[i] - expected) < 1e-4, "at %u: %f != %f", i,
+        data[i], expected);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (reverb, src, &buffers);
+  gst_object_unref (reverb);
+}
+
+END_TEST;
+
+START_TEST (test_unit_ir_delays_by_rounded_block)
+{
+  GstElement *reverb;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 in[2 * 512], *data;
+  guint i;
+
+  /* the partition size is rounded up to 128 frames */
+  reverb = gst_element_factory_make ("convreverb", NULL);
+  g_object_set (reverb, "wave-callbacks", wave_callbacks, "partition-size",
+      100, "drywet", 100, NULL);
+  src = gst_buzztrax_setup_filter (reverb, S16_STEREO_CAPS, &buffers);
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i] = (gint16) ((i * 997) % 20000 - 10000);
+  }
+  buffer = gst_buffer_new_allocate (NULL, sizeof (in), NULL);
+  gst_buffer_fill (buffer, 0, in, sizeof (in));
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == sizeof (in), NULL);
+  data = (gint16 *) info.data;
+  /* the mono ir is used for both channels, allow for the rounding */
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    gint16 expected = (i < 2 * 128) ? 0 : in[i - 2 * 128];
+    fail_unless (ABS (data[i] - expected) <= 1, "at %u: %d != %d", i,
+        data[i], expected);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (reverb, src, &buffers);
+  gst_object_unref (reverb);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_conv_reverb_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtConvReverbTests");
+
+  tcase_add_test (tc, test_unit_ir_delays_by_one_block);
+  tcase_add_test (tc, test_unit_ir_delays_by_rounded_block);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,150 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <gst/audio/audio.h>
+
+#include "src/eq/eqband.h"
+
+//-- globals
+
+#define F32_MONO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (F32) \
+    ", layout=interleaved, rate=44100, channels=1"
+#define S16_STEREO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (S16) \
+    ", layout=interleaved, rate=44100, channels=2"
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+/* an eq with a band of each boosting type, all at 0 dB */
+static GstElement *
+make_flat_eq (void)
+{
+  GstElement *eq = gst_element_factory_make ("eq", NULL);
+
+  g_object_set (eq, "children", 3, NULL);
+  gst_child_proxy_set (GST_CHILD_PROXY (eq),
+      "band0::type", GSTBT_EQ_BAND_PEAK, "band0::frequency", 500.0,
+      "band1::type", GSTBT_EQ_BAND_LOW_SHELF, "band1::frequency", 200.0,
+      "band2::type", GSTBT_EQ_BAND_HIGH_SHELF, "band2::frequency", 5000.0,
+      "band2::q", 2.0, NULL);
+  return eq;
+}
+
+//-- tests
+
+START_TEST (test_flat_response_at_0db)
+{
+  GstElement *eq;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat in[2048], *data;
+  guint i;
+
+  eq = make_flat_eq ();
+  src = gst_buzztrax_setup_filter (eq, F32_MONO_CAPS, &buffers);
+
+  /* broadband input */
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i] = (gfloat) ((i * 7919) % 2000) / 1000.0f - 1.0f;
+  }
+  buffer = gst_buffer_new_allocate (NULL, sizeof (in), NULL);
+  gst_buffer_fill (buffer, 0, in, sizeof (in));
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == sizeof (in), NULL);
+  data = (gfloat *) info.data;
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    fail_unless (fabs (data[i] - in[i]) < 1e-4, "at %u: %f != %f", i,
+        data[i], in[i]);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (eq, src, &buffers);
+  gst_object_unref (eq);
+}
+
+END_TEST;
+
+START_TEST (test_flat_response_at_0db_s16)
+{
+  GstElement *eq;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 in[2 * 1024], *data;
+  guint i;
+
+  eq = make_flat_eq ();
+  src = gst_buzztrax_setup_filter (eq, S16_STEREO_CAPS, &buffers);
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i] = (gint16) ((i * 997) % 20000 - 10000);
+  }
+  buffer = gst_buffer_new_allocate (NULL, sizeof (in), NULL);
+  gst_buffer_fill (buffer, 0, in, sizeof (in));
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == sizeof (in), NULL);
+  data = (gint16 *) info.data;
+  /* allow for the rounding of the conversion */
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    fail_unless (ABS (data[i] - in[i]) <= 1, "at %u: %d != %d", i, data[i],
+        in[i]);
+  }
+  gst_buffer_unmap (buffers->data, &info);
+
+  gst_buzztrax_teardown_filter (eq, src, &buffers);
+  gst_object_unref (eq);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_eq_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtEqTests");
+
+  tcase_add_test (tc, test_flat_response_at_0db);
+  tcase_add_test (tc, test_flat_response_at_0db_s16);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,110 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <gst/audio/audio.h>
+
+//-- globals
+
+#define F32_MONO_CAPS "audio/x-raw, format=" GST_AUDIO_NE (F32) \
+    ", layout=interleaved, rate=44100, channels=1"
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static gdouble
+get_energy (const gfloat * data, guint num_frames)
+{
+  gdouble energy = 0.0;
+  guint i;
+
+  for (i = 0; i < num_frames; i++) {
+    energy += data[i] * data[i];
+  }
+  return energy;
+}
+
+//-- tests
+
+START_TEST (test_tail_decays_by_60db_after_decay_time)
+{
+  GstElement *reverb;
+  GstPad *src;
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gfloat *data;
+  gdouble early, late, level;
+  /* 0.25 s at 44100 Hz */
+  const guint t60 = 11025, window = 2048, start = 2048;
+
+  reverb = gst_element_factory_make ("fdnreverb", NULL);
+  g_object_set (reverb, "drywet", 100, "room-size", 20, "damping", 0,
+      "decay-time", 0.25, NULL);
+  src = gst_buzztrax_setup_filter (reverb, F32_MONO_CAPS, &buffers);
+
+  buffer = gst_buffer_new_allocate (NULL, 16384 * 4, NULL);
+  gst_buffer_memset (buffer, 0, 0, 16384 * 4);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  ((gfloat *) info.data)[0] = 1.0;
+  gst_buffer_unmap (buffer, &info);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless (gst_pad_push (src, buffer) == GST_FLOW_OK, NULL);
+
+  fail_unless (g_list_length (buffers) == 1, NULL);
+  gst_buffer_map (buffers->data, &info, GST_MAP_READ);
+  fail_unless (info.size == 16384 * 4, NULL);
+  data = (gfloat *) info.data;
+  /* compare windows after all lines have echoed the impulse */
+  early = get_energy (&data[start], window);
+  late = get_energy (&data[start + t60], window);
+  gst_buffer_unmap (buffers->data, &info);
+
+  fail_unless (early > 0.0, NULL);
+  level = 10.0 * log10 (late / early);
+  fail_unless (fabs (level + 60.0) < 3.0, "decayed by %f dB", level);
+
+  gst_buzztrax_teardown_filter (reverb, src, &buffers);
+  gst_object_unref (reverb);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_fdn_reverb_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtFdnReverbTests");
+
+  tcase_add_test (tc, test_tail_decays_by_60db_after_decay_time);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,207 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <string.h>
+#include <libgstbuzztrax/musicenums.h>
+#include "src/grainsyn/grainsyn.h"
+
+//-- globals
+
+/* the wave is played at its root note, so that the oscillator reads it 1:1 */
+#define WAVE_FRAMES (2 * 44100)
+
+static GstStructure *wave;
+static GstStructure *get_wave_buffer (gpointer user_data, guint wave_ix,
+    guint wave_level_ix);
+static gpointer wave_callbacks[] = { NULL, get_wave_buffer };
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 *data;
+  guint i;
+
+  gst_buzztrax_setup ();
+
+  buffer = gst_buffer_new_allocate (NULL, WAVE_FRAMES * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gint16 *) info.data;
+  for (i = 0; i < WAVE_FRAMES; i++) {
+    data[i] = (gint16) ((i % 1000) * 20 - 10000);
+  }
+  gst_buffer_unmap (buffer, &info);
+  wave = gst_structure_new ("audio/x-raw",
+      "channels", G_TYPE_INT, 1,
+      "root-note", GSTBT_TYPE_NOTE, GSTBT_NOTE_C_3,
+      "buffer", GST_TYPE_BUFFER, buffer, NULL);
+  gst_buffer_unref (buffer);
+}
+
+static void
+suite_teardown (void)
+{
+  gst_structure_free (wave);
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static GstStructure *
+get_wave_buffer (gpointer user_data, guint wave_ix, guint wave_level_ix)
+{
+  return wave;
+}
+
+static GstElement *
+make_grain_syn (void)
+{
+  GstElement *synth = gst_element_factory_make ("grainsyn", NULL);
+
+  g_object_set (synth, "wave-callbacks", wave_callbacks, NULL);
+  ((GstBtAudioSynth *) synth)->channels = 1;
+  gstbt_osc_wave_setup (((GstBtGrainSyn *) synth)->osc);
+  return synth;
+}
+
+/* render one buffer, copy the samples to @data if given */
+static gboolean
+render_buffer (GstElement * synth, gint16 * data)
+{
+  GstBtAudioSynth *base = (GstBtAudioSynth *) synth;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gboolean res;
+
+  buffer = gst_buffer_new_allocate (NULL,
+      base->generate_samples_per_buffer * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  res = GSTBT_AUDIO_SYNTH_GET_CLASS (base)->process (base, buffer, &info);
+  if (data) {
+    memcpy (data, info.data, info.size);
+  }
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+  return res;
+}
+
+//-- tests
+
+START_TEST (test_finished_grains_are_removed)
+{
+  GstElement *synth;
+  GstBtGrainSyn *src;
+  guint i;
+
+  synth = make_grain_syn ();
+  src = (GstBtGrainSyn *) synth;
+  /* a new 1 ms grain starts about when the previous one ends */
+  g_object_set (synth, "grain-size", 1.0, "density", 1000.0, "length", 4,
+      "note", GSTBT_NOTE_C_3, NULL);
+
+  for (i = 0; i < 4; i++) {
+    fail_unless (render_buffer (synth, NULL), NULL);
+    fail_unless (src->num_grains <= 2, "buffer %u: %u grains", i,
+        src->num_grains);
+  }
+  /* the note has ended, the last grain fades out */
+  render_buffer (synth, NULL);
+  fail_unless (src->num_grains == 0, "%u grains", src->num_grains);
+  fail_if (render_buffer (synth, NULL), NULL);
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+START_TEST (test_dense_cloud_is_capped)
+{
+  GstElement *synth;
+  GstBtGrainSyn *src;
+  guint i;
+
+  synth = make_grain_syn ();
+  src = (GstBtGrainSyn *) synth;
+  /* starts 9 grains per ms that last for a second */
+  g_object_set (synth, "grain-size", 1000.0, "density", 1000.0,
+      "extra-grains", 8, "length", 2, "note", GSTBT_NOTE_C_3, NULL);
+
+  for (i = 0; i < 2; i++) {
+    fail_unless (render_buffer (synth, NULL), NULL);
+    fail_unless (src->num_grains == GSTBT_GRAIN_SYN_MAX_GRAINS,
+        "buffer %u: %u grains", i, src->num_grains);
+  }
+  /* the grains run until the end of the wave */
+  for (i = 0; i < 20 && src->num_grains; i++) {
+    render_buffer (synth, NULL);
+  }
+  fail_unless (src->num_grains == 0, "%u grains", src->num_grains);
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+START_TEST (test_note_repeats_identically)
+{
+  GstElement *synth;
+  GstBtGrainSyn *src;
+  guint n;
+  gint16 *data1, *data2;
+
+  synth = make_grain_syn ();
+  src = (GstBtGrainSyn *) synth;
+  n = ((GstBtAudioSynth *) synth)->generate_samples_per_buffer;
+  data1 = g_new (gint16, n);
+  data2 = g_new (gint16, n);
+  /* the extra grains are placed randomly */
+  g_object_set (synth, "grain-size", 5.0, "density", 200.0,
+      "extra-grains", 4, "spread", 20.0, NULL);
+
+  g_object_set (synth, "note", GSTBT_NOTE_C_3, NULL);
+  fail_unless (render_buffer (synth, data1), NULL);
+  render_buffer (synth, NULL);
+  fail_unless (src->num_grains == 0, "%u grains", src->num_grains);
+
+  g_object_set (synth, "note", GSTBT_NOTE_C_3, NULL);
+  fail_unless (render_buffer (synth, data2), NULL);
+  fail_unless (memcmp (data1, data2, n * sizeof (gint16)) == 0, NULL);
+
+  g_free (data1);
+  g_free (data2);
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_grain_syn_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtGrainSynTests");
+
+  tcase_add_test (tc, test_finished_grains_are_removed);
+  tcase_add_test (tc, test_dense_cloud_is_capped);
+  tcase_add_test (tc, test_note_repeats_identically);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
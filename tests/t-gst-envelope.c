@@ -0,0 +1,131 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "m-gst-buzztrax.h"
+
+//-- globals
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- tests
+
+START_TEST (test_get_block_matches_control_source)
+{
+  GstBtEnvelopeADSR *env;
+  GstBtEnvelope *base;
+  gdouble block[200], value;
+  guint i;
+
+  env = gstbt_envelope_adsr_new ();
+  base = (GstBtEnvelope *) env;
+  gstbt_envelope_adsr_setup (env, 1000, 0.01, 0.02, 0.05, 0.1, 1.0, 0.5);
+
+  gstbt_envelope_get_block (base, G_N_ELEMENTS (block), block);
+
+  for (i = 0; i < G_N_ELEMENTS (block); i++) {
+    gst_control_source_get_value ((GstControlSource *) base->cs, i, &value);
+    fail_unless (fabs (block[i] - value) < 1e-9, "at %u: %lf != %lf", i,
+        block[i], value);
+  }
+  fail_unless (base->offset == G_N_ELEMENTS (block), NULL);
+
+  // free object
+  g_object_checked_unref (env);
+}
+
+END_TEST
+START_TEST (test_apply_s16_reaches_silence)
+{
+  GstBtEnvelopeADSR *env;
+  gint16 data[2 * 200];
+  guint i;
+
+  env = gstbt_envelope_adsr_new ();
+  gstbt_envelope_adsr_setup (env, 1000, 0.01, 0.02, 0.05, 0.1, 1.0, 0.5);
+  for (i = 0; i < G_N_ELEMENTS (data); i++)
+    data[i] = G_MAXINT16;
+
+  gstbt_envelope_apply_s16 ((GstBtEnvelope *) env, 200, 2, data);
+
+  fail_unless (data[0] == 0, NULL);
+  fail_unless (data[2 * 10] == data[2 * 10 + 1], NULL);
+  fail_unless (data[2 * 10] > data[2 * 40], NULL);
+  fail_unless (data[2 * 199] == 0, NULL);
+  fail_unless (!gstbt_envelope_is_running ((GstBtEnvelope *) env), NULL);
+
+  // free object
+  g_object_checked_unref (env);
+}
+
+END_TEST
+START_TEST (test_curved_segments_keep_end_points)
+{
+  GstBtEnvelopeADSR *env;
+  GstBtEnvelope *base;
+  gdouble lin[200], crv[200];
+  guint i;
+
+  env = gstbt_envelope_adsr_new ();
+  base = (GstBtEnvelope *) env;
+  gstbt_envelope_adsr_setup (env, 1000, 0.01, 0.02, 0.05, 0.1, 1.0, 0.5);
+  gstbt_envelope_get_block (base, G_N_ELEMENTS (lin), lin);
+  g_object_set (env, "curve", 4.0, NULL);
+  gstbt_envelope_adsr_setup (env, 1000, 0.01, 0.02, 0.05, 0.1, 1.0, 0.5);
+  gstbt_envelope_get_block (base, G_N_ELEMENTS (crv), crv);
+
+  // attack, decay, sustain and release points are identical
+  fail_unless (fabs (crv[10] - lin[10]) < 1e-9, NULL);
+  fail_unless (fabs (crv[30] - lin[30]) < 1e-9, NULL);
+  fail_unless (fabs (crv[50] - lin[50]) < 1e-9, NULL);
+  fail_unless (fabs (crv[150] - lin[150]) < 1e-9, NULL);
+  // but the segments are bent
+  fail_unless (crv[5] > lin[5], NULL);
+  fail_unless (crv[20] < lin[20], NULL);
+  fail_unless (crv[100] < lin[100], NULL);
+  for (i = 1; i < G_N_ELEMENTS (crv); i++) {
+    fail_unless (crv[i] >= 0.0 && crv[i] <= 1.0, NULL);
+  }
+
+  // free object
+  g_object_checked_unref (env);
+}
+
+END_TEST
+
+TCase *
+gst_buzztrax_envelope_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtEnvelopeTests");
+
+  tcase_add_test (tc, test_get_block_matches_control_source);
+  tcase_add_test (tc, test_apply_s16_reaches_silence);
+  tcase_add_test (tc, test_curved_segments_keep_end_points);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
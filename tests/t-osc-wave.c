@@ -0,0 +1,361 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "m-gst-buzztrax.h"
+
+#include <libgstbuzztrax/musicenums.h>
+#include <libgstbuzztrax/osc-wave.h>
+
+//-- globals
+
+/* a cosine with its peaks at the loop points, the loop ends at the end of
+ * the wave */
+#define WAVE_PERIOD 94
+#define WAVE_AMPLITUDE 16000.0
+#define LOOP_START 200
+#define LOOP_FRAMES (8 * WAVE_PERIOD)
+#define RENDER_FRAMES 4000
+#define RAMP_SLOPE 8
+#define RAMP_FRAMES 4096
+#define RAMP_LOOP_START 100
+#define RAMP_LOOP_END 200
+
+static GstStructure *wave;
+static GstStructure *get_wave_buffer (gpointer user_data, guint wave_ix,
+    guint wave_level_ix);
+static gpointer wave_callbacks[] = { NULL, get_wave_buffer };
+
+static GstBtOscWaveInterpolation interpolations[] = {
+  GSTBT_OSC_WAVE_INTERPOLATION_LINEAR,
+  GSTBT_OSC_WAVE_INTERPOLATION_CUBIC,
+  GSTBT_OSC_WAVE_INTERPOLATION_SINC
+};
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static GstStructure *
+get_wave_buffer (gpointer user_data, guint wave_ix, guint wave_level_ix)
+{
+  return wave;
+}
+
+static void
+make_looped_sine (GstBtOscWaveLoopMode loop_mode)
+{
+  /* a ping-pong loop turns at its last frame */
+  const guint64 frames = LOOP_START + LOOP_FRAMES +
+      (loop_mode == GSTBT_OSC_WAVE_LOOP_PINGPONG ? 1 : 0);
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 *data;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, frames * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gint16 *) info.data;
+  for (i = 0; i < frames; i++) {
+    data[i] = (gint16) (WAVE_AMPLITUDE *
+        cos (2.0 * G_PI * ((gint) i - LOOP_START) / WAVE_PERIOD));
+  }
+  gst_buffer_unmap (buffer, &info);
+  wave = gst_structure_new ("audio/x-raw",
+      "channels", G_TYPE_INT, 1,
+      "root-note", GSTBT_TYPE_NOTE, GSTBT_NOTE_C_3,
+      "buffer", GST_TYPE_BUFFER, buffer,
+      "loop-mode", G_TYPE_INT, loop_mode,
+      "loop-start", G_TYPE_UINT64, (guint64) LOOP_START,
+      "loop-end", G_TYPE_UINT64, frames, NULL);
+  gst_buffer_unref (buffer);
+}
+
+/* a ramp, thus the value of a sample tells its position */
+static void
+make_ramp (guint frames, GstBtOscWaveLoopMode loop_mode, guint64 loop_start,
+    guint64 loop_end)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 *data;
+  guint i;
+
+  buffer = gst_buffer_new_allocate (NULL, frames * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gint16 *) info.data;
+  for (i = 0; i < frames; i++) {
+    data[i] = (gint16) (i * RAMP_SLOPE);
+  }
+  gst_buffer_unmap (buffer, &info);
+  wave = gst_structure_new ("audio/x-raw",
+      "channels", G_TYPE_INT, 1,
+      "root-note", GSTBT_TYPE_NOTE, GSTBT_NOTE_C_3,
+      "buffer", GST_TYPE_BUFFER, buffer,
+      "loop-mode", G_TYPE_INT, loop_mode,
+      "loop-start", G_TYPE_UINT64, loop_start,
+      "loop-end", G_TYPE_UINT64, loop_end, NULL);
+  gst_buffer_unref (buffer);
+}
+
+/* play the wave at @rate times its speed */
+static void
+set_rate (GstBtOscWave * osc, gdouble rate)
+{
+  GstBtToneConversion *n2f =
+      gstbt_tone_conversion_new (GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
+  gdouble root_freq =
+      gstbt_tone_conversion_translate_from_number (n2f, GSTBT_NOTE_C_3);
+
+  g_object_set (osc, "frequency", root_freq / rate, NULL);
+  g_object_unref (n2f);
+}
+
+static GstBtOscWave *
+make_osc_wave (gdouble rate, GstBtOscWaveInterpolation interpolation)
+{
+  GstBtOscWave *osc = gstbt_osc_wave_new ();
+
+  g_object_set (osc, "wave-callbacks", wave_callbacks, "mipmaps", FALSE,
+      "interpolation", interpolation, NULL);
+  set_rate (osc, rate);
+  gstbt_osc_wave_setup (osc);
+  return osc;
+}
+
+/* the mip levels are built in the background, rendering picks them up */
+static void
+wait_for_mips (GstBtOscWave * osc)
+{
+  gint16 data[16];
+  guint i;
+
+  for (i = 0; i < 5000 && osc->mip_pending; i++) {
+    g_usleep (G_USEC_PER_SEC / 1000);
+    osc->process (osc, 0, G_N_ELEMENTS (data), data);
+  }
+  fail_if (osc->mip_pending, "mip levels have not been built");
+}
+
+/* largest difference between two adjacent samples, the start of the wave is
+ * skipped as the interpolation sees silence before it */
+static gdouble
+render_max_jump (GstBtOscWave * osc)
+{
+  gint16 data[RENDER_FRAMES];
+  gdouble jump = 0.0;
+  guint i;
+
+  for (i = 0; i < RENDER_FRAMES; i += 256) {
+    fail_unless (osc->process (osc, i, MIN (256, RENDER_FRAMES - i),
+            &data[i]), NULL);
+  }
+  for (i = 16; i < RENDER_FRAMES; i++) {
+    jump = MAX (jump, fabs ((gdouble) data[i] - data[i - 1]));
+  }
+  return jump;
+}
+
+static void
+check_loop_is_seamless (GstBtOscWaveLoopMode loop_mode, gdouble rate)
+{
+  /* the steepest slope of the sine, with some room for the interpolation */
+  const gdouble limit = 1.1 * WAVE_AMPLITUDE * 2.0 * G_PI * rate / WAVE_PERIOD;
+  GstBtOscWave *osc;
+  gdouble jump;
+  guint i;
+
+  make_looped_sine (loop_mode);
+  for (i = 0; i < G_N_ELEMENTS (interpolations); i++) {
+    osc = make_osc_wave (rate, interpolations[i]);
+    jump = render_max_jump (osc);
+    fail_unless (jump < limit, "interpolation %d: jump %lf >= %lf",
+        interpolations[i], jump, limit);
+    g_object_unref (osc);
+  }
+  gst_structure_free (wave);
+}
+
+/* linear and cubic interpolation, the first two modes, reproduce a ramp */
+static void
+check_ramp_is_interpolated (gdouble rate)
+{
+  GstBtOscWave *osc;
+  gint16 data[1024];
+  gdouble expected;
+  guint i, j;
+
+  make_ramp (RAMP_FRAMES, GSTBT_OSC_WAVE_LOOP_OFF, 0, 0);
+  for (i = 0; i < 2; i++) {
+    osc = make_osc_wave (rate, interpolations[i]);
+    fail_unless (osc->process (osc, 0, G_N_ELEMENTS (data), data), NULL);
+    /* the cubic interpolation sees silence before the first sample */
+    for (j = 2; j < G_N_ELEMENTS (data); j++) {
+      expected = j * rate * RAMP_SLOPE;
+      fail_unless (fabs (data[j] - expected) <= 1.0,
+          "interpolation %d: at %u: %d != %lf", interpolations[i], j, data[j],
+          expected);
+    }
+    g_object_unref (osc);
+  }
+  gst_structure_free (wave);
+}
+
+/* position @p of the endlessly looped ramp in the wave */
+static gint64
+get_looped_position (GstBtOscWaveLoopMode loop_mode, gint64 p)
+{
+  const gboolean pingpong = (loop_mode == GSTBT_OSC_WAVE_LOOP_PINGPONG);
+  const gint64 turn = RAMP_LOOP_END - (pingpong ? 1 : 0);
+  const gint64 len = turn - RAMP_LOOP_START;
+  gint64 u;
+
+  if (p < turn)
+    return p;
+  u = (p - RAMP_LOOP_START) % (pingpong ? 2 * len : len);
+  return (u < len) ? RAMP_LOOP_START + u : turn - (u - len);
+}
+
+/* without interpolation the looped ramp gives the positions, a rate of 1 is
+ * copied, other rates are read from the loop guards near the loop points */
+static void
+check_loop_positions (GstBtOscWaveLoopMode loop_mode, guint rate)
+{
+  GstBtOscWave *osc;
+  gint16 data[RENDER_FRAMES];
+  gint expected;
+  guint i;
+
+  make_ramp (RAMP_LOOP_END + 100, loop_mode, RAMP_LOOP_START, RAMP_LOOP_END);
+  osc = make_osc_wave (rate, GSTBT_OSC_WAVE_INTERPOLATION_NONE);
+  for (i = 0; i < RENDER_FRAMES; i += 256) {
+    fail_unless (osc->process (osc, i, MIN (256, RENDER_FRAMES - i),
+            &data[i]), NULL);
+  }
+  for (i = 0; i < RENDER_FRAMES; i++) {
+    expected = RAMP_SLOPE * get_looped_position (loop_mode, (gint64) i * rate);
+    fail_unless (data[i] == expected, "rate %u: at %u: %d != %d", rate, i,
+        data[i], expected);
+  }
+  g_object_unref (osc);
+  gst_structure_free (wave);
+}
+
+//-- tests
+
+START_TEST (test_ramp_is_interpolated)
+{
+  check_ramp_is_interpolated (0.5);
+  check_ramp_is_interpolated (0.75);
+  check_ramp_is_interpolated (1.5);
+}
+
+END_TEST;
+
+START_TEST (test_mip_level_fits_rate)
+{
+  GstBtOscWave *osc;
+
+  make_ramp (RAMP_FRAMES, GSTBT_OSC_WAVE_LOOP_OFF, 0, 0);
+  osc = make_osc_wave (3.0, GSTBT_OSC_WAVE_INTERPOLATION_LINEAR);
+  g_object_set (osc, "mipmaps", TRUE, NULL);
+  wait_for_mips (osc);
+
+  /* the next lower level, so that the level is not read faster than 1:1 */
+  ck_assert_int_eq (osc->mip_level, 2);
+  fail_unless (osc->mip_fade == 0.0, NULL);
+  set_rate (osc, 5.0);
+  ck_assert_int_eq (osc->mip_level, 3);
+  /* beyond the smallest level */
+  set_rate (osc, 1000.0);
+  ck_assert_int_eq (osc->mip_level, GSTBT_OSC_WAVE_MAX_MIP_LEVELS - 1);
+  /* the wave itself */
+  set_rate (osc, 0.5);
+  ck_assert_int_eq (osc->mip_level, 0);
+
+  /* the higher level, faded towards the next lower one */
+  g_object_set (osc, "mip-crossfade", TRUE, NULL);
+  set_rate (osc, 3.0);
+  ck_assert_int_eq (osc->mip_level, 1);
+  fail_unless (fabs (osc->mip_fade - (log2 (3.0) - 1.0)) < 1e-4,
+      "fade %f", osc->mip_fade);
+
+  g_object_unref (osc);
+  gst_structure_free (wave);
+}
+
+END_TEST;
+
+START_TEST (test_forward_loop_positions)
+{
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_FORWARD, 1);
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_FORWARD, 2);
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_FORWARD, 3);
+}
+
+END_TEST;
+
+START_TEST (test_pingpong_loop_positions)
+{
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_PINGPONG, 1);
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_PINGPONG, 2);
+  check_loop_positions (GSTBT_OSC_WAVE_LOOP_PINGPONG, 3);
+}
+
+END_TEST;
+
+START_TEST (test_forward_loop_is_seamless)
+{
+  check_loop_is_seamless (GSTBT_OSC_WAVE_LOOP_FORWARD, 1.3);
+  check_loop_is_seamless (GSTBT_OSC_WAVE_LOOP_FORWARD, 0.7);
+}
+
+END_TEST;
+
+START_TEST (test_pingpong_loop_is_seamless)
+{
+  check_loop_is_seamless (GSTBT_OSC_WAVE_LOOP_PINGPONG, 1.3);
+  check_loop_is_seamless (GSTBT_OSC_WAVE_LOOP_PINGPONG, 0.7);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_osc_wave_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtOscWaveTests");
+
+  tcase_add_test (tc, test_ramp_is_interpolated);
+  tcase_add_test (tc, test_mip_level_fits_rate);
+  tcase_add_test (tc, test_forward_loop_positions);
+  tcase_add_test (tc, test_pingpong_loop_positions);
+  tcase_add_test (tc, test_forward_loop_is_seamless);
+  tcase_add_test (tc, test_pingpong_loop_is_seamless);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,250 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <glib/gstdio.h>
+#include <libgstbuzztrax/wave-cache.h>
+
+/* the tests trim the cache, the test environment points XDG_CACHE_HOME to
+ * the build directory */
+
+//-- globals
+
+#define WAVE_FRAMES 1000
+/* the header in front of the samples */
+#define ENTRY_OVERHEAD 64
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+/* a stereo wave, @seed makes the content unique */
+static GstBuffer *
+make_wave (guint seed)
+{
+  GstBuffer *buffer =
+      gst_buffer_new_allocate (NULL, 2 * WAVE_FRAMES * sizeof (gint16), NULL);
+  GstMapInfo info;
+  gint16 *data;
+  guint i;
+
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gint16 *) info.data;
+  for (i = 0; i < 2 * WAVE_FRAMES; i++) {
+    data[i] = (gint16) ((i * 997 + seed * 7919) % 20000 - 10000);
+  }
+  gst_buffer_unmap (buffer, &info);
+  return buffer;
+}
+
+static gchar *
+make_key (GstBuffer * buffer)
+{
+  GstMapInfo info;
+  gchar *key;
+
+  gst_buffer_map (buffer, &info, GST_MAP_READ);
+  key = gstbt_wave_cache_make_key (info.data, info.size);
+  gst_buffer_unmap (buffer, &info);
+  return key;
+}
+
+static void
+assert_buffers_equal (GstBuffer * buffer, GstBuffer * expected)
+{
+  GstMapInfo info;
+
+  fail_unless (buffer != NULL, NULL);
+  gst_buffer_map (expected, &info, GST_MAP_READ);
+  fail_unless (gst_buffer_get_size (buffer) == info.size, NULL);
+  fail_unless (gst_buffer_memcmp (buffer, 0, info.data, info.size) == 0, NULL);
+  gst_buffer_unmap (expected, &info);
+}
+
+/* store @buffer and pretend that it has last been used @age seconds ago */
+static gchar *
+store_with_age (GstBuffer * buffer, time_t age)
+{
+  gchar *key = make_key (buffer), *name, *path;
+  GstBuffer *stored;
+  struct utimbuf times;
+
+  stored = gstbt_wave_cache_store (key, GSTBT_WAVE_CACHE_FORMAT_S16, 2,
+      buffer);
+  fail_unless (stored != NULL, NULL);
+  gst_buffer_unref (stored);
+
+  name = g_strconcat (key, ".pcm", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "gst-buzztrax", "waves",
+      name, NULL);
+  times.actime = times.modtime = time (NULL) - age;
+  fail_unless (g_utime (path, &times) == 0, NULL);
+  g_free (path);
+  g_free (name);
+  return key;
+}
+
+//-- tests
+
+START_TEST (test_store_and_lookup)
+{
+  GstBuffer *wave = make_wave (1), *stored, *found;
+  GstBtWaveCacheFormat format;
+  guint channels;
+  gchar *key = make_key (wave);
+
+  stored = gstbt_wave_cache_store (key, GSTBT_WAVE_CACHE_FORMAT_S16, 2, wave);
+  assert_buffers_equal (stored, wave);
+  fail_unless (gstbt_wave_cache_contains (key), NULL);
+
+  found = gstbt_wave_cache_lookup (key, &format, &channels);
+  assert_buffers_equal (found, wave);
+  ck_assert_int_eq (format, GSTBT_WAVE_CACHE_FORMAT_S16);
+  ck_assert_int_eq (channels, 2);
+
+  gst_buffer_unref (found);
+  gst_buffer_unref (stored);
+  gst_buffer_unref (wave);
+  g_free (key);
+}
+
+END_TEST;
+
+START_TEST (test_open_reads_samples)
+{
+  GstBuffer *wave = make_wave (2), *stored;
+  GstBtWaveCacheFormat format;
+  GstMapInfo info;
+  guint channels;
+  guint64 size;
+  goffset offset;
+  gchar *key = make_key (wave), *data;
+  gint fd;
+
+  stored = gstbt_wave_cache_store (key, GSTBT_WAVE_CACHE_FORMAT_S16, 2, wave);
+  fail_unless (stored != NULL, NULL);
+
+  fd = gstbt_wave_cache_open (key, &format, &channels, &size, &offset);
+  fail_unless (fd != -1, NULL);
+  ck_assert_int_eq (format, GSTBT_WAVE_CACHE_FORMAT_S16);
+  ck_assert_int_eq (channels, 2);
+  gst_buffer_map (wave, &info, GST_MAP_READ);
+  fail_unless (size == info.size, NULL);
+  data = g_malloc (size);
+  fail_unless (pread (fd, data, size, offset) == (gssize) size, NULL);
+  fail_unless (memcmp (data, info.data, size) == 0, NULL);
+  gst_buffer_unmap (wave, &info);
+  close (fd);
+
+  g_free (data);
+  gst_buffer_unref (stored);
+  gst_buffer_unref (wave);
+  g_free (key);
+}
+
+END_TEST;
+
+START_TEST (test_missing_or_invalid_keys)
+{
+  GstBtWaveCacheFormat format;
+  guint channels;
+  guint64 size;
+  goffset offset;
+
+  fail_if (gstbt_wave_cache_contains ("0123456789abcdef"), NULL);
+  fail_unless (gstbt_wave_cache_lookup ("0123456789abcdef", &format,
+          &channels) == NULL, NULL);
+  /* keys are used as file names */
+  fail_unless (gstbt_wave_cache_lookup ("../waves", &format,
+          &channels) == NULL, NULL);
+  fail_unless (gstbt_wave_cache_open ("", &format, &channels, &size,
+          &offset) == -1, NULL);
+}
+
+END_TEST;
+
+START_TEST (test_trim_removes_least_recently_used)
+{
+  GstBuffer *wave = make_wave (3), *found;
+  const guint64 entry_size = ENTRY_OVERHEAD + gst_buffer_get_size (wave);
+  GstBtWaveCacheFormat format;
+  guint channels;
+  gchar *old, *used, *recent;
+
+  /* start from an empty cache */
+  ck_assert_int_eq (gstbt_wave_cache_trim (0), 0);
+
+  old = store_with_age (wave, 300);
+  gst_buffer_unref (wave);
+  used = store_with_age ((wave = make_wave (4)), 200);
+  gst_buffer_unref (wave);
+  recent = store_with_age ((wave = make_wave (5)), 100);
+  gst_buffer_unref (wave);
+
+  /* a lookup counts as a use */
+  found = gstbt_wave_cache_lookup (used, &format, &channels);
+  fail_unless (found != NULL, NULL);
+  gst_buffer_unref (found);
+
+  fail_unless (gstbt_wave_cache_trim (3 * entry_size) == 3 * entry_size, NULL);
+  fail_unless (gstbt_wave_cache_trim (2 * entry_size + 1) == 2 * entry_size,
+      NULL);
+  fail_if (gstbt_wave_cache_contains (old), NULL);
+  fail_unless (gstbt_wave_cache_contains (used), NULL);
+  fail_unless (gstbt_wave_cache_contains (recent), NULL);
+
+  fail_unless (gstbt_wave_cache_trim (entry_size) == entry_size, NULL);
+  fail_unless (gstbt_wave_cache_contains (used), NULL);
+  fail_if (gstbt_wave_cache_contains (recent), NULL);
+
+  g_free (old);
+  g_free (used);
+  g_free (recent);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_wave_cache_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtWaveCacheTests");
+
+  tcase_add_test (tc, test_store_and_lookup);
+  tcase_add_test (tc, test_open_reads_samples);
+  tcase_add_test (tc, test_missing_or_invalid_keys);
+  tcase_add_test (tc, test_trim_removes_least_recently_used);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
@@ -0,0 +1,208 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <libgstbuzztrax/wave-stream.h>
+
+//-- globals
+
+/* less than the prefetch chunk, once the first frame is there, the rest of
+ * the wave is there too */
+#define WAVE_FRAMES 10000
+#define WAVE_CHANNELS 2
+/* the samples follow a header in the file */
+#define WAVE_OFFSET 64
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  gst_buzztrax_setup ();
+}
+
+static void
+suite_teardown (void)
+{
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+/* never 0, thus silence tells that the frame has not been prefetched */
+static gint16
+get_sample (guint64 i, guint c)
+{
+  return (gint16) (((i * WAVE_CHANNELS + c) * 997) % 20000 + 1);
+}
+
+static GstBtWaveStream *
+make_stream (GstBtWaveCacheFormat format)
+{
+  const gsize size = (format == GSTBT_WAVE_CACHE_FORMAT_S16) ?
+      sizeof (gint16) : sizeof (gfloat);
+  guint8 *data = g_malloc (WAVE_OFFSET + WAVE_FRAMES * WAVE_CHANNELS * size);
+  gint16 *d16 = (gint16 *) &data[WAVE_OFFSET];
+  gfloat *d32 = (gfloat *) &data[WAVE_OFFSET];
+  gchar *path;
+  guint i, c;
+  gint fd;
+
+  memset (data, 0xff, WAVE_OFFSET);
+  for (i = 0; i < WAVE_FRAMES; i++) {
+    for (c = 0; c < WAVE_CHANNELS; c++) {
+      if (format == GSTBT_WAVE_CACHE_FORMAT_S16) {
+        d16[i * WAVE_CHANNELS + c] = get_sample (i, c);
+      } else {
+        d32[i * WAVE_CHANNELS + c] = get_sample (i, c) / 32767.0f;
+      }
+    }
+  }
+  fd = g_file_open_tmp ("wave-stream-XXXXXX", &path, NULL);
+  fail_unless (fd != -1, NULL);
+  fail_unless (write (fd, data, WAVE_OFFSET + WAVE_FRAMES * WAVE_CHANNELS *
+          size) == (gssize) (WAVE_OFFSET + WAVE_FRAMES * WAVE_CHANNELS * size),
+      NULL);
+  /* the stream keeps the file open */
+  g_unlink (path);
+  g_free (path);
+  g_free (data);
+  return gstbt_wave_stream_new (fd, WAVE_OFFSET, format, WAVE_FRAMES,
+      WAVE_CHANNELS);
+}
+
+static void
+assert_frames (const gint16 * data, guint64 pos, guint ct, gint tolerance)
+{
+  guint i, c;
+  gint16 s;
+
+  for (i = 0; i < ct; i++) {
+    for (c = 0; c < WAVE_CHANNELS; c++) {
+      s = (pos + i < WAVE_FRAMES) ? get_sample (pos + i, c) : 0;
+      fail_unless (ABS (data[i * WAVE_CHANNELS + c] - s) <= tolerance,
+          "at %" G_GUINT64_FORMAT ":%u: %d != %d", pos + i, c,
+          data[i * WAVE_CHANNELS + c], s);
+    }
+  }
+}
+
+/* read single frames from @pos on until the prefetch thread has caught up,
+ * returns the position after the first frame that is not silent, reading
+ * from there on does not seek */
+static guint64
+wait_for_frames (GstBtWaveStream * stream, guint64 pos, gint tolerance)
+{
+  gint16 frame[WAVE_CHANNELS];
+  guint i;
+
+  for (i = 0; i < 5000; i++, pos++) {
+    fail_unless (gstbt_wave_stream_read (stream, pos, 1, frame), NULL);
+    if (frame[0]) {
+      assert_frames (frame, pos, 1, tolerance);
+      return pos + 1;
+    }
+    g_usleep (G_USEC_PER_SEC / 1000);
+  }
+  fail ("no frames have been prefetched");
+  return pos;
+}
+
+/* read the wave from @pos to the end in blocks */
+static void
+check_read_to_end (GstBtWaveStream * stream, guint64 pos, gint tolerance)
+{
+  gint16 data[256 * WAVE_CHANNELS];
+
+  for (; pos < WAVE_FRAMES; pos += 256) {
+    fail_unless (gstbt_wave_stream_read (stream, pos, 256, data), NULL);
+    /* the last block is filled with silence */
+    assert_frames (data, pos, 256, tolerance);
+  }
+  fail_if (gstbt_wave_stream_read (stream, pos, 256, data), NULL);
+}
+
+//-- tests
+
+START_TEST (test_sequential_read)
+{
+  GstBtWaveStream *stream = make_stream (GSTBT_WAVE_CACHE_FORMAT_S16);
+  guint64 pos;
+
+  ck_assert_int_eq (gstbt_wave_stream_get_frames (stream), WAVE_FRAMES);
+  pos = wait_for_frames (stream, 0, 0);
+  check_read_to_end (stream, pos, 0);
+  ck_assert_int_eq (gstbt_wave_stream_get_error (stream), 0);
+
+  gstbt_wave_stream_free (stream);
+}
+
+END_TEST;
+
+START_TEST (test_sequential_read_converts_float)
+{
+  GstBtWaveStream *stream = make_stream (GSTBT_WAVE_CACHE_FORMAT_F32);
+  guint64 pos;
+
+  pos = wait_for_frames (stream, 0, 1);
+  check_read_to_end (stream, pos, 1);
+  ck_assert_int_eq (gstbt_wave_stream_get_error (stream), 0);
+
+  gstbt_wave_stream_free (stream);
+}
+
+END_TEST;
+
+START_TEST (test_seek)
+{
+  GstBtWaveStream *stream = make_stream (GSTBT_WAVE_CACHE_FORMAT_S16);
+  gint16 data[256 * WAVE_CHANNELS];
+  guint64 pos;
+
+  pos = wait_for_frames (stream, 0, 0);
+  fail_unless (gstbt_wave_stream_read (stream, pos, 256, data), NULL);
+  assert_frames (data, pos, 256, 0);
+
+  /* forwards, the stream refills from the new position */
+  pos = wait_for_frames (stream, 7000, 0);
+  check_read_to_end (stream, pos, 0);
+  /* and backwards */
+  pos = wait_for_frames (stream, 100, 0);
+  check_read_to_end (stream, pos, 0);
+  ck_assert_int_eq (gstbt_wave_stream_get_error (stream), 0);
+
+  gstbt_wave_stream_free (stream);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_wave_stream_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtWaveStreamTests");
+
+  tcase_add_test (tc, test_sequential_read);
+  tcase_add_test (tc, test_sequential_read_converts_float);
+  tcase_add_test (tc, test_seek);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}
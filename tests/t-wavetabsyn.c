@@ -0,0 +1,221 @@
+/* GStreamer
+ * Copyright (C) 2014 Stefan Sauer <ensonic@users.sf.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "m-gst-buzztrax.h"
+
+#include <libgstbuzztrax/musicenums.h>
+#include "src/wavetabsyn/wavetabsyn.h"
+
+//-- globals
+
+#define WAVE_FRAMES 44100
+#define NUM_VOICES 3
+
+static GstStructure *wave;
+static GstStructure *get_wave_buffer (gpointer user_data, guint wave_ix,
+    guint wave_level_ix);
+static gpointer wave_callbacks[] = { NULL, get_wave_buffer };
+
+//-- fixtures
+
+static void
+suite_setup (void)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gint16 *data;
+  guint i;
+
+  gst_buzztrax_setup ();
+
+  buffer = gst_buffer_new_allocate (NULL, WAVE_FRAMES * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  data = (gint16 *) info.data;
+  for (i = 0; i < WAVE_FRAMES; i++) {
+    data[i] = (gint16) ((i % 1000) * 20 - 10000);
+  }
+  gst_buffer_unmap (buffer, &info);
+  wave = gst_structure_new ("audio/x-raw",
+      "channels", G_TYPE_INT, 1,
+      "root-note", GSTBT_TYPE_NOTE, GSTBT_NOTE_C_3,
+      "buffer", GST_TYPE_BUFFER, buffer, NULL);
+  gst_buffer_unref (buffer);
+}
+
+static void
+suite_teardown (void)
+{
+  gst_structure_free (wave);
+  gst_buzztrax_teardown ();
+}
+
+//-- helper
+
+static GstStructure *
+get_wave_buffer (gpointer user_data, guint wave_ix, guint wave_level_ix)
+{
+  return wave;
+}
+
+/* the voices are still in the attack phase when they are stolen, thus the
+ * voice started last is the quietest */
+static GstElement *
+make_wave_tab_syn (void)
+{
+  GstElement *synth = gst_element_factory_make ("wavetabsyn", NULL);
+
+  g_object_set (synth, "children", NUM_VOICES, "wave-callbacks",
+      wave_callbacks, "attack", 4.0, "length", 16, NULL);
+  ((GstBtAudioSynth *) synth)->channels = 1;
+  return synth;
+}
+
+static gboolean
+render_buffer (GstElement * synth)
+{
+  GstBtAudioSynth *base = (GstBtAudioSynth *) synth;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gboolean res;
+
+  buffer = gst_buffer_new_allocate (NULL,
+      base->generate_samples_per_buffer * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  res = GSTBT_AUDIO_SYNTH_GET_CLASS (base)->process (base, buffer, &info);
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+  return res;
+}
+
+/* the note that is queued on voice @i */
+static GstBtNote
+get_pending_note (GstElement * synth, guint i)
+{
+  GstBtWaveTabSynV *voice = (GstBtWaveTabSynV *)
+      gst_child_proxy_get_child_by_index (GST_CHILD_PROXY (synth), i);
+  GstBtNote note;
+
+  fail_unless (voice != NULL, NULL);
+  note = voice->pending;
+  gst_object_unref (voice);
+  return note;
+}
+
+/* play a note on each voice, one buffer apart */
+static void
+play_notes_on_all_voices (GstElement * synth)
+{
+  guint i;
+
+  for (i = 0; i < NUM_VOICES; i++) {
+    g_object_set (synth, "note", GSTBT_NOTE_C_3 + i, NULL);
+    fail_unless (render_buffer (synth), NULL);
+  }
+}
+
+//-- tests
+
+START_TEST (test_notes_use_free_voices)
+{
+  GstElement *synth = make_wave_tab_syn ();
+  guint i, j;
+
+  for (i = 0; i < NUM_VOICES; i++) {
+    g_object_set (synth, "note", GSTBT_NOTE_C_3 + i, NULL);
+    for (j = 0; j < NUM_VOICES; j++) {
+      ck_assert_int_eq (get_pending_note (synth, j),
+          (i == j) ? GSTBT_NOTE_C_3 + i : GSTBT_NOTE_NONE);
+    }
+    /* starts the note */
+    fail_unless (render_buffer (synth), NULL);
+    ck_assert_int_eq (get_pending_note (synth, i), GSTBT_NOTE_NONE);
+  }
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+START_TEST (test_oldest_voice_is_stolen)
+{
+  GstElement *synth = make_wave_tab_syn ();
+
+  g_object_set (synth, "voice-stealing", GSTBT_WAVE_TAB_SYN_STEAL_OLDEST,
+      NULL);
+  play_notes_on_all_voices (synth);
+
+  g_object_set (synth, "note", GSTBT_NOTE_C_4, NULL);
+  ck_assert_int_eq (get_pending_note (synth, 0), GSTBT_NOTE_C_4);
+  fail_unless (render_buffer (synth), NULL);
+  /* the restarted voice is the newest now */
+  g_object_set (synth, "note", GSTBT_NOTE_D_4, NULL);
+  ck_assert_int_eq (get_pending_note (synth, 1), GSTBT_NOTE_D_4);
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+START_TEST (test_quietest_voice_is_stolen)
+{
+  GstElement *synth = make_wave_tab_syn ();
+
+  g_object_set (synth, "voice-stealing", GSTBT_WAVE_TAB_SYN_STEAL_QUIETEST,
+      NULL);
+  play_notes_on_all_voices (synth);
+
+  g_object_set (synth, "note", GSTBT_NOTE_C_4, NULL);
+  ck_assert_int_eq (get_pending_note (synth, NUM_VOICES - 1), GSTBT_NOTE_C_4);
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+START_TEST (test_finished_voice_is_reused)
+{
+  GstElement *synth = make_wave_tab_syn ();
+  guint i;
+
+  g_object_set (synth, "attack", 0.001, "decay", 0.001, "release", 0.001,
+      "length", 1, "note", GSTBT_NOTE_C_3, NULL);
+  /* the envelope ends within the note length */
+  for (i = 0; i < 3; i++) {
+    render_buffer (synth);
+  }
+
+  g_object_set (synth, "note", GSTBT_NOTE_D_3, NULL);
+  ck_assert_int_eq (get_pending_note (synth, 0), GSTBT_NOTE_D_3);
+
+  gst_object_unref (synth);
+}
+
+END_TEST;
+
+TCase *
+gst_buzztrax_wave_tab_syn_test_case (void)
+{
+  TCase *tc = tcase_create ("GstBtWaveTabSynTests");
+
+  tcase_add_test (tc, test_notes_use_free_voices);
+  tcase_add_test (tc, test_oldest_voice_is_stolen);
+  tcase_add_test (tc, test_quietest_voice_is_stolen);
+  tcase_add_test (tc, test_finished_voice_is_reused);
+  tcase_add_unchecked_fixture (tc, suite_setup, suite_teardown);
+  return (tc);
+}